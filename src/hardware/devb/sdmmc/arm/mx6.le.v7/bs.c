@@ -29,6 +29,7 @@
 #include <hw/inout.h>
 #include <arm/mx6x.h>
 #include <imx6.h>
+#include <emu.h>
 #include <bs.h>
 
 /* Update write protect status */
@@ -428,10 +429,17 @@ int bs_event(sdio_hc_t *hc, sdio_event_t *ev) {
 
 sdio_product_t	sdio_fs_products[] = {
 	{ SDIO_DEVICE_ID_WILDCARD, 0, 0, "imx6", imx6_init },
+	{ 0, 0, 0, NULL, NULL }
+};
+
+sdio_product_t	sdio_emu_products[] = {
+	{ SDIO_DEVICE_ID_WILDCARD, 0, 0, "emu", emu_init },
+	{ 0, 0, 0, NULL, NULL }
 };
 
 sdio_vendor_t	sdio_vendors[] = {
 	{ SDIO_VENDOR_ID_WILDCARD, "Freescale", sdio_fs_products },
+	{ SDIO_VENDOR_ID_WILDCARD, "Emulator", sdio_emu_products },
 	{ 0, NULL, NULL }
 };
 
@@ -30,6 +30,7 @@
 
 // add new chipset externs here
 #define SDIO_HC_IMX6
+#define SDIO_HC_EMU
 
 #define SDIO_SOC_SUPPORT
 #define ADMA_SUPPORTED			1
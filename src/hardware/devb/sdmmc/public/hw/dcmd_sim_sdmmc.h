@@ -189,6 +189,8 @@ typedef struct _sdmmc_device_info {
 #define DEV_CAP_CACHE			(1 << 15)
 #define DEV_CAP_HS400			(1 << 16)	/* high speed 400 */
 #define DEV_CAP_PWROFF_NOTIFY		(1 << 17)	/* power off notify supported */
+#define DEV_CAP_CMDQ			(1 << 18)	/* command queuing supported */
+#define DEV_CAP_PACKED			(1 << 19)	/* packed commands supported */
 	_Uint64t			caps;
 
 	_Uint32t			dtr;			/* current data transfer rate */
@@ -341,6 +343,52 @@ typedef struct _sdmmc_pwr_mgnt {
 	_Uint32t		rsvd1[16];
 } SDMMC_PWR_MGNT;
 
+	/* latency histogram, bucket 0 is < 64us, bucket n is [32us << n, 64us << n), the last is open ended */
+#define SDMMC_IOS_BUCKETS		16
+typedef struct _sdmmc_io_hist {
+	_Uint64t		cnt;				/* Completed requests */
+	_Uint64t		blks;				/* Sectors transferred */
+	_Uint64t		total_ns;			/* Sum of latencies */
+	_Uint64t		max_ns;				/* Longest latency */
+	_Uint32t		bucket[SDMMC_IOS_BUCKETS];
+} SDMMC_IO_HIST;
+
+typedef struct _sdmmc_io_time {
+	_Uint64t		cnt;
+	_Uint64t		total_ns;
+	_Uint64t		max_ns;
+} SDMMC_IO_TIME;
+
+typedef struct _sdmmc_io_stats {
+#define SDMMC_IOS_ACTION_GET	0x00
+#define SDMMC_IOS_ACTION_CLR	0x01	/* Get, then clear the partition and device counters */
+	_Uint32t		action;
+	_Uint32t		rsvd;
+
+	_Uint32t		ptype;				/* SDMMC_PTYPE_* */
+	_Uint32t		qdepth_max;			/* Most ccbs in the CAM queue when one for this partition was dispatched */
+	_Uint64t		qdepth_sum;			/* Sum of the same, / qwait.cnt for the average */
+	_Uint64t		elapsed_ns;			/* Time since the device counters were cleared */
+
+		/* Per partition, latency of the transfer on the host/card, by transfer size */
+#define SDMMC_IOS_SIZE_4K		0
+#define SDMMC_IOS_SIZE_16K		1
+#define SDMMC_IOS_SIZE_64K		2
+#define SDMMC_IOS_SIZE_256K		3
+#define SDMMC_IOS_SIZE_LARGE	4
+#define SDMMC_IOS_SIZES			5
+	SDMMC_IO_HIST	rd[SDMMC_IOS_SIZES];
+	SDMMC_IO_HIST	wr[SDMMC_IOS_SIZES];
+	SDMMC_IO_HIST	qwait;				/* Per partition, time read/write ccbs waited in the CAM queue */
+
+		/* Per device, time the bus was held by maintenance rather than I/O */
+	SDMMC_IO_TIME	bkops;				/* Background operations started by the driver */
+	SDMMC_IO_TIME	flush;				/* Cache flushes */
+	SDMMC_IO_TIME	tune;				/* Host tuning (max_ns is not cleared) */
+	SDMMC_IO_TIME	reset;				/* Host/device resets after errors */
+	_Uint32t		rsvd1[32];
+} SDMMC_IO_STATS;
+
 #define DCMD_SDMMC_DEVICE_INFO			__DIOF(_DCMD_CAM, _SIM_SDMMC + 0, struct _sdmmc_device_info)
 #define DCMD_SDMMC_DEVICE_HEALTH		__DIOF(_DCMD_CAM, _SIM_SDMMC + 1, union _sdmmc_device_health)
 #define DCMD_SDMMC_ERASE 			  	__DIOTF(_DCMD_CAM, _SIM_SDMMC + 2, struct _sdmmc_erase)
@@ -353,6 +401,7 @@ typedef struct _sdmmc_pwr_mgnt {
 #define DCMD_SDMMC_LOCK_UNLOCK			__DIOT(_DCMD_CAM, _SIM_SDMMC + 9, struct _sdmmc_lock_unlock)
 #define DCMD_SDMMC_PART_INFO			__DIOTF(_DCMD_CAM, _SIM_SDMMC + 10, struct _sdmmc_partition_info)
 #define DCMD_SDMMC_PWR_MGNT				__DIOTF(_DCMD_CAM, _SIM_SDMMC + 11, struct _sdmmc_pwr_mgnt)
+#define DCMD_SDMMC_IO_STATS				__DIOTF(_DCMD_CAM, _SIM_SDMMC + 12, struct _sdmmc_io_stats)
 
 #include <_packpop.h>
 
@@ -672,14 +672,32 @@ int sdio_select_voltage( sdio_hc_t *hc, int ocr )
 
 int sdio_tune( sdio_hc_t *hc, int cmd )
 {
-	int	status;
+	int				status;
+	uint64_t		ns;
+	struct timespec	ts;
 
 	status = EOK;
 
 	sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 1, "%s:", __FUNCTION__ );
 
 	if( hc->entry.tune ) {
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		ns = timespec2nsec( &ts );
+
 		status = hc->entry.tune( hc, cmd );
+
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		ns = timespec2nsec( &ts ) - ns;
+
+			// reported through sdio_hc_info() so clients can see time lost to (re)tuning
+		hc->tuning_cnt++;
+		hc->tuning_ns += ns;
+		if( ns > hc->tuning_max_ns ) {
+			hc->tuning_max_ns = ns;
+		}
+		if( status ) {
+			hc->tuning_err++;
+		}
 	}
 
 	return( status );
@@ -901,12 +919,17 @@ int _sdio_wait_card_status( sdio_dev_t *dev, uint32_t *rsp, uint32_t mask, uint3
 	sdio_hc_t	*hc;
 	int			status;
 	uint32_t	resp[4];
+	uint64_t	tmo;
+	uint64_t	elapsed;
+	uint64_t	ival;
 
 	hc		= dev->hc;
 	status	= EOK;
 	rsp		= rsp ? rsp : resp;
+	tmo		= SDIO_TIMEOUT_MS_TO_NS( max( msec, 1 ) );
 
-	for( msec = max( msec, 1 ); msec; msec-- ) {
+		// back off exponentially so long programming times don't cost a poll per ms
+	for( elapsed = 0, ival = SDIO_BSY_POLL_MIN_NS; ; elapsed += ival, ival = min( ival * 2, SDIO_BSY_POLL_MAX_NS ) ) {
 		if( ( status = _sdio_send_status( dev, rsp, SDIO_FALSE ) ) != EOK ) {
 			break;
 		}
@@ -923,10 +946,20 @@ int _sdio_wait_card_status( sdio_dev_t *dev, uint32_t *rsp, uint32_t mask, uint3
 			status = EOK; break;
 		}
 
-		delay( 1 );
+		if( elapsed >= tmo ) {
+			break;
+		}
+
+		if( ival < SDIO_BSY_POLL_SPIN_NS ) {
+			nanospin_ns( ival );
+		}
+		else {
+			ival = max( ival, SDIO_TIMEOUT_MS_TO_NS( 1 ) );
+			delay( ival / SDIO_TIMEOUT_MS_TO_NS( 1 ) );
+		}
 	}
 
-	if( !msec ) {
+	if( elapsed >= tmo ) {
 		sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s:  mask %x, val %x, card status %x", __FUNCTION__, mask, val, rsp[0] );
 		sdio_rsp( dev, rsp );
 		status = ETIMEDOUT;
@@ -1169,6 +1202,9 @@ int sdio_issue_cmd( sdio_dev_t *dev, struct sdio_cmd *cmd, uint64_t tms )
 	pthread_mutex_unlock( &hc->mutex );
 
 	if( ( status = hc->entry.cmd( hc, cmd ) ) == EOK ) {
+		if( cmd->next && hc->entry.prep ) {
+			hc->entry.prep( hc, cmd->next );
+		}
 		status = sdio_wait_cmd( hc, cmd, tms );
 	}
 
@@ -1234,6 +1270,11 @@ int _sdio_send_cmd( sdio_dev_t *dev, struct sdio_cmd *cmd,
 				break;
 			}
 		}
+		else if( ( cmd->flags & SCF_PACKED ) ) {		// auto cmd23 can't carry the packed flag
+			if( ( status = _sdio_set_block_count( dev, cmd->blks | MMC_SBC_PACKED ) ) ) {
+				break;
+			}
+		}
 
 		if( ( status = sdio_issue_cmd( dev, cmd, timeout ) ) != EOK ) {
 			if( ( dev->flags & DEV_FLAG_PRESENT ) ) {
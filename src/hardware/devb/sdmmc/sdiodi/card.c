@@ -184,6 +184,14 @@ int sdio_setup_cmd_io( struct sdio_cmd *cmd, uint32_t flgs, int blks, int blksz,
 	return( EOK );
 }
 
+// next is issued after cmd, the hc may prepare its data transfer while cmd is on the bus
+int sdio_setup_cmd_next( struct sdio_cmd *cmd, struct sdio_cmd *next )
+{
+	cmd->next		= next;
+
+	return( EOK );
+}
+
 int sdio_send_cmd( struct sdio_device *device, struct sdio_cmd *cmd,
 		void (*func)( struct sdio_device *, struct sdio_cmd *, void *),
 		uint32_t timeout, int retries )
@@ -345,7 +353,7 @@ int sdio_hc_info( struct sdio_device *device, sdio_hc_info_t *info )
 
 	hc					= device->dev->hc;
 
-	info->caps			= hc->caps & 0xffffffff;
+	info->caps			= hc->caps & ( 0xffffffff | HC_CAP_BSY_DATA );
 	info->sg_max		= hc->cfg.sg_max;
 	info->dtr_max		= hc->clk_max;
 	info->dtr			= hc->clk;
@@ -353,6 +361,10 @@ int sdio_hc_info( struct sdio_device *device, sdio_hc_info_t *info )
 	info->bus_width		= hc->bus_width;
 	info->idle_time		= hc->cfg.idle_time;
 	info->sleep_time	= hc->cfg.sleep_time;
+	info->tune_cnt		= hc->tuning_cnt;
+	info->tune_err		= hc->tuning_err;
+	info->tune_ns		= hc->tuning_ns;
+	info->tune_max_ns	= hc->tuning_max_ns;
 	strcpy( info->name, hc->cfg.name );
 
 	return( EOK );
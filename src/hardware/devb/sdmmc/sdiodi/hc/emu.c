@@ -0,0 +1,1044 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2013, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+// Module Description:	eMMC device and host controller emulator
+//
+// The emulator sits behind the sdio_hc_entry_t interface, in place of a
+// real host controller, and answers commands from a software model of an
+// eMMC 5.1 device.  Everything above it (sdiodi, sim_sdmmc, io-blk) runs
+// unmodified, so queueing, merging and packing changes can be exercised
+// and timed on a target without a card.  Data is kept in a file or in
+// anonymous memory, command/transfer/program latencies are configurable.
+//
+//	sdio hc=emu,bs=file=/tmp/emmc.img:size=256:prog=400
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <gulliver.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <internal.h>
+
+#ifdef SDIO_HC_EMU
+#include <emu.h>
+
+// inverse of sdio_extract_bits(), data[0] holds bits 127:96
+static void emu_set_bits( uint32_t *data, int start, int size, uint32_t value )
+{
+	int		bit;
+
+	for( bit = 0; bit < size; bit++, start++ ) {
+		if( ( value & ( 1u << bit ) ) ) {
+			data[3 - start / 32] |= 1u << ( start & 31 );
+		}
+	}
+}
+
+static int emu_args( sdio_hc_t *hc, char *options )
+{
+	emu_hc_t		*emu;
+	char			*value;
+	char			*opt;
+	char			*ptr;
+	int				status;
+	static char		*opts[] = {
+#define EMU_OPT_FILE		0
+			"file",			// backing file, created if it doesn't exist
+#define EMU_OPT_SIZE		1
+			"size",			// device size (MB)
+#define EMU_OPT_CMD			2
+			"cmd",			// command latency (us)
+#define EMU_OPT_RACC		3
+			"racc",			// read access latency (us)
+#define EMU_OPT_RD			4
+			"rd",			// per block read (us)
+#define EMU_OPT_WR			5
+			"wr",			// per block write (us)
+#define EMU_OPT_PROG		6
+			"prog",			// program busy per write (us)
+#define EMU_OPT_FLUSH		7
+			"flush",		// cache flush (us)
+#define EMU_OPT_ERASE		8
+			"erase",		// erase/trim/discard/bkops (us)
+#define EMU_OPT_SPIN		9
+			"spin",			// spin latencies up to (us)
+#define EMU_OPT_NOBSY		10
+			"~bsy",			// don't signal data busy, driver polls CMD13
+			NULL };
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	status	= EOK;
+
+	if( options == NULL || ( opt = ptr = strdup( options ) ) == NULL ) {
+		return( options == NULL ? EOK : ENOMEM );
+	}
+
+		// bs options are colon separated
+	for( value = ptr; ( value = strchr( value, ':' ) ) != NULL; ) {
+		*value = ',';
+	}
+
+	while( *ptr != '\0' && status == EOK ) {
+		switch( getsubopt( &ptr, opts, &value ) ) {
+			case EMU_OPT_FILE:
+				if( value == NULL || ( emu->file = strdup( value ) ) == NULL ) {
+					status = EINVAL;
+				}
+				break;
+
+			case EMU_OPT_SIZE:
+				if( value == NULL || ( emu->size = strtoul( value, NULL, 0 ) ) == 0 ) {
+					status = EINVAL;
+				}
+				break;
+
+			case EMU_OPT_CMD:
+				if( value ) emu->cmd_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_RACC:
+				if( value ) emu->racc_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_RD:
+				if( value ) emu->rd_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_WR:
+				if( value ) emu->wr_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_PROG:
+				if( value ) emu->prog_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_FLUSH:
+				if( value ) emu->flush_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_ERASE:
+				if( value ) emu->erase_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_SPIN:
+				if( value ) emu->spin_ns = strtoul( value, NULL, 0 ) * 1000;
+				break;
+
+			case EMU_OPT_NOBSY:
+				emu->flags |= EMU_FLAG_NOBSY_DATA;
+				break;
+
+			default:
+				sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s: invalid option %s", __FUNCTION__, value );
+				status = EINVAL;
+				break;
+		}
+	}
+
+	free( opt );
+
+	return( status );
+}
+
+static void emu_card_reset( emu_card_t *card )
+{
+	card->state						= CDS_CUR_STATE_IDLE;
+	card->rca						= 0;
+	card->sbc						= 0;
+	card->err						= 0;
+	card->busy_end					= 0;
+	card->ecsd[ECSD_BUS_WIDTH]		= ECSD_BUS_WIDTH_1;
+	card->ecsd[ECSD_HS_TIMING]		= ECSD_HS_TIMING_LS;
+	card->ecsd[ECSD_CMDQ_MODE_EN]	= 0;
+	card->ecsd[ECSD_PART_CONFIG]	&= ~ECSD_PC_ACCESS_MSK;
+	memset( card->tasks, 0, sizeof( card->tasks ) );
+}
+
+static int emu_card_init( sdio_hc_t *hc )
+{
+	emu_hc_t		*emu;
+	emu_card_t		*card;
+	uint8_t			*ecsd;
+	struct stat		st;
+	uint64_t		size;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	card	= &emu->card;
+	ecsd	= card->ecsd;
+	card->fd	= -1;
+	card->mem	= MAP_FAILED;
+
+	if( emu->file ) {
+		if( ( card->fd = open( emu->file, O_RDWR | O_CREAT, 0644 ) ) == -1 ) {
+			sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s: open %s (%s)", __FUNCTION__, emu->file, strerror( errno ) );
+			return( errno );
+		}
+
+		if( !emu->size && fstat( card->fd, &st ) == 0 ) {
+			emu->size = st.st_size / ( 1024 * 1024 );
+		}
+	}
+
+	if( !emu->size ) {
+		emu->size = EMU_SIZE_DFLT;
+	}
+
+	size			= (uint64_t)emu->size * 1024 * 1024;
+	card->sectors	= size / EMU_SECTOR_SIZE;
+	card->hcap		= card->sectors > ECSD_SEC_CNT_2GB;
+
+	if( card->fd != -1 ) {
+		if( ftruncate( card->fd, size ) == -1 ) {
+			sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s: ftruncate %s (%s)", __FUNCTION__, emu->file, strerror( errno ) );
+			return( errno );
+		}
+	}
+	else if( ( card->mem = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, NOFD, 0 ) ) == MAP_FAILED ) {
+		sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s: mmap %uMB (%s)", __FUNCTION__, emu->size, strerror( errno ) );
+		return( errno );
+	}
+
+		// CID, spec 4.x layout
+	emu_set_bits( card->cid, 120, 8, 0xfe );				// mid
+	emu_set_bits( card->cid, 112, 2, 0x01 );				// BGA
+	emu_set_bits( card->cid, 104, 8, 0x00 );				// oid
+	emu_set_bits( card->cid, 96, 8, 'Q' );					// pnm
+	emu_set_bits( card->cid, 88, 8, 'E' );
+	emu_set_bits( card->cid, 80, 8, 'M' );
+	emu_set_bits( card->cid, 72, 8, 'M' );
+	emu_set_bits( card->cid, 64, 8, 'C' );
+	emu_set_bits( card->cid, 56, 8, '0' );
+	emu_set_bits( card->cid, 48, 8, 0x10 );					// prv
+	emu_set_bits( card->cid, 16, 32, 0x00000001 );			// psn
+	emu_set_bits( card->cid, 12, 4, 1 );					// month
+	emu_set_bits( card->cid, 8, 4, 0 );						// year
+
+		// CSD, capacity comes from EXT_CSD SEC_COUNT
+	emu_set_bits( card->csd, 126, 2, CSD_STRUCT_VER_EXT_CSD );
+	emu_set_bits( card->csd, 122, 4, CSD_SPEC_VER_4 );
+	emu_set_bits( card->csd, 112, 8, 0x27 );				// taac
+	emu_set_bits( card->csd, 104, 8, 0x01 );				// nsac
+	emu_set_bits( card->csd, 96, 8, 0x32 );					// tran_speed 26MHz
+	emu_set_bits( card->csd, 84, 12, 0x8f5 );				// ccc
+	emu_set_bits( card->csd, 80, 4, 9 );					// read_bl_len
+	emu_set_bits( card->csd, 62, 12, card->hcap ? 0xfff : min( card->sectors / 512, 0x1000 ) - 1 );
+	emu_set_bits( card->csd, 47, 3, 7 );					// c_size_mult
+	emu_set_bits( card->csd, 42, 5, 0x1f );					// erase_grp_size
+	emu_set_bits( card->csd, 37, 5, 0x1f );					// erase_grp_mult
+	emu_set_bits( card->csd, 32, 7, 0x0f );					// wp_grp_size
+	emu_set_bits( card->csd, 26, 3, 2 );					// r2w_factor
+	emu_set_bits( card->csd, 22, 4, 9 );					// write_bl_len
+
+	ecsd[ECSD_REV]						= ECSD_REV_V5_1;
+	ecsd[EMU_ECSD_CSD_STRUCTURE]		= CSD_STRUCT_VER_12;
+	ecsd[ECSD_CARD_TYPE]				= ECSD_CARD_TYPE_52 | ECSD_CARD_TYPE_26;
+	ecsd[ECSD_SEC_CNT + 0]				= card->sectors >> 0;
+	ecsd[ECSD_SEC_CNT + 1]				= card->sectors >> 8;
+	ecsd[ECSD_SEC_CNT + 2]				= card->sectors >> 16;
+	ecsd[ECSD_SEC_CNT + 3]				= card->sectors >> 24;
+	ecsd[ECSD_S_A_TIMEOUT]				= 0x10;
+	ecsd[ECSD_OUT_OF_INTERRUPT_TIME]	= 1;
+	ecsd[ECSD_PARTITION_SWITCH_TIME]	= 1;
+	ecsd[ECSD_POWER_OFF_LONG_TIME]		= 1;
+	ecsd[ECSD_HC_WP_GRP_SIZE]			= 1;
+	ecsd[ECSD_ERASE_GRP_SIZE]			= 1;
+	ecsd[ECSD_ERASE_MULT]				= 1;
+	ecsd[ECSD_TRIM_MULT]				= 1;
+	ecsd[ECSD_SEC_TRIM_MULT]			= 1;
+	ecsd[ECSD_SEC_ERASE_MULT]			= 1;
+	ecsd[ECSD_ACC_SIZE]					= 6;
+	ecsd[ECSD_SEC_FEATURE_SUPPORT]		= ECSD_SEC_GB_CL_EN;
+	ecsd[ECSD_DRIVER_STRENGTH]			= 0x1;
+	ecsd[ECSD_BKOPS_SUPPORTED]			= 1;
+	ecsd[ECSD_CACHE_SIZE + 1]			= 0x04;				// 1MB
+	ecsd[ECSD_CMDQ_SUPPORT]				= ECSD_CMDQ_SUP;
+	ecsd[ECSD_CMDQ_DEPTH]				= EMU_CMDQ_DEPTH - 1;
+	ecsd[ECSD_MAX_PACKED_WRITES]		= EMU_PACKED_WR_MAX;
+	ecsd[ECSD_MAX_PACKED_READS]			= EMU_PACKED_RD_MAX;
+
+	emu_card_reset( card );
+
+	return( EOK );
+}
+
+// R1 status, the card reports PRG while a program is in progress and
+// any write errors once it is done, clearing them as it does
+static uint32_t emu_card_status( emu_card_t *card )
+{
+	uint32_t	err;
+
+	if( card->busy_end && _syspage_time( CLOCK_MONOTONIC ) < card->busy_end ) {
+		return( CDS_CUR_STATE_PRG );
+	}
+
+	card->busy_end	= 0;
+	err				= card->err;
+	card->err		= 0;
+
+	return( card->state | CDS_READY_FOR_DATA | err );
+}
+
+// Write errors are found while the data is programmed, after the R1 of
+// the write went out, so they are only seen in the next status
+static int emu_wr_err( emu_card_t *card, uint32_t err )
+{
+	card->err |= err;
+
+	return( CS_CMD_CMP );
+}
+
+static void *emu_map( sdio_cmd_t *cmd, uint64_t addr, int len, int *off )
+{
+	void		*vaddr;
+	long		pgsz;
+
+	*off = 0;
+	if( !( cmd->flags & SCF_DATA_PHYS ) ) {
+		return( SDIO_DATA_PTR_V( addr ) );
+	}
+
+	pgsz = sysconf( _SC_PAGESIZE );
+	*off = addr & ( pgsz - 1 );
+	if( ( vaddr = mmap_device_memory( NULL, len + *off, PROT_READ | PROT_WRITE | PROT_NOCACHE, 0, addr - *off ) ) == MAP_FAILED ) {
+		return( NULL );
+	}
+
+	return( (uint8_t *)vaddr + *off );
+}
+
+static void emu_unmap( sdio_cmd_t *cmd, void *vaddr, int len, int off )
+{
+	if( ( cmd->flags & SCF_DATA_PHYS ) ) {
+		munmap_device_memory( (uint8_t *)vaddr - off, len + off );
+	}
+}
+
+static int emu_store( emu_card_t *card, int dir, uint64_t soff, uint8_t *addr, int len )
+{
+	ssize_t		nbytes;
+
+	if( card->fd == -1 ) {
+		if( dir == SCF_DIR_IN ) {
+			memcpy( addr, card->mem + soff, len );
+		}
+		else {
+			memcpy( card->mem + soff, addr, len );
+		}
+		return( EOK );
+	}
+
+	nbytes = ( dir == SCF_DIR_IN ) ? pread( card->fd, addr, len, soff ) : pwrite( card->fd, addr, len, soff );
+
+	return( nbytes == len ? EOK : EIO );
+}
+
+// Move len bytes of the command's data, starting *xoff bytes into its
+// sg list, to/from buf or, with no buf, the device storage at soff.
+static int emu_xfer( sdio_cmd_t *cmd, emu_card_t *card, uint32_t *xoff, uint8_t *buf, uint64_t soff, uint32_t len )
+{
+	sdio_sge_t	*sge;
+	uint8_t		*addr;
+	uint32_t	skip;
+	int			dir;
+	int			cnt;
+	int			off;
+	int			idx;
+	int			status;
+
+	dir		= cmd->flags & SCF_DATA_MSK;
+	skip	= *xoff;
+	status	= EOK;
+
+	for( idx = 0, sge = cmd->sgl; len && idx < cmd->sgc; idx++, sge++ ) {
+		if( skip >= sge->sg_count ) {
+			skip -= sge->sg_count;
+			continue;
+		}
+
+		cnt = min( sge->sg_count - skip, len );
+		if( ( addr = emu_map( cmd, sge->sg_address + skip, cnt, &off ) ) == NULL ) {
+			return( errno );
+		}
+
+		if( buf == NULL ) {
+			status = emu_store( card, dir, soff, addr, cnt );
+			soff	+= cnt;
+		}
+		else {
+			if( dir == SCF_DIR_IN ) {
+				memcpy( addr, buf, cnt );
+			}
+			else {
+				memcpy( buf, addr, cnt );
+			}
+			buf		+= cnt;
+		}
+
+		emu_unmap( cmd, addr, cnt, off );
+
+		if( status != EOK ) {
+			return( status );
+		}
+
+		*xoff	+= cnt;
+		len		-= cnt;
+		skip	= 0;
+	}
+
+	return( len ? EINVAL : EOK );
+}
+
+// program time, written through or held in the volatile cache until flushed
+static uint64_t emu_prog( emu_hc_t *emu )
+{
+	emu_card_t		*card;
+
+	card = &emu->card;
+
+	if( ( card->ecsd[ECSD_CACHE_CTRL] & ECSD_CACHE_CTRL_EN ) ) {
+		card->dirty_ns += emu->prog_ns;
+		return( 0 );
+	}
+
+	return( emu->prog_ns );
+}
+
+static int emu_rw( sdio_hc_t *hc, sdio_cmd_t *cmd, uint32_t addr, uint32_t blks, uint64_t *ns )
+{
+	emu_hc_t		*emu;
+	emu_card_t		*card;
+	uint32_t		xoff;
+	uint64_t		prog;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	card	= &emu->card;
+	xoff	= 0;
+
+	if( !card->hcap ) {
+		addr /= EMU_SECTOR_SIZE;
+	}
+
+	if( addr >= card->sectors || blks > card->sectors - addr ) {
+		if( ( cmd->flags & SCF_DIR_OUT ) ) {
+			return( emu_wr_err( card, CDS_OUT_OF_RANGE ) );
+		}
+		cmd->rsp[0] |= CDS_OUT_OF_RANGE;
+		return( CS_CMD_CMP_ERR );
+	}
+
+	if( emu_xfer( cmd, card, &xoff, NULL, (uint64_t)addr * EMU_SECTOR_SIZE, blks * EMU_SECTOR_SIZE ) != EOK ) {
+		cmd->rsp[0] |= CDS_ERROR;
+		return( CS_DATA_END_ERR );
+	}
+
+	if( ( cmd->flags & SCF_DIR_IN ) ) {
+		*ns += emu->racc_ns + (uint64_t)blks * emu->rd_ns;
+		emu->stats.rd_cmds++;
+		emu->stats.rd_blks += blks;
+		return( CS_CMD_CMP );
+	}
+
+	*ns		+= (uint64_t)blks * emu->wr_ns;
+	prog	= emu_prog( emu );
+	emu->stats.wr_cmds++;
+	emu->stats.wr_blks += blks;
+
+	if( ( emu->flags & EMU_FLAG_NOBSY_DATA ) ) {
+		card->busy_end = _syspage_time( CLOCK_MONOTONIC ) + *ns + prog;
+	}
+	else {
+		*ns += prog;
+	}
+
+	return( CS_CMD_CMP );
+}
+
+// Packed write, the first block is the header listing each write
+static int emu_rw_packed( sdio_hc_t *hc, sdio_cmd_t *cmd, uint64_t *ns )
+{
+	emu_hc_t		*emu;
+	emu_card_t		*card;
+	uint32_t		hdr[EMU_SECTOR_SIZE / sizeof( uint32_t )];
+	uint32_t		xoff;
+	uint32_t		blks;
+	uint32_t		addr;
+	uint32_t		nblks;
+	int				nentries;
+	int				idx;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	card	= &emu->card;
+	xoff	= 0;
+
+	card->ecsd[ECSD_PACKED_CMD_STATUS]		= 0;
+	card->ecsd[ECSD_PACKED_FAILURE_INDEX]	= 0;
+	card->ecsd[ECSD_EXP_EVENTS_STATUS]		&= ~ECSD_EXP_PACKED_FAILURE;
+
+	if( !( cmd->flags & SCF_DIR_OUT ) || emu_xfer( cmd, card, &xoff, (uint8_t *)hdr, 0, sizeof( hdr ) ) != EOK ) {
+		cmd->rsp[0] |= CDS_ERROR;
+		return( CS_CMD_CMP_ERR );
+	}
+
+	nentries = ( ENDIAN_LE32( hdr[0] ) >> 16 ) & 0xff;
+	if( ENDIAN_LE32( hdr[0] ) != MMC_PACKED_HDR( nentries, MMC_PACKED_CMD_WRITE ) ||
+			!nentries || nentries > card->ecsd[ECSD_MAX_PACKED_WRITES] ) {
+		card->ecsd[ECSD_PACKED_CMD_STATUS]	= ECSD_PCS_ERROR;
+		card->ecsd[ECSD_EXP_EVENTS_STATUS]	|= ECSD_EXP_PACKED_FAILURE;
+		return( emu_wr_err( card, CDS_ERROR ) );
+	}
+
+	for( idx = 0, nblks = 1; idx < nentries; idx++ ) {
+		blks	= ENDIAN_LE32( hdr[( idx + 1 ) * 2] );
+		addr	= ENDIAN_LE32( hdr[( idx + 1 ) * 2 + 1] );
+
+		if( !card->hcap ) {
+			addr /= EMU_SECTOR_SIZE;
+		}
+
+		if( nblks + blks > cmd->blks || addr >= card->sectors || blks > card->sectors - addr ||
+				emu_xfer( cmd, card, &xoff, NULL, (uint64_t)addr * EMU_SECTOR_SIZE, blks * EMU_SECTOR_SIZE ) != EOK ) {
+			card->ecsd[ECSD_PACKED_CMD_STATUS]		= ECSD_PCS_ERROR | ECSD_PCS_INDEXED_ERROR;
+			card->ecsd[ECSD_PACKED_FAILURE_INDEX]	= idx + 1;
+			card->ecsd[ECSD_EXP_EVENTS_STATUS]		|= ECSD_EXP_PACKED_FAILURE;
+			return( emu_wr_err( card, CDS_ERROR ) );
+		}
+
+		nblks += blks;
+	}
+
+		// one program busy for the whole pack
+	*ns += (uint64_t)cmd->blks * emu->wr_ns + emu_prog( emu );
+	emu->stats.packed++;
+	emu->stats.wr_cmds++;
+	emu->stats.wr_blks += nblks - 1;
+
+	return( CS_CMD_CMP );
+}
+
+static int emu_switch( sdio_hc_t *hc, sdio_cmd_t *cmd, uint64_t *ns )
+{
+	emu_hc_t		*emu;
+	emu_card_t		*card;
+	uint32_t		mode;
+	uint32_t		index;
+	uint32_t		value;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	card	= &emu->card;
+	mode	= ( cmd->arg >> 24 ) & 0x3;
+	index	= ( cmd->arg >> 16 ) & 0xff;
+	value	= ( cmd->arg >> 8 ) & 0xff;
+
+	if( mode == MMC_SWITCH_MODE_CMD_SET || index >= ECSD_REV ) {
+		cmd->rsp[0] |= CDS_SWITCH_ERROR;
+		return( CS_CMD_CMP );
+	}
+
+	switch( mode ) {
+		case MMC_SWITCH_MODE_SET:
+			value = card->ecsd[index] | value;
+			break;
+
+		case MMC_SWITCH_MODE_CLR:
+			value = card->ecsd[index] & ~value;
+			break;
+
+		default:
+			break;
+	}
+
+	switch( index ) {
+		case ECSD_FLUSH_CACHE:				// triggers, not stored
+			if( ( value & ECSD_FLUSH_TRIGGER ) ) {
+				*ns				+= emu->flush_ns + card->dirty_ns;
+				card->dirty_ns	= 0;
+				emu->stats.flushes++;
+			}
+			return( CS_CMD_CMP );
+
+		case ECSD_BKOPS_START:
+		case ECSD_SANITIZE_START:
+			*ns += emu->erase_ns;
+			return( CS_CMD_CMP );
+
+		case ECSD_CACHE_CTRL:
+			if( !( value & ECSD_CACHE_CTRL_EN ) ) {
+				*ns				+= card->dirty_ns;
+				card->dirty_ns	= 0;
+			}
+			break;
+
+		case ECSD_CMDQ_MODE_EN:
+			memset( card->tasks, 0, sizeof( card->tasks ) );
+			break;
+
+		default:
+			break;
+	}
+
+	card->ecsd[index] = value;
+
+	return( CS_CMD_CMP );
+}
+
+// Execute cmd on the card model.  Returns the completion status and
+// adds the time the command occupies the card/bus to *ns.
+static int emu_card_cmd( sdio_hc_t *hc, sdio_cmd_t *cmd, uint64_t *ns )
+{
+	emu_hc_t		*emu;
+	emu_card_t		*card;
+	emu_task_t		*task;
+	uint32_t		xoff;
+	uint32_t		blks;
+	int				idx;
+	int				cs;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	card	= &emu->card;
+	xoff	= 0;
+	cs		= CS_CMD_CMP;
+
+	memset( cmd->rsp, 0, sizeof( cmd->rsp ) );
+
+		// only addressed commands are answered in the data transfer modes
+	if( card->state != CDS_CUR_STATE_TRAN ) {
+		switch( cmd->opcode ) {
+			case MMC_GO_IDLE_STATE:
+			case MMC_SEND_OP_COND:
+			case MMC_ALL_SEND_CID:
+			case MMC_SLEEP_AWAKE:
+			case MMC_SET_RELATIVE_ADDR:
+			case MMC_SEL_DES_CARD:
+			case MMC_SEND_CSD:
+			case MMC_SEND_CID:
+			case MMC_SEND_STATUS:
+				break;
+
+			default:
+				return( CS_CMD_TO_ERR );
+		}
+	}
+
+	if( ( cmd->flags & SCF_RSP_PRESENT ) && !( cmd->flags & SCF_RSP_136 ) ) {
+		cmd->rsp[0] = emu_card_status( card );
+	}
+
+	switch( cmd->opcode ) {
+		case MMC_GO_IDLE_STATE:
+			emu_card_reset( card );
+			break;
+
+		case MMC_SEND_OP_COND:
+			cmd->rsp[0] = EMU_OCR | OCR_PWRUP_CMP | ( card->hcap ? OCR_HCS : 0 );
+			if( ( cmd->arg & EMU_OCR ) ) {
+				card->state = CDS_CUR_STATE_READY;
+			}
+			break;
+
+		case MMC_ALL_SEND_CID:
+			if( card->state != CDS_CUR_STATE_READY ) {
+				return( CS_CMD_TO_ERR );
+			}
+			memcpy( cmd->rsp, card->cid, sizeof( card->cid ) );
+			card->state = CDS_CUR_STATE_IDENT;
+			break;
+
+		case MMC_SET_RELATIVE_ADDR:
+			card->rca	= cmd->arg >> 16;
+			card->state	= CDS_CUR_STATE_STANDBY;
+			break;
+
+		case MMC_SEL_DES_CARD:
+			card->state = ( ( cmd->arg >> 16 ) == card->rca && card->rca ) ? CDS_CUR_STATE_TRAN : CDS_CUR_STATE_STANDBY;
+			break;
+
+		case MMC_SEND_CSD:
+		case MMC_SEND_CID:
+			if( ( cmd->arg >> 16 ) != card->rca || card->state != CDS_CUR_STATE_STANDBY ) {
+				return( CS_CMD_TO_ERR );
+			}
+			memcpy( cmd->rsp, cmd->opcode == MMC_SEND_CSD ? card->csd : card->cid, sizeof( card->csd ) );
+			break;
+
+		case MMC_SEND_STATUS:
+			if( ( cmd->arg >> 16 ) != card->rca ) {
+				return( CS_CMD_TO_ERR );
+			}
+			if( ( cmd->arg & MMC_SEND_STATUS_SQS ) ) {		// queue status register, all queued tasks are ready
+				card->err |= cmd->rsp[0] & CDS_ERROR_MSK;		// not a card status, keep the errors for the next one
+				for( idx = 0, cmd->rsp[0] = 0; idx < EMU_CMDQ_DEPTH; idx++ ) {
+					if( ( card->tasks[idx].flags & EMU_TF_QUEUED ) ) {
+						cmd->rsp[0] |= 1 << idx;
+					}
+				}
+			}
+			break;
+
+		case MMC_SLEEP_AWAKE:
+			if( card->state != CDS_CUR_STATE_STANDBY ) {
+				return( CS_CMD_TO_ERR );			// SDIO probe
+			}
+			break;
+
+		case MMC_STOP_TRANSMISSION:
+		case MMC_SET_BLOCKLEN:				// only 512 byte blocks are modelled
+			break;
+
+		case MMC_SWITCH:
+			cs = emu_switch( hc, cmd, ns );
+			break;
+
+		case MMC_SEND_EXT_CSD:
+			if( !( cmd->flags & SCF_DIR_IN ) || emu_xfer( cmd, card, &xoff, card->ecsd, 0, MMC_EXT_CSD_SIZE ) != EOK ) {
+				return( CS_CMD_TO_ERR );			// SD_SEND_IF_COND probe
+			}
+			break;
+
+		case MMC_BUSTEST_W:
+		case MMC_BUSTEST_R:
+			blks = min( cmd->blksz, sizeof( card->bustest ) );
+			if( cmd->opcode == MMC_BUSTEST_R ) {
+				for( idx = 0; idx < blks; idx++ ) {
+					card->bustest[idx] = ~card->bustest[idx];
+				}
+			}
+			if( emu_xfer( cmd, card, &xoff, card->bustest, 0, blks ) != EOK ) {
+				cs = CS_DATA_END_ERR;
+			}
+			break;
+
+		case MMC_SET_BLOCK_COUNT:
+			card->sbc = cmd->arg;
+			break;
+
+		case MMC_READ_SINGLE_BLOCK:
+		case MMC_READ_MULTIPLE_BLOCK:
+		case MMC_WRITE_BLOCK:
+		case MMC_WRITE_MULTIPLE_BLOCK:
+			if( ( card->ecsd[ECSD_CMDQ_MODE_EN] & ECSD_CMDQ_ENABLE ) ) {
+				return( CS_CMD_TO_ERR );
+			}
+			if( ( card->sbc & MMC_SBC_PACKED ) ) {
+				cs = emu_rw_packed( hc, cmd, ns );
+			}
+			else {
+				cs = emu_rw( hc, cmd, cmd->arg, cmd->blks, ns );
+			}
+			card->sbc = 0;
+			break;
+
+		case MMC_TAG_ERASE_GROUP_START:
+		case MMC_TAG_ERASE_GROUP_END:
+			break;
+
+		case MMC_ERASE:							// contents are left as they were
+			*ns += emu->erase_ns;
+			emu->stats.erases++;
+			break;
+
+		case MMC_QUE_TASK_PARAMS:
+			card->qtid			= ( cmd->arg >> MMC_QTP_TASK_ID_SHFT ) & ( EMU_CMDQ_DEPTH - 1 );
+			task				= &card->tasks[card->qtid];
+			task->blks			= cmd->arg & MMC_QTP_BLKS_MAX;
+			task->flags			= ( cmd->arg & MMC_QTP_DIR_READ ) ? EMU_TF_READ : 0;
+			break;
+
+		case MMC_QUE_TASK_ADDR:
+			task				= &card->tasks[card->qtid];
+			task->addr			= cmd->arg;
+			task->flags			|= EMU_TF_QUEUED;
+			emu->stats.qtasks++;
+			break;
+
+		case MMC_EXECUTE_READ_TASK:
+		case MMC_EXECUTE_WRITE_TASK:
+			task = &card->tasks[( cmd->arg >> MMC_QTP_TASK_ID_SHFT ) & ( EMU_CMDQ_DEPTH - 1 )];
+			if( !( task->flags & EMU_TF_QUEUED ) ||
+					!( task->flags & EMU_TF_READ ) != ( cmd->opcode == MMC_EXECUTE_WRITE_TASK ) ) {
+				cmd->rsp[0] |= CDS_ILLEGAL_COMMAND;
+				return( CS_CMD_CMP_ERR );
+			}
+			cs = emu_rw( hc, cmd, task->addr, task->blks, ns );
+			memset( task, 0, sizeof( *task ) );
+			break;
+
+		case MMC_CMDQ_TASK_MGMT:
+			if( ( cmd->arg & 0xf ) == MMC_CMDQ_TM_DISCARD_QUEUE ) {
+				memset( card->tasks, 0, sizeof( card->tasks ) );
+			}
+			else {
+				memset( &card->tasks[( cmd->arg >> MMC_QTP_TASK_ID_SHFT ) & ( EMU_CMDQ_DEPTH - 1 )], 0, sizeof( emu_task_t ) );
+			}
+			break;
+
+		default:
+			cs = CS_CMD_TO_ERR;
+			break;
+	}
+
+	return( cs );
+}
+
+static int emu_intr_event( sdio_hc_t *hc )
+{
+	emu_hc_t		*emu;
+	sdio_cmd_t		*cmd;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+
+	if( ( cmd = emu->cmd ) != NULL && cmd == hc->wspc.cmd ) {
+		emu->cmd = NULL;
+		sdio_cmd_cmplt( hc, cmd, emu->cs );
+	}
+
+	return( EOK );
+}
+
+static int emu_event( sdio_hc_t *hc, sdio_event_t *ev )
+{
+	int				status;
+
+	switch( ev->code ) {
+		case HC_EV_INTR:
+			status = emu_intr_event( hc );
+			break;
+
+		default:
+			status = bs_event( hc, ev );
+			break;
+	}
+
+	return( status );
+}
+
+static int emu_cmd( sdio_hc_t *hc, sdio_cmd_t *cmd )
+{
+	emu_hc_t		*emu;
+	uint64_t		ns;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	ns		= emu->cmd_ns;
+
+	emu->cs		= emu_card_cmd( hc, cmd, &ns );
+	emu->cmd	= cmd;
+
+	emu->stats.cmds++;
+	emu->stats.busy_ns	+= ns;
+	emu->stats.max_ns	= max( emu->stats.max_ns, ns );
+
+		// complete once the modelled time has passed, short times are
+		// spun as timers are only as fine as the system tick
+	if( ns <= emu->spin_ns ) {
+		nanospin_ns( ns );
+		if( MsgSendPulse( hc->hc_coid, hc->priority, HC_EV_INTR, 0 ) == -1 ) {
+			emu->cmd = NULL;
+			return( errno );
+		}
+	}
+	else {
+		return( sdio_timer_settime( emu->timerid, ns / 1000000000, ns % 1000000000, SDIO_FALSE ) );
+	}
+
+	return( EOK );
+}
+
+static int emu_abort( sdio_hc_t *hc, sdio_cmd_t *cmd )
+{
+	emu_hc_t		*emu;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+
+	sdio_timer_settime( emu->timerid, 0, 0, SDIO_FALSE );
+	emu->cmd = NULL;
+
+	return( EOK );
+}
+
+static int emu_pwr( sdio_hc_t *hc, int vdd )
+{
+	emu_hc_t		*emu;
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+
+	if( !vdd ) {
+		emu_card_reset( &emu->card );
+	}
+
+	hc->vdd = vdd;
+
+	return( EOK );
+}
+
+static int emu_clk( sdio_hc_t *hc, int clk )
+{
+	hc->clk = min( clk, hc->clk_max );
+
+	return( EOK );
+}
+
+static int emu_bus_mode( sdio_hc_t *hc, int bus_mode )
+{
+	hc->bus_mode = bus_mode;
+
+	return( EOK );
+}
+
+static int emu_bus_width( sdio_hc_t *hc, int width )
+{
+	hc->bus_width = width;
+
+	return( EOK );
+}
+
+static int emu_timing( sdio_hc_t *hc, int timing )
+{
+	hc->timing = timing;
+
+	return( EOK );
+}
+
+static int emu_signal_voltage( sdio_hc_t *hc, int signal_voltage )
+{
+	return( signal_voltage == SIGNAL_VOLTAGE_3_3 ? EOK : EINVAL );
+}
+
+static int emu_cd( sdio_hc_t *hc )
+{
+	return( CD_INS );
+}
+
+int emu_dinit( sdio_hc_t *hc )
+{
+	emu_hc_t		*emu;
+	emu_stats_t		*stats;
+
+	if( !hc || !hc->cs_hdl ) {
+		return( EOK );
+	}
+
+	emu		= (emu_hc_t *)hc->cs_hdl;
+	stats	= &emu->stats;
+
+	sdio_slogf( _SLOGC_SDIODI, _SLOG_INFO, hc->cfg.verbosity, 0,
+			"%s: cmds %" PRIu64 ", reads %" PRIu64 " (%" PRIu64 " blks), writes %" PRIu64 " (%" PRIu64 " blks), packed %" PRIu64 ", tasks %" PRIu64 ", flushes %" PRIu64 ", erases %" PRIu64 ", busy %" PRIu64 "us, max %" PRIu64 "us",
+			__FUNCTION__, stats->cmds, stats->rd_cmds, stats->rd_blks, stats->wr_cmds, stats->wr_blks, stats->packed,
+			stats->qtasks, stats->flushes, stats->erases, stats->busy_ns / 1000, stats->max_ns / 1000 );
+
+	if( emu->timerid != -1 ) {
+		timer_delete( emu->timerid );
+	}
+
+	if( emu->card.fd != -1 ) {
+		close( emu->card.fd );
+	}
+
+	if( emu->card.mem != MAP_FAILED ) {
+		munmap( emu->card.mem, (uint64_t)emu->card.sectors * EMU_SECTOR_SIZE );
+	}
+
+	free( emu->file );
+	free( emu );
+	hc->cs_hdl = NULL;
+
+	return( EOK );
+}
+
+static sdio_hc_entry_t emu_hc_entry = { 17,
+			   emu_dinit, NULL,
+			   emu_cmd, emu_abort,
+			   emu_event, emu_cd, emu_pwr,
+			   emu_clk, emu_bus_mode,
+			   emu_bus_width, emu_timing,
+			   emu_signal_voltage, NULL,
+			   NULL, NULL,
+			   NULL, NULL
+};
+
+int emu_init( sdio_hc_t *hc )
+{
+	sdio_hc_cfg_t		*cfg;
+	emu_hc_t			*emu;
+	struct sigevent		event;
+	int					status;
+
+	cfg					= &hc->cfg;
+
+	memcpy( &hc->entry, &emu_hc_entry, sizeof( sdio_hc_entry_t ) );
+
+	if( ( emu = hc->cs_hdl = calloc( 1, sizeof( emu_hc_t ) ) ) == NULL ) {
+		return( ENOMEM );
+	}
+
+	emu->timerid	= -1;
+	emu->card.fd	= -1;
+	emu->card.mem	= MAP_FAILED;
+	emu->cmd_ns		= EMU_CMD_LAT_US * 1000;
+	emu->racc_ns	= EMU_RACC_LAT_US * 1000;
+	emu->rd_ns		= EMU_RD_LAT_US * 1000;
+	emu->wr_ns		= EMU_WR_LAT_US * 1000;
+	emu->prog_ns	= EMU_PROG_LAT_US * 1000;
+	emu->flush_ns	= EMU_FLUSH_LAT_US * 1000;
+	emu->erase_ns	= EMU_ERASE_LAT_US * 1000;
+	emu->spin_ns	= EMU_SPIN_US * 1000;
+
+	if( ( status = emu_args( hc, cfg->options ) ) != EOK ||
+			( status = emu_card_init( hc ) ) != EOK ) {
+		emu_dinit( hc );
+		return( status );
+	}
+
+	SIGEV_PULSE_INIT( &event, hc->hc_coid, SDIO_PRIORITY, HC_EV_INTR, NULL );
+	if( timer_create( CLOCK_MONOTONIC, &event, &emu->timerid ) == -1 ) {
+		status = errno;
+		emu->timerid = -1;
+		emu_dinit( hc );
+		return( status );
+	}
+
+	hc->clk_max		= cfg->clk ? cfg->clk : EMU_CLOCK_DEFAULT;
+	hc->ocr			= EMU_OCR;
+	hc->cfg.sg_max	= EMU_SG_MAX;
+
+	hc->caps	|= HC_CAP_BSY | HC_CAP_BW4 | HC_CAP_BW8 | HC_CAP_HS | HC_CAP_DMA;
+	hc->caps	|= HC_CAP_ACMD12 | HC_CAP_ACMD23 | HC_CAP_SV_3_3V | HC_CAP_SLOT_TYPE_EMBEDDED;
+	if( !( emu->flags & EMU_FLAG_NOBSY_DATA ) ) {
+		hc->caps |= HC_CAP_BSY_DATA;
+	}
+	hc->caps	&= cfg->caps;		/* reconcile command line options */
+	hc->flags	|= HC_FLAG_DEV_MMC;
+
+	sdio_slogf( _SLOGC_SDIODI, _SLOG_INFO, hc->cfg.verbosity, 1, "%s: %s %uMB, cmd %uus, racc %uus, rd %uus, wr %uus, prog %uus, flush %uus",
+			__FUNCTION__, emu->file ? emu->file : "memory", emu->size, emu->cmd_ns / 1000, emu->racc_ns / 1000,
+			emu->rd_ns / 1000, emu->wr_ns / 1000, emu->prog_ns / 1000, emu->flush_ns / 1000 );
+
+	return( EOK );
+}
+
+#endif
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devb/sdmmc/sdiodi/hc/emu.c $ $Rev: 809510 $")
+#endif
@@ -0,0 +1,127 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2013, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+// Module Description:	eMMC device and host controller emulator
+
+#ifndef	_EMU_H_INCLUDED
+#define	_EMU_H_INCLUDED
+
+#include <internal.h>
+
+#define EMU_CLOCK_DEFAULT		52000000
+#define EMU_SG_MAX				64
+#define EMU_OCR					( OCR_VDD_32_33 | OCR_VDD_33_34 )
+
+#define EMU_SIZE_DFLT			64			// MB, when no file is given
+#define EMU_SECTOR_SIZE			512
+
+// default latencies (us), roughly a mid range eMMC on a 52MHz 8 bit bus
+#define EMU_CMD_LAT_US			20			// command/response
+#define EMU_RACC_LAT_US			60			// read access, per read command
+#define EMU_RD_LAT_US			10			// per block read
+#define EMU_WR_LAT_US			12			// per block write
+#define EMU_PROG_LAT_US			250			// program busy, per write command
+#define EMU_FLUSH_LAT_US		2000		// cache flush, plus the deferred program time
+#define EMU_ERASE_LAT_US		1000		// erase/trim/discard, bkops
+#define EMU_SPIN_US				500			// spin below, timer above
+
+#define EMU_CMDQ_DEPTH			32
+#define EMU_PACKED_WR_MAX		32
+#define EMU_PACKED_RD_MAX		8
+
+// ext_csd fields the emulator reports that mmc.h has no name for
+#define EMU_ECSD_CSD_STRUCTURE	194
+
+typedef struct _emu_task {
+	uint32_t		flags;
+#define EMU_TF_QUEUED			0x01
+#define EMU_TF_READ				0x02
+	uint32_t		blks;
+	uint32_t		addr;
+} emu_task_t;
+
+typedef struct _emu_card {
+	uint32_t		cid[4];
+	uint32_t		csd[4];
+	uint8_t			ecsd[MMC_EXT_CSD_SIZE];
+	uint8_t			bustest[8];
+
+	uint32_t		state;				// CDS_CUR_STATE_*
+	uint32_t		rca;
+	uint32_t		sbc;				// block count from CMD23
+	uint32_t		err;				// write errors for the next status, CDS_*
+	uint64_t		busy_end;			// card reports PRG until then (ns)
+	uint64_t		dirty_ns;			// program time held in the cache
+
+	uint32_t		sectors;
+	int				hcap;				// sector addressed
+	int				fd;
+	uint8_t			*mem;
+
+	uint32_t		qtid;				// task set by CMD44, addressed by CMD45
+	emu_task_t		tasks[EMU_CMDQ_DEPTH];
+} emu_card_t;
+
+typedef struct _emu_stats {
+	uint64_t		cmds;
+	uint64_t		rd_cmds;
+	uint64_t		wr_cmds;
+	uint64_t		rd_blks;
+	uint64_t		wr_blks;
+	uint64_t		packed;
+	uint64_t		qtasks;
+	uint64_t		flushes;
+	uint64_t		erases;
+	uint64_t		busy_ns;			// modelled card/bus time
+	uint64_t		max_ns;				// longest single command
+} emu_stats_t;
+
+typedef struct _emu_hc {
+	emu_card_t		card;
+	emu_stats_t		stats;
+
+	char			*file;
+	uint32_t		size;				// MB
+	uint32_t		flags;
+#define EMU_FLAG_NOBSY_DATA		0x01	// data busy is not signalled, poll CMD13
+	uint32_t		cmd_ns;
+	uint32_t		racc_ns;
+	uint32_t		rd_ns;
+	uint32_t		wr_ns;
+	uint32_t		prog_ns;
+	uint32_t		flush_ns;
+	uint32_t		erase_ns;
+	uint32_t		spin_ns;
+
+	int				timerid;
+	sdio_cmd_t		*cmd;				// command on the emulated bus
+	int				cs;					// its completion status
+} emu_hc_t;
+
+extern int emu_init( sdio_hc_t *hc );
+extern int emu_dinit( sdio_hc_t *hc );
+
+#endif
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devb/sdmmc/sdiodi/hc/emu.h $ $Rev: 743172 $")
+#endif
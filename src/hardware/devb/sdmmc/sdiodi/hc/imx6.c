@@ -359,7 +359,7 @@ static int imx6_sdhcx_event( sdio_hc_t *hc, sdio_event_t *ev )
 	return( status );
 }
 
-static int imx6_sdhcx_adma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
+static int imx6_sdhcx_adma_build( sdio_hc_t *hc, sdio_cmd_t *cmd, int idx )
 {
 	imx6_sdhcx_hc_t			*sdhc;
 	imx6_sdhcx_adma32_t		*adma;
@@ -372,7 +372,7 @@ static int imx6_sdhcx_adma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
 	paddr_t				paddr;
 
 	sdhc	= (imx6_sdhcx_hc_t *)hc->cs_hdl;
-	adma	= (imx6_sdhcx_adma32_t *)sdhc->adma;
+	adma	= (imx6_sdhcx_adma32_t *)sdhc->adma + idx * ADMA_DESC_MAX;
 
 	sgc = cmd->sgc;
 	sgp = cmd->sgl;
@@ -386,6 +386,9 @@ static int imx6_sdhcx_adma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
 		paddr		= sgp->sg_address;
 		sg_count	= sgp->sg_count;
 		while( sg_count ) {
+			if( acnt++ >= ADMA_DESC_MAX ) {		// don't overrun into the other table
+				return( ENOTSUP );
+			}
 			alen		= min( sg_count, IMX6_SDHCX_ADMA2_MAX_XFER );
 			adma->attr	= IMX6_SDHCX_ADMA2_VALID | IMX6_SDHCX_ADMA2_TRAN;
 			adma->addr	= paddr;
@@ -393,20 +396,67 @@ static int imx6_sdhcx_adma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
 			sg_count	-= alen; 
 			paddr		+= alen;
 			adma++;
-			if( ++acnt > ADMA_DESC_MAX ) {
-				return( ENOTSUP );
-			}
 		}
 	}
 
 	adma--;
 	adma->attr |= IMX6_SDHCX_ADMA2_END;
 
-	imx6_sdhcx_out32( sdhc->base + IMX6_SDHCX_ADMA_ADDRL, sdhc->admap );
+	return( EOK );
+}
+
+static int imx6_sdhcx_adma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
+{
+	imx6_sdhcx_hc_t		*sdhc;
+	int					idx;
+	int					status;
+
+	sdhc	= (imx6_sdhcx_hc_t *)hc->cs_hdl;
+
+	if( ( cmd->flags & SCF_PREP ) && sdhc->prep_cmd == cmd ) {
+		idx = sdhc->prep_idx;
+	}
+	else {
+		idx = sdhc->adma_idx ^ 1;
+		if( ( status = imx6_sdhcx_adma_build( hc, cmd, idx ) ) != EOK ) {
+			sdhc->prep_cmd = NULL;
+			return( status );
+		}
+	}
+
+	sdhc->prep_cmd	= NULL;
+	sdhc->adma_idx	= idx;
+
+	imx6_sdhcx_out32( sdhc->base + IMX6_SDHCX_ADMA_ADDRL, sdhc->admap + idx * ADMA_DESC_MAX * sizeof( imx6_sdhcx_adma32_t ) );
 
 	return( EOK );
 }
 
+// Build the descriptor table of the next command in the table not used by
+// the transfer in progress, so it can be issued without the vtop/build delay.
+static int imx6_sdhcx_prep( sdio_hc_t *hc, sdio_cmd_t *cmd )
+{
+	imx6_sdhcx_hc_t		*sdhc;
+	int					idx;
+	int					status;
+
+	sdhc			= (imx6_sdhcx_hc_t *)hc->cs_hdl;
+	sdhc->prep_cmd	= NULL;
+
+	if( !( sdhc->flags & SF_USE_ADMA ) || !( hc->caps & HC_CAP_DMA ) || !cmd->sgc ) {
+		return( ENOTSUP );
+	}
+
+	idx = sdhc->adma_idx ^ 1;
+	if( ( status = imx6_sdhcx_adma_build( hc, cmd, idx ) ) == EOK ) {
+		sdhc->prep_cmd	= cmd;
+		sdhc->prep_idx	= idx;
+		cmd->flags		|= SCF_PREP;
+	}
+
+	return( status );
+}
+
 static int imx6_sdhcx_sdma_setup( sdio_hc_t *hc, sdio_cmd_t *cmd )
 {
 	imx6_sdhcx_hc_t		*sdhc;
@@ -482,7 +532,7 @@ static int imx6_sdhcx_xfer_setup( sdio_hc_t *hc, sdio_cmd_t *cmd,
 		if( ( hc->caps & HC_CAP_ACMD23 ) && ( cmd->flags & SCF_SBC ) ) {
 			mix_ctrl |= IMX6_SDHCX_MIX_CTRL_ACMD23;
 		}
-		else if( ( hc->caps & HC_CAP_ACMD12 ) ) {
+		else if( ( hc->caps & HC_CAP_ACMD12 ) && !( cmd->flags & SCF_NO_AUTO_CMD ) ) {
 			mix_ctrl |= IMX6_SDHCX_MIX_CTRL_ACMD12;
 		}
 	}
@@ -1032,7 +1082,7 @@ int imx6_sdhcx_dinit( sdio_hc_t *hc )
 	}
 
 	if( sdhc->adma )
-		munmap( sdhc->adma, sizeof( imx6_sdhcx_adma32_t ) * ADMA_DESC_MAX );
+		munmap( sdhc->adma, sizeof( imx6_sdhcx_adma32_t ) * ADMA_DESC_MAX * ADMA_TBL_MAX );
 
 	free( sdhc );
 	hc->cs_hdl = NULL;
@@ -1040,7 +1090,7 @@ int imx6_sdhcx_dinit( sdio_hc_t *hc )
 	return( EOK );
 }
 
-static sdio_hc_entry_t imx6_sdhcx_hc_entry ={ 16,
+static sdio_hc_entry_t imx6_sdhcx_hc_entry ={ 17,
 			   imx6_sdhcx_dinit, NULL,
 			   imx6_sdhcx_cmd, imx6_sdhcx_abort,
 			   imx6_sdhcx_event, imx6_sdhcx_cd, imx6_sdhcx_pwr,
@@ -1048,7 +1098,7 @@ static sdio_hc_entry_t imx6_sdhcx_hc_entry ={ 16,
 			   imx6_sdhcx_bus_width, imx6_sdhcx_timing,
 			   imx6_sdhcx_signal_voltage, NULL,
 			   NULL, imx6_sdhcx_tune,
-			   NULL
+			   NULL, imx6_sdhcx_prep
 };
 
 int imx6_sdhcx_init( sdio_hc_t *hc )
@@ -1097,7 +1147,7 @@ int imx6_sdhcx_init( sdio_hc_t *hc )
 	else
 		hc->clk_max = IMX6_CLOCK_DEFAULT;
 
-	hc->caps	|= HC_CAP_BSY | HC_CAP_BW4 | HC_CAP_CD_INTR;
+	hc->caps	|= HC_CAP_BSY | HC_CAP_BSY_DATA | HC_CAP_BW4 | HC_CAP_CD_INTR;
 	hc->caps	|= HC_CAP_ACMD12 | HC_CAP_200MA | HC_CAP_DRV_TYPE_B;
 
 	if( cap & IMX6_SDHCX_CAP_HS ) 
@@ -1129,7 +1179,7 @@ int imx6_sdhcx_init( sdio_hc_t *hc )
         if( hc->version >= IMX6_SDHCX_SPEC_VER_3 ) {
 			hc->cfg.sg_max	= ADMA_DESC_MAX;
 			if( ( sdhc->adma = mmap( NULL, sizeof( imx6_sdhcx_adma32_t ) *
-                                     ADMA_DESC_MAX, PROT_READ | PROT_WRITE | PROT_NOCACHE, 
+                                     ADMA_DESC_MAX * ADMA_TBL_MAX, PROT_READ | PROT_WRITE | PROT_NOCACHE, 
                                      MAP_PRIVATE | MAP_ANON | MAP_PHYS, NOFD, 0 ) )
                 == MAP_FAILED )
             {
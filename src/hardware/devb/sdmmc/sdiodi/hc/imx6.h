@@ -294,6 +294,10 @@ typedef	struct _imx6_usdhcx_hc {
 	uintptr_t		base;
     imx6_sdhcx_adma32_t*  adma;
 	uint32_t		admap;
+#define ADMA_TBL_MAX		2			// current and prepared descriptor tables
+	int				adma_idx;	// table of the last issued transfer
+	int				prep_idx;	// table prepared for prep_cmd
+	sdio_cmd_t		*prep_cmd;
 #define SF_USE_SDMA			0x01
 #define SF_USE_ADMA			0x02
 #define SF_TUNE_SDR50		0x04
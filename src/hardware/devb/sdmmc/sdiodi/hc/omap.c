@@ -1114,7 +1114,7 @@ static int omap_xfer_setup( sdio_hc_t *hc, sdio_cmd_t *cmd, uint32_t *command, u
 				*command |= CMD_ACMD23;
 				out32( mmchs->mmc_base + MMCHS_SDMASA, cmd->blks );
 			}
-			else if( ( hc->caps & HC_CAP_ACMD12 ) ) {
+			else if( ( hc->caps & HC_CAP_ACMD12 ) && !( cmd->flags & SCF_NO_AUTO_CMD ) ) {
 				*command |= CMD_ACMD12;
 			}
 		}
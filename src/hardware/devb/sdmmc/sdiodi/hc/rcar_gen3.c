@@ -316,7 +316,7 @@ static int rcar_sdmmc_cmd(sdio_hc_t *hc, sdio_cmd_t *cmd)
          if (cmd->flags & SCF_MULTIBLK) {
               sdmmc_write(sdmmc->vbase, MMC_SD_STOP, SDH_STOP_SEC);
             command |= SDH_CMD_DAT_MULTI;
-            if (!(hc->caps & HC_CAP_ACMD12))
+            if (!(hc->caps & HC_CAP_ACMD12) || (cmd->flags & SCF_NO_AUTO_CMD))
                 command |= SDH_CMD_NOAC12;
          } else
             sdmmc_write(sdmmc->vbase, MMC_SD_STOP, 0);
@@ -462,7 +462,7 @@ static int sdhci_xfer_setup( sdio_hc_t *hc, sdio_cmd_t *cmd,
 			*command |= SDHCI_CMD_ACMD23;
 			sdhci_out32( base + SDHCI_SDMA_ARG2, cmd->blks );
 		}
-		else if( ( hc->caps & HC_CAP_ACMD12 ) ) {
+		else if( ( hc->caps & HC_CAP_ACMD12 ) && !( cmd->flags & SCF_NO_AUTO_CMD ) ) {
 			*command |= SDHCI_CMD_ACMD12;
 		}
 	}
@@ -1134,7 +1134,7 @@ int sdhci_init( sdio_hc_t *hc )
 		}
 	}
 
-	hc->caps	|= HC_CAP_BSY | HC_CAP_BW4 | HC_CAP_CD_INTR;
+	hc->caps	|= HC_CAP_BSY | HC_CAP_BSY_DATA | HC_CAP_BW4 | HC_CAP_CD_INTR;
 	hc->caps	|= HC_CAP_ACMD12 | HC_CAP_200MA | HC_CAP_DRV_TYPE_B;
 
 	if( ( cap & SDHCI_CAP_HS ) )
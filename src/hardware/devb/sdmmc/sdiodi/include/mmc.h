@@ -102,6 +102,7 @@
 
 #define	MMC_SEND_STATUS				13
 	#define MMC_SEND_STATUS_HPI			(1 << 0)
+	#define MMC_SEND_STATUS_SQS			(1 << 15)	// return queue status register
 
 // Card/Device Status Response Bits
 	#define	CDS_OUT_OF_RANGE			(1 << 31)
@@ -166,6 +167,9 @@
 #define	MMC_WRITE_DAT_UNTIL_STOP	20
 #define MMC_SEND_TUNING_BLOCK		21
 #define MMC_SET_BLOCK_COUNT         23
+	#define MMC_SBC_REL_WRITE			(1 << 31)
+	#define MMC_SBC_PACKED				(1 << 30)
+	#define MMC_SBC_BLKS_MAX			0xffff
 #define	MMC_WRITE_BLOCK				24
 #define	MMC_WRITE_MULTIPLE_BLOCK	25
 #define	MMC_PROGRAM_CID				26
@@ -201,14 +205,37 @@
 	#define MMC_LU_SET_PWD				0x01
 	#define MMC_LU_PWD_SIZE				16		// max password size
 	
+#define	MMC_QUE_TASK_PARAMS			44
+	#define MMC_QTP_REL_WRITE			(1 << 31)
+	#define MMC_QTP_DIR_READ			(1 << 30)
+	#define MMC_QTP_TAG_REQ				(1 << 29)
+	#define MMC_QTP_PRIORITY			(1 << 23)
+	#define MMC_QTP_TASK_ID_SHFT		16
+	#define MMC_QTP_BLKS_MAX			0xffff
+#define	MMC_QUE_TASK_ADDR			45
+#define	MMC_EXECUTE_READ_TASK		46
+#define	MMC_EXECUTE_WRITE_TASK		47
+#define	MMC_CMDQ_TASK_MGMT			48
+	#define MMC_CMDQ_TM_DISCARD_QUEUE	0x01
+	#define MMC_CMDQ_TM_DISCARD_TASK	0x02
+
 #define	MMC_APP_CMD					55
 #define	MMC_GEN_CMD					56
 #define	MMC_READ_OCR				58
 #define	MMC_CRC_ON_OFF				59
 
+// packed command header, first data block of a packed transfer
+#define MMC_PACKED_CMD_VER			0x01
+#define MMC_PACKED_CMD_READ			0x01
+#define MMC_PACKED_CMD_WRITE		0x02
+#define MMC_PACKED_HDR( _n, _rw )	( ( (_n) << 16 ) | ( (_rw) << 8 ) | MMC_PACKED_CMD_VER )
+
 // EXT_CSD fields
 #define MMC_EXT_CSD_SIZE			512	
 
+#define ECSD_CMDQ_MODE_EN			15
+	#define ECSD_CMDQ_ENABLE			0x01
+
 #define ECSD_FLUSH_CACHE			32
 	#define ECSD_FLUSH_TRIGGER			0x01
 
@@ -222,6 +249,14 @@
 	#define ECSD_POWER_OFF_SHORT		0x02
 	#define ECSD_POWER_OFF_LONG			0x03
 
+#define ECSD_PACKED_FAILURE_INDEX	35
+#define ECSD_PACKED_CMD_STATUS		36
+	#define ECSD_PCS_ERROR				0x01
+	#define ECSD_PCS_INDEXED_ERROR		0x02
+
+#define ECSD_EXP_EVENTS_STATUS		54
+	#define ECSD_EXP_PACKED_FAILURE		0x08
+
 #define ECSD_USE_NATIVE_SECTOR		62
 	#define ECSD_USE_NATIVE_SECTOR_EN	0x01
 
@@ -330,6 +365,7 @@
 	#define ECSD_CARD_TYPE_MSK			0xff
 
 #define ECSD_REV					192
+	#define ECSD_REV_V5_1				8
 	#define ECSD_REV_V5					7
 	#define ECSD_REV_V4_5				6
 	#define ECSD_REV_V4_41				5
@@ -372,6 +408,15 @@
 
 #define ECSD_POWER_OFF_LONG_TIME	247  // Power off long switch timeout
 
+#define ECSD_CMDQ_DEPTH				307
+	#define ECSD_CMDQ_DEPTH_MSK			0x1f	// depth is N + 1
+
+#define ECSD_CMDQ_SUPPORT			308
+	#define ECSD_CMDQ_SUP				0x01
+
+#define ECSD_MAX_PACKED_WRITES		500
+#define ECSD_MAX_PACKED_READS		501
+
 #define ECSD_BKOPS_SUPPORTED		502  // Background operation support
 	#define ECSD_BKOPS_SUP				1
 
@@ -181,10 +181,14 @@ struct _sdio_sge {
 #define	SCF_APP_CMD			(1 << 11)	// app command (cmd 55)
 #define	SCF_SBC				(1 << 12)	// auto issue set block count (cmd 23)
 #define	SCF_WAIT_DRDY		(1 << 13)	// wait ready for data
+#define	SCF_QTASK			(1 << 14)	// execute queued task (cmd 46/47), no auto cmd12/23
+#define	SCF_PACKED			(1 << 15)	// packed transfer, issue cmd23 with packed flag, no auto cmd12/23
+#define	SCF_NO_AUTO_CMD		(SCF_QTASK | SCF_PACKED)
 
 // driver internal
 #define	SCF_DATA_PHYS		(1 << 24)	// data physical address
 #define	SCF_MULTIBLK		(1 << 25)
+#define	SCF_PREP			(1 << 26)	// data descriptors prepared by hc
 
 // command status
 #define CS_CMD_INPROG		0x00
@@ -264,6 +268,8 @@ struct _sdio_dev_info {
 #define DEV_CAP_CACHE		(1 << 15)
 #define DEV_CAP_HS400		(1 << 16)
 #define DEV_CAP_PWROFF_NOTIFY	(1 << 17)	// Power off notify supported
+#define DEV_CAP_CMDQ		(1 << 18)	// Command queuing supported
+#define DEV_CAP_PACKED		(1 << 19)	// Packed commands supported
 	_Uint64t			caps;
 
 	_Uint32t			dtr;			// current data transfer rate
@@ -318,6 +324,7 @@ struct _sdio_hc_info {
 #define	HC_CAP_DDR50				(1 << 14)	// Dual Data Rate supported
 #define HC_CAP_HS200				(1 << 15)
 #define HC_CAP_HS400				(1 << 16)
+#define HC_CAP_BSY_DATA				(1LL << 34)	// write transfer complete held until DAT0 busy ends
 	_Uint64t		caps;
 	_Uint32t		version;
 	_Uint32t		sg_max;
@@ -327,7 +334,11 @@ struct _sdio_hc_info {
 	_Uint32t		bus_width;					// Current Bus Width
 	_Uint32t		idle_time;					// PM Idle Time in ms
 	_Uint32t		sleep_time;					// PM Sleep Time in ms
-	_Uint32t		rsvd[10];
+	_Uint32t		tune_cnt;					// Tunings run
+	_Uint32t		tune_err;					// Tunings that failed
+	_Uint64t		tune_ns;					// Time spent tuning
+	_Uint64t		tune_max_ns;				// Longest tuning
+	_Uint32t		rsvd[4];
 };
 
 struct _sdio_funcs {
@@ -381,6 +392,7 @@ extern int				sdio_setup_cmd( struct sdio_cmd *cmd, _Uint32t flgs,
 							int op, int arg );
 extern int				sdio_setup_cmd_io( struct sdio_cmd *cmd, _Uint32t flgs,
 							int blks, int blksz, void *sgl, int sgc, void *mhdl );
+extern int				sdio_setup_cmd_next( struct sdio_cmd *cmd, struct sdio_cmd *next );
 
 extern void				*sdio_client_hdl( struct sdio_device *device );
 extern void				*sdio_bs_hdl( struct sdio_device *dev );
@@ -68,6 +68,9 @@
 #define SDIO_BLKSZ_4K					4096
 #define SDIO_CLK_INIT					400000
 #define SDIO_TIMEOUT_MS_TO_NS( _to )	( (uint64_t)( _to ) * 1000LL * 1000LL )
+#define SDIO_BSY_POLL_MIN_NS			10000		// first card status poll interval
+#define SDIO_BSY_POLL_SPIN_NS			200000		// spin below this, sleep above
+#define SDIO_BSY_POLL_MAX_NS			4000000		// poll interval cap
 
 #define SDIO_ARG_VAL( _o, _v, _s ) if( (_v) == NULL || *(_v) == '\0' ) { sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, 1, 1, "%s:  Missing argument for '%s'", __FUNCTION__, _o ); (_s) = EINVAL; break; }
 #define SDIO_ARG_NOVAL( _o, _v ) if( (_v) != NULL ) { sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, 1, 1, "%s:  Unexpected argument for '%s'", __FUNCTION__, _o ); break; }
@@ -146,6 +149,7 @@ struct sdio_cmd {
 	sdio_sge_t				*sgl;
 	void					*mhdl;
 	void					(*cbf)( struct sdio_device *, sdio_cmd_t *, void *);
+	sdio_cmd_t				*next;		// prepared while this command is on the bus
 };
 
 struct _sdio_wspc {
@@ -216,6 +220,7 @@ struct _sdio_hc_entry {
 	int			(*driver_strength)(sdio_hc_t *, int timing, int type);
 	int			(*tune)(sdio_hc_t *, int op);
 	int			(*preset)(sdio_hc_t *, int);
+	int			(*prep)(sdio_hc_t *, sdio_cmd_t *);
 };
 
 struct _sdio_dev {
@@ -405,6 +410,7 @@ struct _sdio_hc {							// Host Controller
 
 #define	HC_CAP_CD_INTR				(1LL << 32)	// card detect interrupt supported
 #define HC_CAP_BSY					(1LL << 33)	// card detect busy supported
+#define HC_CAP_BSY_DATA				(1LL << 34)	// write transfer complete held until DAT0 busy ends
 	_Uint64t			caps;				// Capabilities
 
 	_Uint32t			version;
@@ -421,6 +427,10 @@ struct _sdio_hc {							// Host Controller
 
 	int					tuning_count;
 	int					tuning_timerid;
+	_Uint32t			tuning_cnt;			// tunings run
+	_Uint32t			tuning_err;			// tunings that failed
+	_Uint64t			tuning_ns;			// time spent tuning
+	_Uint64t			tuning_max_ns;
 
 	int					slot;
 
@@ -286,12 +286,22 @@ int mmc_parse_ext_csd( sdio_dev_t *dev, sdio_ecsd_t *ecsd, uint8_t *raw_ecsd )
 		}
 		dev->caps		|= DEV_CAP_DISCARD;		// DISCARD support
 		dev->caps		|= DEV_CAP_PWROFF_NOTIFY;       // Power off notification support
+
+		if( raw_ecsd[ECSD_MAX_PACKED_WRITES] ) {
+			dev->caps	|= DEV_CAP_PACKED;
+		}
 	}
 
 	if( ecsd->ext_csd_rev >= ECSD_REV_V5 ) {
 		// HS400
 	}
 
+	if( ecsd->ext_csd_rev >= ECSD_REV_V5_1 ) {
+		if( ( raw_ecsd[ECSD_CMDQ_SUPPORT] & ECSD_CMDQ_SUP ) ) {
+			dev->caps	|= DEV_CAP_CMDQ;
+		}
+	}
+
 	ecsd->card_type = raw_ecsd[ECSD_CARD_TYPE] & ECSD_CARD_TYPE_MSK;
 
 	if( ( hc->caps & HC_CAP_HS400 ) && ( ecsd->card_type & ECSD_CARD_TYPE_HS400 ) ) {
@@ -795,7 +805,7 @@ int _mmc_init_hs200( sdio_hc_t *hc, int bus_width )
 
 	sdio_clock( hc, dev->ecsd.dtr_max_hs );
 
-	if( ( status = hc->entry.tune( hc, MMC_SEND_TUNING_BLOCK ) ) ) {
+	if( ( status = sdio_tune( hc, MMC_SEND_TUNING_BLOCK ) ) ) {
 		sdio_slogf( _SLOGC_SDIODI, _SLOG_ERROR, hc->cfg.verbosity, 0, "%s: tune failure", __FUNCTION__ );
 		return( status );
 	}
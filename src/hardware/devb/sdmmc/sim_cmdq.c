@@ -0,0 +1,561 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2014, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+// eMMC 5.1 command queuing.
+//
+// The host controllers have no command queue engine, so the queue is
+// driven from the SIM thread.  Read/write ccbs are queued to the device
+// with CMD44/CMD45, the queue status register (CMD13 SQS) is polled for
+// a task the device has made ready, and the task is transferred with
+// CMD46/CMD47.  Any other ccb waits for the device queue to drain and
+// runs with command queue mode switched off when it needs legacy commands.
+
+#include <sim_sdmmc.h>
+
+#define CMDQ_QSR_SPIN				64		// QSR polls before sleeping between polls
+#define CMDQ_QSR_TIMEOUT			SDIO_TIME_DEFAULT
+
+#define CMDQ_TMAP_FULL( _ext )		( ( _ext )->cmdq_depth >= 32 ? 0xffffffff : ( ( 1U << ( _ext )->cmdq_depth ) - 1 ) )
+
+int sdmmc_cmdq_cfg( SIM_HBA *hba, int enable )
+{
+	SIM_SDMMC_EXT	*ext;
+	int				status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	if( !( ext->dev_inf.caps & DEV_CAP_CMDQ ) ) {
+		return( ENOTSUP );
+	}
+
+	if( ( status = sdio_mmc_switch( ext->device, MMC_SWITCH_CMDSET_DFLT, MMC_SWITCH_MODE_WRITE, ECSD_CMDQ_MODE_EN, enable ? ECSD_CMDQ_ENABLE : 0, SDIO_TIME_DEFAULT ) ) != EOK ) {
+		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s: switch ext_csd_cmdq_mode_en %d", __FUNCTION__, enable );
+	}
+
+	return( status );
+}
+
+int sdmmc_cmdq_init( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT	*ext;
+	uint8_t			*ecsd;
+	uint32_t		depth;
+	int				status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	if( !( ext->dev_inf.caps & DEV_CAP_CMDQ ) ) {
+		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  command queuing not supported by device", __FUNCTION__ );
+		return( ENOTSUP );
+	}
+
+	ecsd	= sdio_get_raw_ecsd( ext->device );
+	depth	= ( ecsd[ECSD_CMDQ_DEPTH] & ECSD_CMDQ_DEPTH_MSK ) + 1;
+
+	if( ext->cmdq_depth == 0 || ext->cmdq_depth > depth ) {
+		ext->cmdq_depth = depth;
+	}
+
+	if( ( status = sdmmc_cmdq_cfg( hba, CAM_TRUE ) ) != EOK ) {
+		ext->cmdq_depth = 0;
+		return( status );
+	}
+
+	ext->cmdq_tmap	= 0;
+	ext->cmdq_part	= NULL;
+	ext->cmdq_hold	= NULL;
+
+	cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  command queue depth %d", __FUNCTION__, ext->cmdq_depth );
+
+	return( EOK );
+}
+
+static int sdmmc_cmdq_ac( SIM_HBA *hba, int op, uint32_t arg, uint32_t flgs, uint32_t *rsp )
+{
+	SIM_SDMMC_EXT	*ext;
+	struct sdio_cmd	*cmd;
+	int				status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	rsp[0]	= 0;
+
+	if( ( cmd = sdio_alloc_cmd( ) ) == NULL ) {
+		return( ENOMEM );
+	}
+
+	sdio_setup_cmd( cmd, SCF_CTYPE_AC | flgs, op, arg );
+	status = sdio_send_cmd( ext->device, cmd, NULL, SDIO_TIME_DEFAULT, 0 );
+	sdio_cmd_status( cmd, NULL, rsp );
+	sdio_free_cmd( cmd );
+
+	return( status );
+}
+
+// Fail all queued tasks back to CAM and bring the device back to
+// the transfer state with an empty queue.
+static void sdmmc_cmdq_recover( SIM_HBA *hba, int status )
+{
+	SIM_SDMMC_EXT	*ext;
+	CCB_SCSIIO		*ccb;
+	int				rst;
+	int				tid;
+	uint32_t		rsp[4];
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	rst		= CAM_FALSE;
+
+	if( status != ENXIO ) {
+		if( ext->cmdq_tmap && sdmmc_cmdq_ac( hba, MMC_CMDQ_TASK_MGMT, MMC_CMDQ_TM_DISCARD_QUEUE, SCF_RSP_R1B, rsp ) != EOK ) {
+			rst = CAM_TRUE;
+		}
+
+		if( rst || sdio_send_status( ext->device, rsp, 0 ) || ( rsp[0] & ( CDS_READY_FOR_DATA | CDS_CUR_STATE_MSK ) ) != ( CDS_READY_FOR_DATA | CDS_CUR_STATE_TRAN ) ) {
+			sdmmc_reset( hba );
+		}
+
+		sdio_dev_info( ext->device, &ext->dev_inf );
+	}
+
+		// discarded tasks are returned as timed out so the CAM layer retries them
+	for( tid = 0; ext->cmdq_tmap; tid++ ) {
+		if( ( ext->cmdq_tmap & ( 1U << tid ) ) ) {
+			if( ext->cmdq_tasks[tid].cmd ) {
+				sdio_free_cmd( ext->cmdq_tasks[tid].cmd );
+				ext->cmdq_tasks[tid].cmd = NULL;
+			}
+			ext->cmdq_tmap		&= ~( 1U << tid );
+			ccb					= ext->cmdq_tasks[tid].ccb;
+			ccb->cam_ch.cam_status = sdmmc_error( hba, ccb, status == ENXIO ? ENXIO : ETIMEDOUT );
+			sdmmc_post_ccb( hba, ccb );
+		}
+	}
+}
+
+static int sdmmc_cmdq_queueable( SIM_HBA *hba, CCB_SCSIIO *ccb )
+{
+	SIM_SDMMC_EXT	*ext;
+	SDMMC_PARTITION	*part;
+	uint32_t		blks;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	if( ccb->cam_ch.cam_func_code != XPT_SCSI_IO ) {
+		return( CAM_FALSE );
+	}
+
+	switch( ccb->cam_cdb_io.cam_cdb_bytes[0] ) {
+		case SC_READ10:
+			break;
+
+#ifndef SDMMC_WRITE_VERIFY
+		case SC_WRITE10:
+			break;
+#endif
+
+		default:
+			return( CAM_FALSE );
+	}
+
+	blks	= ccb->cam_dxfer_len / ext->dev_inf.sector_size;
+	if( blks == 0 || blks > MMC_QTP_BLKS_MAX ) {
+		return( CAM_FALSE );
+	}
+
+		// all queued tasks must target the same partition
+	part	= &ext->targets[ccb->cam_ch.cam_target_id].partitions[ccb->cam_ch.cam_target_lun];
+	if( ext->cmdq_tmap && part != ext->cmdq_part ) {
+		return( CAM_FALSE );
+	}
+
+	return( CAM_TRUE );
+}
+
+// ccbs which may issue commands that are illegal in command queue mode
+static int sdmmc_cmdq_legacy( CCB_SCSIIO *ccb )
+{
+	if( ccb->cam_ch.cam_func_code != XPT_SCSI_IO ) {
+		return( CAM_TRUE );
+	}
+
+	switch( ccb->cam_cdb_io.cam_cdb_bytes[0] ) {
+		case SC_UNIT_RDY:
+		case SC_INQUIRY:
+		case SC_RD_CAP:
+		case SC_MSENSE10:
+		case SC_SYNC:
+			return( CAM_FALSE );
+
+		default:
+			return( CAM_TRUE );
+	}
+}
+
+static int sdmmc_cmdq_queue( SIM_HBA *hba, CCB_SCSIIO *ccb )
+{
+	SIM_SDMMC_EXT		*ext;
+	sdio_dev_info_t		*di;
+	SDMMC_PARTITION		*part;
+	SDMMC_CMDQ_TASK		*task;
+	uint32_t			lba;
+	uint32_t			arg;
+	uint32_t			rsp[4];
+	int					flgs;
+	int					tid;
+	int					retry;
+	int					status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	di		= &ext->dev_inf;
+	part	= &ext->targets[ccb->cam_ch.cam_target_id].partitions[ccb->cam_ch.cam_target_lun];
+	flgs	= ( ccb->cam_cdb_io.cam_cdb_bytes[0] == SC_READ10 ) ? SCF_DIR_IN : SCF_DIR_OUT;
+
+	if( hba->verbosity > 3 ) {
+		xpt_display_ccb( ccb, hba->verbosity );
+	}
+
+	if( ( status = sdmmc_unit_ready( hba, ccb ) ) != CAM_REQ_CMP ) {
+		return( status );
+	}
+
+	if( ( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) && !( ext->hc_inf.caps & HC_CAP_DMA ) ) {
+		return( CAM_PROVIDE_FAIL );
+	}
+
+	if( ( di->flags & DEV_FLAG_CARD_LOCKED ) ) {
+		return( sdmmc_error( hba, ccb, EACCES ) );
+	}
+
+	if( ( flgs & SCF_DIR_OUT ) && ( part->pflags & SDMMC_PFLAG_WP ) ) {
+		return( sdmmc_error( hba, ccb, EROFS ) );
+	}
+
+	if( ( part->config & MMC_PART_MSK ) == MMC_PART_RPMB ) {		// no read/write to RPMB
+		return( CAM_PROVIDE_FAIL );
+	}
+
+	if( ext->cmdq_tmap == 0 ) {
+		if( ( status = sdio_set_partition( ext->device, part->config ) ) != EOK ) {
+			cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s: sdio_set_partition failure %s", __FUNCTION__, strerror( status ) );
+			sdmmc_reset( hba );
+			return( sdmmc_error( hba, ccb, ETIMEDOUT ) );
+		}
+
+		sdmmc_bkops( hba, CAM_FALSE );	// Check for urgent background operations
+		ext->cmdq_part = part;
+	}
+
+	for( tid = 0; ( ext->cmdq_tmap & ( 1U << tid ) ); tid++ ) {
+		;
+	}
+
+	task		= &ext->cmdq_tasks[tid];
+	task->ccb	= ccb;
+	task->cmd	= NULL;
+	task->qtime	= ClockCycles( );
+	task->part	= part;
+	task->flgs	= flgs | SCF_QTASK;
+	task->blks	= ccb->cam_dxfer_len / di->sector_size;
+
+	if( ( ccb->cam_ch.cam_flags & CAM_SCATTER_VALID ) ) {
+		task->sgc				= ccb->cam_sglist_cnt;
+		task->sgl				= (sdio_sge_t *)ccb->cam_data.cam_sg_ptr;
+	}
+	else {
+		task->sgc				= 1;
+		task->sgl				= &task->sge;
+		task->sge.sg_count		= ccb->cam_dxfer_len;
+		task->sge.sg_address	= ccb->cam_data.cam_data_ptr;
+	}
+
+	if( ( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) ) {
+		task->flgs |= SCF_DATA_PHYS;
+	}
+
+	if( task->blks > 1 ) {
+		task->flgs |= SCF_MULTIBLK;
+	}
+
+	lba		= ENDIAN_BE32( UNALIGNED_RET32( &ccb->cam_cdb_io.cam_cdb_bytes[2] ) );
+
+	if( part->blk_shft ) {
+		lba <<= part->blk_shft;
+	}
+
+	lba			+= part->slba;
+	task->addr	= ( di->caps & DEV_CAP_HC ) ? lba : ( lba * di->sector_size );
+
+	arg		= ( ( flgs & SCF_DIR_IN ) ? MMC_QTP_DIR_READ : 0 ) | ( tid << MMC_QTP_TASK_ID_SHFT ) | task->blks;
+
+		// command queue mode is lost when the sdio layer resets the device,
+		// so re-enable it once if the first task of a queue is rejected.
+	for( retry = ( ext->cmdq_tmap == 0 ); ; retry = CAM_FALSE ) {
+		if( ( status = sdmmc_cmdq_ac( hba, MMC_QUE_TASK_PARAMS, arg, SCF_RSP_R1, rsp ) ) == EOK ) {
+			status = sdmmc_cmdq_ac( hba, MMC_QUE_TASK_ADDR, task->addr, SCF_RSP_R1, rsp );
+		}
+
+		if( status == EOK || status == ENXIO || !retry || sdmmc_cmdq_cfg( hba, CAM_TRUE ) != EOK ) {
+			break;
+		}
+	}
+
+	if( status != EOK ) {
+		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  task %d, flgs 0x%x, addr %d, blks %d, status 0x%x, rsp[0] 0x%x",
+			__FUNCTION__, tid, task->flgs, task->addr, task->blks, status, rsp[0] );
+		sdmmc_cmdq_recover( hba, status );
+		return( sdmmc_error( hba, ccb, status == ENXIO ? ENXIO : ETIMEDOUT ) );
+	}
+
+	ext->cmdq_tmap |= ( 1U << tid );
+
+	return( CAM_REQ_INPROG );
+}
+
+static struct sdio_cmd *sdmmc_cmdq_cmd( SIM_HBA *hba, int tid )
+{
+	SIM_SDMMC_EXT		*ext;
+	SDMMC_CMDQ_TASK		*task;
+	struct sdio_cmd		*cmd;
+	int					op;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	task	= &ext->cmdq_tasks[tid];
+	op		= ( task->flgs & SCF_DIR_IN ) ? MMC_EXECUTE_READ_TASK : MMC_EXECUTE_WRITE_TASK;
+
+	if( ( cmd = sdio_alloc_cmd( ) ) != NULL ) {
+		sdio_setup_cmd( cmd, SCF_CTYPE_ADTC | SCF_RSP_R1, op, tid << MMC_QTP_TASK_ID_SHFT );
+		sdio_setup_cmd_io( cmd, task->flgs, task->blks, ext->dev_inf.sector_size, task->sgl, task->sgc, task->ccb->cam_req_map );
+	}
+
+	return( cmd );
+}
+
+// pick a ready task, preferring one whose command was already set up
+static int sdmmc_cmdq_ready( SIM_HBA *hba, uint32_t qsr )
+{
+	SIM_SDMMC_EXT		*ext;
+	int					tid;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	for( tid = 0; tid < ext->cmdq_depth; tid++ ) {
+		if( ( qsr & ( 1U << tid ) ) && ext->cmdq_tasks[tid].cmd ) {
+			return( tid );
+		}
+	}
+
+	for( tid = 0; !( qsr & ( 1U << tid ) ); tid++ ) {
+		;
+	}
+
+	return( tid );
+}
+
+static void sdmmc_cmdq_execute( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT		*ext;
+	sdio_dev_info_t		*di;
+	SDMMC_CMDQ_TASK		*task;
+	CCB_SCSIIO			*ccb;
+	SDMMC_CMDQ_TASK		*ntask;
+	struct sdio_cmd		*cmd;
+	uint32_t			qsr;
+	uint32_t			cstatus;
+	uint32_t			timeout;
+	uint32_t			rsp[4];
+	int					polls;
+	int					tid;
+	int					status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	di		= &ext->dev_inf;
+	qsr		= 0;
+
+		// wait for the device to mark a queued task ready for execution
+	for( polls = 0; ; polls++ ) {
+		if( ( status = sdmmc_cmdq_ac( hba, MMC_SEND_STATUS, ( di->rca << 16 ) | MMC_SEND_STATUS_SQS, SCF_RSP_R1, rsp ) ) != EOK ) {
+			break;
+		}
+
+		if( ( qsr = rsp[0] & ext->cmdq_tmap ) ) {
+			break;
+		}
+
+		if( polls >= CMDQ_QSR_SPIN ) {
+			if( polls - CMDQ_QSR_SPIN >= CMDQ_QSR_TIMEOUT ) {
+				status = ETIMEDOUT;
+				break;
+			}
+			delay( 1 );
+		}
+	}
+
+	if( status != EOK ) {
+		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  queue status failure, tmap 0x%x, status 0x%x", __FUNCTION__, ext->cmdq_tmap, status );
+		sdmmc_cmdq_recover( hba, status );
+		return;
+	}
+
+	tid		= sdmmc_cmdq_ready( hba, qsr );
+	task	= &ext->cmdq_tasks[tid];
+	ccb		= task->ccb;
+	timeout	= ccb->cam_timeout * 1000;
+	cstatus	= CS_CMD_CMP;
+	rsp[0]	= 0;
+
+	if( ( cmd = task->cmd ) != NULL ) {
+		task->cmd = NULL;
+	}
+	else {
+		cmd = sdmmc_cmdq_cmd( hba, tid );
+	}
+
+		// set up the next ready task so the host can prepare its transfer
+	ntask	= NULL;
+	if( ( qsr &= ~( 1U << tid ) ) ) {
+		ntask = &ext->cmdq_tasks[sdmmc_cmdq_ready( hba, qsr )];
+		if( ntask->cmd == NULL ) {
+			ntask->cmd = sdmmc_cmdq_cmd( hba, ntask - ext->cmdq_tasks );
+		}
+	}
+
+	if( cmd == NULL ) {
+		status = ENOMEM;
+	}
+	else {
+		sdio_setup_cmd_next( cmd, ntask ? ntask->cmd : NULL );
+		status = sdio_send_cmd( ext->device, cmd, NULL, timeout, 0 );
+		sdio_cmd_status( cmd, &cstatus, rsp );
+		sdio_free_cmd( cmd );
+	}
+
+	if( status == EOK && ( task->flgs & SCF_DIR_OUT ) ) {
+		status = sdmmc_wait_prog( hba, rsp, timeout );
+	}
+
+	ext->cmdq_tmap &= ~( 1U << tid );
+
+	if( ( rsp[0] & CDS_URGENT_BKOPS ) ) {
+		ext->bkops_status = ECSD_BS_OPERATIONS_CRITICAL;
+	}
+
+	if( status == EOK ) {
+		if( ( task->flgs & SCF_DIR_IN ) ) {
+			task->part->rc += task->blks;
+		}
+		else {
+			task->part->wc += task->blks;
+		}
+		sdmmc_ios_rw( hba, task->part, task->flgs, task->blks, task->qtime );		// queued to done, includes time in the device queue
+
+		ccb->cam_ch.cam_status = CAM_REQ_CMP;
+		sdmmc_post_ccb( hba, ccb );
+		return;
+	}
+
+	if( status != ENXIO ) {
+		status = ETIMEDOUT;			// set timeout so CAM layer will retry
+
+		if( ( rsp[0] & ( CDS_ERROR | CDS_CARD_ECC_FAILED ) ) ) {
+			status = EIO;
+		}
+		if( ( rsp[0] & CDS_WP_VIOLATION ) ) {
+			status = EROFS;
+		}
+		if( ( rsp[0] & CDS_CARD_IS_LOCKED ) ) {
+			status = EACCES;
+		}
+	}
+
+	cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  task %d, flgs 0x%x, addr %d, blks %d, status 0x%x, cstatus 0x%x, rsp[0] 0x%x",
+		__FUNCTION__, tid, task->flgs, task->addr, task->blks, status, cstatus, rsp[0] );
+
+	sdmmc_cmdq_recover( hba, status );
+
+	ccb->cam_ch.cam_status = sdmmc_error( hba, ccb, status );
+	sdmmc_post_ccb( hba, ccb );
+}
+
+void sdmmc_cmdq_start_ccb( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT	*ext;
+	CCB_SCSIIO		*ccb;
+	int				status;
+	int				legacy;
+
+	ext = (SIM_SDMMC_EXT *)hba->ext;
+
+	while( 1 ) {
+			// queue ccbs until the device queue is full or a ccb has to wait for it to drain
+		while( ext->cmdq_hold == NULL && ext->cmdq_tmap != CMDQ_TMAP_FULL( ext ) ) {
+			if( ( ccb = sdmmc_ccb_dequeue( hba ) ) == NULL ) {
+				break;
+			}
+
+			sdmmc_pm( hba, PM_ACTIVE );
+
+			if( !sdmmc_cmdq_queueable( hba, ccb ) ) {
+				ext->cmdq_hold = ccb;
+				break;
+			}
+
+			if( ( status = sdmmc_cmdq_queue( hba, ccb ) ) != CAM_REQ_INPROG ) {
+				ccb->cam_ch.cam_status = status;
+				sdmmc_post_ccb( hba, ccb );
+			}
+		}
+
+		if( ext->cmdq_tmap ) {
+			sdmmc_cmdq_execute( hba );
+			continue;
+		}
+
+		if( ( ccb = ext->cmdq_hold ) == NULL ) {
+			break;
+		}
+
+		ext->cmdq_hold = NULL;
+
+		if( sdmmc_cmdq_queueable( hba, ccb ) ) {
+			if( ( status = sdmmc_cmdq_queue( hba, ccb ) ) != CAM_REQ_INPROG ) {
+				ccb->cam_ch.cam_status = status;
+				sdmmc_post_ccb( hba, ccb );
+			}
+			continue;
+		}
+
+		if( ( legacy = sdmmc_cmdq_legacy( ccb ) ) ) {
+			sdmmc_cmdq_cfg( hba, CAM_FALSE );
+		}
+
+		ext->nexus = ccb;
+		sdmmc_process_ccb( hba, ccb );
+
+		if( legacy ) {
+			sdmmc_cmdq_cfg( hba, CAM_TRUE );
+		}
+	}
+
+	ext->nexus = NULL;
+
+#ifdef SDMMC_AGGRESSIVE_PM
+	sdio_pwrmgnt( ext->device, PM_IDLE );
+#endif
+}
@@ -293,9 +293,26 @@ int sdmmc_detach( SIM_HBA *hba )
 	}
 
 	if( hba->simq ) {
+			// fail ccbs the driver thread had already taken off the queue
+		while( ext->merge_nccbs ) {
+			ext->merge_ccbs[--ext->merge_nccbs]->cam_ch.cam_status = CAM_REQ_ABORTED;
+			sdmmc_post_ccb( hba, ext->merge_ccbs[ext->merge_nccbs] );
+		}
+
+		if( ext->lookahead ) {
+			ext->lookahead->cam_ch.cam_status = CAM_REQ_ABORTED;
+			sdmmc_post_ccb( hba, ext->lookahead );
+			ext->lookahead = NULL;
+		}
+
 		simq_dinit( hba->simq );
 	}
 
+	if( ext->rw_prep ) {
+		sdio_free_cmd( ext->rw_prep );
+		ext->rw_prep = NULL;
+	}
+
 	if( ext->device ) {
 		sdio_detach( ext->device );
 	}
@@ -306,6 +323,10 @@ int sdmmc_detach( SIM_HBA *hba )
 	}
 #endif
 
+	if( ext->packed_hdr ) {
+		xpt_free( ext->packed_hdr, SDMMC_PACKED_HDR_SIZE );
+	}
+
 	sdmmc_free_hba( hba );
 
 	return( CAM_SUCCESS );
@@ -336,6 +357,14 @@ int sdmmc_reg( SIM_HBA *hba )
 	ext->ver_paddr = xpt_vtop( ext->ver_vaddr, NULL );
 #endif
 
+	if( ( ext->eflags & SDMMC_EFLAG_PACKED ) ) {
+		if( ( ext->packed_hdr = xpt_alloc( XPT_ALLOC_CONTIG | XPT_ALLOC_NOCACHE, SDMMC_PACKED_HDR_SIZE, &ext->packed_paddr ) ) == MAP_FAILED ) {
+			cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s: xpt_alloc packed header failure", __FUNCTION__ );
+			ext->packed_hdr = NULL;
+			atomic_clr( &ext->eflags, SDMMC_EFLAG_PACKED );
+		}
+	}
+
 	if( cam_create_thread( &hba->tid, &attr, sdmmc_driver_thread, hba, ext->priority, &hba->state, "sdmmc_driver_thread" ) != EOK ) {
 		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s: sdmmc_driver_thread creation failure", __FUNCTION__ );
 		return( CAM_FAILURE );
@@ -388,6 +417,12 @@ int sdmmc_attach( SIM_HBA *hba, struct sdio_connection *connection, sdio_device_
 			}
 		}
 
+		if( ( ext->eflags & SDMMC_EFLAG_CMDQ ) ) {
+			if( sdmmc_cmdq_init( hba ) != EOK ) {
+				ext->eflags &= ~SDMMC_EFLAG_CMDQ;
+			}
+		}
+
 		if( ( ext->dev_inf.caps & DEV_CAP_ASSD ) ) {
 			sdmmc_assd_init( hba );
 		}
@@ -465,6 +500,11 @@ int sdmmc_post_ccb( SIM_HBA *hba, CCB_SCSIIO *ccb )
 
 	ext->nexus = NULL;
 
+	if( ext->rw_prep && ext->rw_prep_ccb == ccb ) {		// prepared command wasn't used
+		sdio_free_cmd( ext->rw_prep );
+		ext->rw_prep = NULL;
+	}
+
 #ifdef SDMMC_TRACE
 	sdmmc_trace_event( SDMMC_TRACE_EVENT, "%s:  ccb %p", __FUNCTION__, ccb );
 #endif
@@ -762,6 +802,10 @@ int sdmmc_std_inquiry( SIM_HBA *hba, CCB_SCSIIO *ccb )
 	iptr->version		= INQ_VER_SPC3;		// SPC-3
 	iptr->adlen			= 96 - 5;	// nbytes after adlen field
 
+	if( ( ext->eflags & SDMMC_EFLAG_CMDQ ) ) {
+		iptr->flags		|= INQ_CMD_QUE;
+	}
+
 	strlcpy( (char *)iptr->vend_id, "SDMMC:", sizeof( iptr->vend_id ) );
 	strlcpy( (char *)iptr->prod_id, (char *)ext->dev_inf.pnm, sizeof( iptr->prod_id ) );
 
@@ -920,14 +964,17 @@ int sdmmc_sync( SIM_HBA *hba, CCB_SCSIIO *ccb )
 {
 	SIM_SDMMC_EXT	*ext;
 	int				status;
+	_Uint64t		start;
 
 	ext		= (SIM_SDMMC_EXT *)hba->ext;
 
 	if( ( status = sdmmc_unit_ready( hba, ccb ) ) == CAM_REQ_CMP ) {
 		if( ( ext->dev_inf.caps & DEV_CAP_CACHE ) && ( ext->eflags & SDMMC_EFLAG_CACHE ) ) {
+			start = ClockCycles( );
 			if( ( status = sdio_cache( ext->device, SDIO_CACHE_FLUSH, SDIO_TIME_DEFAULT * 5 ) ) != EOK ) {
 				status = sdmmc_error( hba, ccb, status );
 			}
+			sdmmc_ios_time( hba, &ext->ios_flush, start );
 		}
 	}
 	return( status ? status : CAM_REQ_CMP );
@@ -1075,6 +1122,7 @@ int sdmmc_bkops( SIM_HBA *hba, int tick )
 {
 	SIM_SDMMC_EXT	*ext;
 	uint8_t			ecsd[MMC_EXT_CSD_SIZE];
+	_Uint64t		start;
 
 	ext		= (SIM_SDMMC_EXT *)hba->ext;
 
@@ -1116,9 +1164,11 @@ int sdmmc_bkops( SIM_HBA *hba, int tick )
 			// fall through
 
 		case BKOPS_STATUS_OPERATIONS_CRITICAL:
+			start = ClockCycles( );
 			if( sdio_mmc_switch( ext->device, MMC_SWITCH_CMDSET_DFLT, MMC_SWITCH_MODE_WRITE, ECSD_BKOPS_START, ECSD_BKOPS_INITIATE, SDIO_TIME_DEFAULT ) == EOK ) {
 				ext->bkops_status	= BKOPS_STATUS_OPERATIONS_NONE;
 				ext->bkops_ticks	= 0;
+				sdmmc_ios_time( hba, &ext->ios_bkops, start );
 			}
 			else {
 				cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s: BKOPS_START failure", __FUNCTION__ );
@@ -1269,10 +1319,13 @@ int sdmmc_set_partition_attr( SIM_HBA *hba, int partition, int flags )
 int sdmmc_reset( SIM_HBA *hba )
 {
 	SIM_SDMMC_EXT	*ext;
+	_Uint64t		start;
 
 	ext		= (SIM_SDMMC_EXT *)hba->ext;
 
+	start	= ClockCycles( );
 	sdio_reset( ext->device );
+	sdmmc_ios_time( hba, &ext->ios_reset, start );
 
 	if( ( ext->dev_inf.caps & DEV_CAP_CACHE ) && ( ext->eflags & SDMMC_EFLAG_CACHE ) ) {
 		// Mark device user partition as read only/write protected after a reset when eMMC cache is enabled.
@@ -1285,6 +1338,265 @@ int sdmmc_reset( SIM_HBA *hba )
 	return( EOK );
 }
 
+static sdio_sge_t *sdmmc_ccb_sgl( CCB_SCSIIO *ccb, sdio_sge_t *sge, int *sgc )
+{
+	if( ( ccb->cam_ch.cam_flags & CAM_SCATTER_VALID ) ) {
+		*sgc			= ccb->cam_sglist_cnt;
+		return( (sdio_sge_t *)ccb->cam_data.cam_sg_ptr );
+	}
+
+	*sgc			= 1;
+	sge->sg_count	= ccb->cam_dxfer_len;
+	sge->sg_address	= ccb->cam_data.cam_data_ptr;
+
+	return( sge );
+}
+
+static uint32_t sdmmc_ccb_lba( SDMMC_PARTITION *part, CCB_SCSIIO *ccb )
+{
+	uint32_t		lba;
+
+	lba		= ENDIAN_BE32( UNALIGNED_RET32( &ccb->cam_cdb_io.cam_cdb_bytes[2] ) );
+
+	if( part->blk_shft ) {
+		lba <<= part->blk_shft;
+	}
+
+	return( lba + part->slba );
+}
+
+static int sdmmc_rw_flags( SIM_HBA *hba, int flgs, int dlen )
+{
+	SIM_SDMMC_EXT		*ext;
+	sdio_dev_info_t		*di;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	di		= &ext->dev_inf;
+
+	if( dlen > di->sector_size ) {
+		if( !( ext->hc_inf.caps & HC_CAP_ACMD12 ) && !( flgs & SCF_PACKED ) ) {
+			if( ( di->caps & DEV_CAP_CMD23 ) ) {
+				flgs |= SCF_SBC;
+			}
+		}
+		flgs |= SCF_MULTIBLK;
+	}
+
+	return( flgs );
+}
+
+static struct sdio_cmd *sdmmc_rw_cmd( SIM_HBA *hba, int flgs, uint32_t addr, int dlen, sdio_sge_t *sgl, int sgc, void *mhdl )
+{
+	SIM_SDMMC_EXT		*ext;
+	struct sdio_cmd		*cmd;
+	int					op;
+	int					blksz;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	blksz	= ext->dev_inf.sector_size;
+	op		= ( flgs & SCF_DIR_IN ) ? MMC_READ_SINGLE_BLOCK : MMC_WRITE_BLOCK;
+
+	if( ( flgs & SCF_MULTIBLK ) ) {
+		op++;
+	}
+
+	if( ( cmd = sdio_alloc_cmd( ) ) == NULL ) {
+		return( NULL );
+	}
+
+	sdio_setup_cmd( cmd, SCF_CTYPE_ADTC | SCF_RSP_R1, op, addr );
+	sdio_setup_cmd_io( cmd, flgs, dlen / blksz, blksz, sgl, sgc, mhdl );
+
+	return( cmd );
+}
+
+static _Uint64t sdmmc_ios_ns( SIM_SDMMC_EXT *ext, _Uint64t start )
+{
+	_Uint64t	cycles;
+
+	cycles = ClockCycles( ) - start;
+
+	return( ( cycles / ext->ios_cps ) * 1000000000ULL + ( ( cycles % ext->ios_cps ) * 1000000000ULL ) / ext->ios_cps );
+}
+
+static void sdmmc_ios_hist( SDMMC_IO_HIST *ioh, int blks, _Uint64t ns )
+{
+	_Uint64t	us;
+	int			bkt;
+
+	for( us = ( ns / 1000 ) >> 6, bkt = 0; us && bkt < SDMMC_IOS_BUCKETS - 1; us >>= 1, bkt++ ) {
+		;
+	}
+
+	ioh->cnt++;
+	ioh->blks		+= blks;
+	ioh->total_ns	+= ns;
+	ioh->bucket[bkt]++;
+	if( ns > ioh->max_ns ) {
+		ioh->max_ns = ns;
+	}
+}
+
+void sdmmc_ios_time( SIM_HBA *hba, SDMMC_IO_TIME *iot, _Uint64t start )
+{
+	_Uint64t	ns;
+
+	ns = sdmmc_ios_ns( (SIM_SDMMC_EXT *)hba->ext, start );
+
+	iot->cnt++;
+	iot->total_ns += ns;
+	if( ns > iot->max_ns ) {
+		iot->max_ns = ns;
+	}
+}
+
+// Account a completed read/write against its partition by direction and transfer size.
+void sdmmc_ios_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, int blks, _Uint64t start )
+{
+	SIM_SDMMC_EXT	*ext;
+	int				bytes;
+	int				sc;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	bytes	= blks * ext->dev_inf.sector_size;
+
+	if( bytes <= 4096 ) {
+		sc = SDMMC_IOS_SIZE_4K;
+	}
+	else if( bytes <= 16384 ) {
+		sc = SDMMC_IOS_SIZE_16K;
+	}
+	else if( bytes <= 65536 ) {
+		sc = SDMMC_IOS_SIZE_64K;
+	}
+	else if( bytes <= 262144 ) {
+		sc = SDMMC_IOS_SIZE_256K;
+	}
+	else {
+		sc = SDMMC_IOS_SIZE_LARGE;
+	}
+
+	sdmmc_ios_hist( ( flgs & SCF_DIR_IN ) ? &part->ios_rd[sc] : &part->ios_wr[sc], blks, sdmmc_ios_ns( ext, start ) );
+}
+
+// simq_ccb_dequeue() wrapper that accounts the time a read/write ccb
+// waited in the CAM queue and how deep the queue was when it left.
+CCB_SCSIIO *sdmmc_ccb_dequeue( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT	*ext;
+	SDMMC_PARTITION	*part;
+	CCB_SCSIIO		*ccb;
+	_Uint32t		qdepth;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	qdepth	= hba->simq->qcnt;
+
+	if( ( ccb = simq_ccb_dequeue( hba->simq ) ) == NULL || ccb->cam_ch.cam_func_code != XPT_SCSI_IO ) {
+		return( ccb );
+	}
+
+	part = &ext->targets[ccb->cam_ch.cam_target_id].partitions[ccb->cam_ch.cam_target_lun];
+
+	sdmmc_ios_hist( &part->ios_qwait, ccb->cam_dxfer_len / ext->dev_inf.sector_size, sdmmc_ios_ns( ext, SDMMC_CCB_PRIV( ccb )->qtime ) );
+	part->ios_qdepth_sum += qdepth;
+	if( qdepth > part->ios_qdepth_max ) {
+		part->ios_qdepth_max = qdepth;
+	}
+
+	return( ccb );
+}
+
+// Dequeue the next ccb and set up its read/write command, so the host
+// can prepare the data transfer while the current command is on the bus.
+static struct sdio_cmd *sdmmc_rw_lookahead( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT		*ext;
+	CCB_SCSIIO			*ccb;
+	SDMMC_PARTITION		*part;
+	sdio_dev_info_t		*di;
+	sdio_sge_t			*sgp;
+	uint32_t			lba;
+	int					sgc;
+	int					flgs;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	di		= &ext->dev_inf;
+
+	if( ( ext->eflags & SDMMC_EFLAG_CMDQ ) || ext->rw_prep ) {
+		return( NULL );
+	}
+
+	if( ext->lookahead == NULL ) {
+		ext->lookahead = sdmmc_ccb_dequeue( hba );
+	}
+
+	if( ( ccb = ext->lookahead ) == NULL || ccb->cam_ch.cam_func_code != XPT_SCSI_IO || !ccb->cam_dxfer_len ) {
+		return( NULL );
+	}
+
+	switch( ccb->cam_cdb_io.cam_cdb_bytes[0] ) {
+		case SC_READ10:
+			flgs = SCF_DIR_IN;
+			break;
+
+		case SC_WRITE10:
+			flgs = SCF_DIR_OUT;
+			break;
+
+		default:
+			return( NULL );
+	}
+
+	if( ( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) ) {
+		if( !( ext->hc_inf.caps & HC_CAP_DMA ) ) {
+			return( NULL );
+		}
+		flgs |= SCF_DATA_PHYS;
+	}
+
+	part	= &ext->targets[ccb->cam_ch.cam_target_id].partitions[ccb->cam_ch.cam_target_lun];
+	if( ( part->config & MMC_PART_MSK ) == MMC_PART_RPMB ) {
+		return( NULL );
+	}
+
+	sgp		= sdmmc_ccb_sgl( ccb, &ext->rw_prep_sge, &sgc );
+	lba		= sdmmc_ccb_lba( part, ccb );
+	lba		= ( di->caps & DEV_CAP_HC ) ? lba : ( lba * di->sector_size );
+	flgs	= sdmmc_rw_flags( hba, flgs, ccb->cam_dxfer_len );
+
+	if( ( ext->rw_prep = sdmmc_rw_cmd( hba, flgs, lba, ccb->cam_dxfer_len, sgp, sgc, ccb->cam_req_map ) ) != NULL ) {
+		ext->rw_prep_ccb = ccb;
+	}
+
+	return( ext->rw_prep );
+}
+
+// Wait for the card to finish programming a write.  Hosts with
+// HC_CAP_BSY_DATA only complete the transfer once DAT0 busy ends, so a
+// single CMD13 picks up the errors the card reports after programming.
+// The others, or a card still not back in tran, are polled.
+int sdmmc_wait_prog( SIM_HBA *hba, uint32_t *rsp, uint32_t timeout )
+{
+	SIM_SDMMC_EXT	*ext;
+	int				status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	if( ( ext->hc_inf.caps & HC_CAP_BSY_DATA ) ) {
+		if( ( status = sdio_send_status( ext->device, rsp, 0 ) ) != EOK ) {
+			return( status );
+		}
+		if( ( rsp[0] & CDS_ERROR_MSK ) ) {
+			return( EIO );
+		}
+		if( ( rsp[0] & ( CDS_READY_FOR_DATA | CDS_CUR_STATE_MSK ) ) == ( CDS_READY_FOR_DATA | CDS_CUR_STATE_TRAN ) ) {
+			return( EOK );
+		}
+	}
+
+	return( sdio_wait_card_status( ext->device, rsp, CDS_READY_FOR_DATA | CDS_CUR_STATE_MSK, CDS_READY_FOR_DATA | CDS_CUR_STATE_TRAN, timeout ) );
+}
+
 int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int dlen, sdio_sge_t *sgl, int sgc, void *mhdl, uint32_t timeout )
 {
 	SIM_SDMMC_EXT		*ext;
@@ -1292,13 +1604,13 @@ int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int
 	sdio_dev_info_t		*di;
 	struct sdio_device	*dev;
 	int					rst;
-	int					op;
 	int					blks;
 	int					blksz;
 	int					status;
 	int					bus_err;
 	uint32_t			cstatus;
 	uint32_t			rsp[4];
+	_Uint64t			start;
 
 	ext		= (SIM_SDMMC_EXT *)hba->ext;
 	dev		= ext->device;
@@ -1310,28 +1622,19 @@ int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int
 	blksz	= di->sector_size;
 	blks	= dlen / blksz;
 	addr	= ( di->caps & DEV_CAP_HC ) ? addr : ( addr * blksz );
-	op		= ( flgs & SCF_DIR_IN ) ? MMC_READ_SINGLE_BLOCK : MMC_WRITE_BLOCK;
-
-	if( dlen > blksz ) {
-		if( !( ext->hc_inf.caps & HC_CAP_ACMD12 ) ) {
-			if( ( di->caps & DEV_CAP_CMD23 ) ) {
-				flgs |= SCF_SBC;
-			}
-		}
-		flgs |= SCF_MULTIBLK;
-	}
+	flgs	= sdmmc_rw_flags( hba, flgs, dlen );
 
-	if( ( flgs & SCF_MULTIBLK ) ) {
-		op++;
+	if( ext->rw_prep && ext->rw_prep_ccb == ext->nexus ) {		// set up while the previous command was on the bus
+		cmd				= ext->rw_prep;
+		ext->rw_prep	= NULL;
 	}
-
-	if( ( cmd = sdio_alloc_cmd( ) ) == NULL ) {
+	else if( ( cmd = sdmmc_rw_cmd( hba, flgs, addr, dlen, sgl, sgc, mhdl ) ) == NULL ) {
 		return( ENOMEM );
 	}
 
-	sdio_setup_cmd( cmd, SCF_CTYPE_ADTC | SCF_RSP_R1, op, addr );
-	sdio_setup_cmd_io( cmd, flgs, blks, blksz, sgl, sgc, mhdl );
-	status = sdio_send_cmd( dev, cmd, NULL, timeout, 0 );
+	sdio_setup_cmd_next( cmd, sdmmc_rw_lookahead( hba ) );
+	start	= ClockCycles( );
+	status	= sdio_send_cmd( dev, cmd, NULL, timeout, 0 );
 	sdio_cmd_status( cmd, &cstatus, rsp );
 	sdio_free_cmd( cmd );
 
@@ -1348,15 +1651,16 @@ int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int
 	}
 	else {
 		if( ( flgs & SCF_MULTIBLK ) ) {
-			if( ( !( flgs & SCF_SBC ) && ( dlen > blksz ) && !( ext->hc_inf.caps & HC_CAP_ACMD12 ) ) ) {
+			if( ( !( flgs & ( SCF_SBC | SCF_PACKED ) ) && ( dlen > blksz ) && !( ext->hc_inf.caps & HC_CAP_ACMD12 ) ) ) {
 				if( sdio_stop_transmission( dev, 0 ) ) {
 					status = ETIMEDOUT;
 				}
 			}
 		}
 
+			// the card status after programming replaces the CMD25 R1 for the error checks below
 		if( status == EOK && ( flgs & SCF_DIR_OUT ) ) {
-			if( ( status = sdio_wait_card_status( dev, rsp, CDS_READY_FOR_DATA | CDS_CUR_STATE_MSK, CDS_READY_FOR_DATA | CDS_CUR_STATE_TRAN, timeout ) ) ) {
+			if( ( status = sdmmc_wait_prog( hba, rsp, timeout ) ) ) {
 				sdio_stop_transmission( dev, 0 );
 			}
 		}
@@ -1367,7 +1671,10 @@ int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int
 				part->rc += blks;
 			}
 			else {
-				part->wc += blks;
+				part->wc += ( flgs & SCF_PACKED ) ? blks - 1 : blks;		// don't count the packed header
+			}
+			if( status == EOK ) {
+				sdmmc_ios_rw( hba, part, flgs, ( flgs & SCF_PACKED ) ? blks - 1 : blks, start );
 			}
 		}
 	}
@@ -1417,6 +1724,11 @@ int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int
 	}
 
 	if( status ) {
+		if( ext->rw_prep ) {			// device state may change, set it up again when issued
+			sdio_free_cmd( ext->rw_prep );
+			ext->rw_prep = NULL;
+		}
+
 			// reset when we are not ready for data and in the transfer state
 		if( rst || sdio_send_status( dev, rsp, 0 ) || ( rsp[0] & ( CDS_READY_FOR_DATA | CDS_CUR_STATE_MSK ) ) != ( CDS_READY_FOR_DATA | CDS_CUR_STATE_TRAN ) ) {
 			sdmmc_reset( hba );
@@ -1530,13 +1842,260 @@ int sdmmc_write_verify( SIM_HBA *hba, CCB_SCSIIO *ccb )
 }
 #endif
 
+// Pull ccbs that continue the nexus transfer (same partition, direction
+// and cdb flags, contiguous lba) off the simq and append their scatter
+// lists, so they go out as one multi-block command.  Stops at the first
+// ccb that doesn't fit, which is left in lookahead to be processed next.
+static int sdmmc_rw_merge( SIM_HBA *hba, CCB_SCSIIO *ccb, SDMMC_PARTITION *part, uint32_t lba, sdio_sge_t **sgl, int *sgc, int *dlen, uint32_t *timeout )
+{
+	SIM_SDMMC_EXT	*ext;
+	CCB_SCSIIO		*nccb;
+	sdio_sge_t		*nsgp;
+	sdio_sge_t		sge;
+	uint32_t		blksz;
+	uint32_t		sg_max;
+	int				nsgc;
+
+	ext					= (SIM_SDMMC_EXT *)hba->ext;
+	ext->merge_nccbs	= 0;
+	blksz				= ext->dev_inf.sector_size;
+	sg_max				= min( ext->hc_inf.sg_max, SDMMC_MAX_SG );
+
+	if( !( ext->eflags & SDMMC_EFLAG_MERGE ) || ( ext->eflags & SDMMC_EFLAG_CMDQ ) || *sgc >= sg_max ) {
+		return( 0 );
+	}
+
+	while( ext->merge_nccbs + 1 < ext->merge_max ) {
+		if( ext->lookahead == NULL && ( ext->lookahead = sdmmc_ccb_dequeue( hba ) ) == NULL ) {
+			break;
+		}
+
+		nccb = ext->lookahead;
+		if( nccb->cam_ch.cam_func_code != XPT_SCSI_IO || !nccb->cam_dxfer_len ||
+				memcmp( nccb->cam_cdb_io.cam_cdb_bytes, ccb->cam_cdb_io.cam_cdb_bytes, 2 ) ||
+				nccb->cam_ch.cam_target_id != ccb->cam_ch.cam_target_id ||
+				nccb->cam_ch.cam_target_lun != ccb->cam_ch.cam_target_lun ||
+				( ( nccb->cam_ch.cam_flags ^ ccb->cam_ch.cam_flags ) & CAM_DATA_PHYS ) ) {
+			break;
+		}
+
+			// virtual buffers are translated with a single map
+		if( !( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) && nccb->cam_req_map != ccb->cam_req_map ) {
+			break;
+		}
+
+		if( sdmmc_ccb_lba( part, nccb ) != lba + *dlen / blksz ||
+				( *dlen + nccb->cam_dxfer_len ) / blksz > SDMMC_MERGE_BLKS_MAX ) {
+			break;
+		}
+
+		nsgp = sdmmc_ccb_sgl( nccb, &sge, &nsgc );
+		if( *sgc + nsgc > sg_max ) {
+			break;
+		}
+
+		if( *sgl != ext->merge_sgl ) {
+			memcpy( ext->merge_sgl, *sgl, *sgc * sizeof( sdio_sge_t ) );
+			*sgl = ext->merge_sgl;
+		}
+
+		memcpy( &ext->merge_sgl[*sgc], nsgp, nsgc * sizeof( sdio_sge_t ) );
+		*sgc									+= nsgc;
+		*dlen									+= nccb->cam_dxfer_len;
+		*timeout								= max( *timeout, nccb->cam_timeout );
+		ext->merge_ccbs[ext->merge_nccbs++]		= nccb;
+		ext->lookahead							= NULL;
+	}
+
+		// a command prepared for the nexus or a merged ccb covers only that ccb
+	if( ext->merge_nccbs && ext->rw_prep && ext->rw_prep_ccb != ext->lookahead ) {
+		sdio_free_cmd( ext->rw_prep );
+		ext->rw_prep = NULL;
+	}
+
+	return( ext->merge_nccbs );
+}
+
+// Pull queued writes to the same partition (any lba) off the simq and
+// build an eMMC packed write: a header block listing each write's block
+// count and address, followed by the data of every write in order.
+static int sdmmc_rw_pack( SIM_HBA *hba, CCB_SCSIIO *ccb, SDMMC_PARTITION *part, uint32_t lba, sdio_sge_t **sgl, int *sgc, int *dlen, uint32_t *timeout )
+{
+	SIM_SDMMC_EXT	*ext;
+	sdio_dev_info_t	*di;
+	CCB_SCSIIO		*nccb;
+	sdio_sge_t		*nsgp;
+	sdio_sge_t		sge;
+	uint32_t		*hdr;
+	uint8_t			*ecsd;
+	uint32_t		blksz;
+	uint32_t		sg_max;
+	uint32_t		nmax;
+	uint32_t		nlba;
+	int				nsgc;
+	int				plen;
+	int				psgc;
+
+	ext					= (SIM_SDMMC_EXT *)hba->ext;
+	di					= &ext->dev_inf;
+	ext->merge_nccbs	= 0;
+	blksz				= di->sector_size;
+	sg_max				= min( ext->hc_inf.sg_max, SDMMC_MAX_SG );
+	hdr					= ext->packed_hdr;
+
+	if( !( ext->eflags & SDMMC_EFLAG_PACKED ) || ( ext->eflags & SDMMC_EFLAG_CMDQ ) ||
+			!( di->caps & DEV_CAP_PACKED ) || !( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) ||
+			blksz > SDMMC_PACKED_HDR_SIZE || *sgc + 1 >= sg_max ) {
+		return( 0 );
+	}
+
+		// limited by the device, the option and the entries that fit in the header
+	ecsd	= sdio_get_raw_ecsd( ext->device );
+	nmax	= min( ext->packed_max, ecsd[ECSD_MAX_PACKED_WRITES] );
+	nmax	= min( nmax, blksz / ( 2 * sizeof( uint32_t ) ) - 1 );
+
+	memcpy( &ext->merge_sgl[1], *sgl, *sgc * sizeof( sdio_sge_t ) );
+	psgc	= *sgc + 1;
+	plen	= *dlen + blksz;
+
+	while( ext->merge_nccbs + 1 < nmax ) {
+		if( ext->lookahead == NULL && ( ext->lookahead = sdmmc_ccb_dequeue( hba ) ) == NULL ) {
+			break;
+		}
+
+		nccb = ext->lookahead;
+		if( nccb->cam_ch.cam_func_code != XPT_SCSI_IO || !nccb->cam_dxfer_len ||
+				memcmp( nccb->cam_cdb_io.cam_cdb_bytes, ccb->cam_cdb_io.cam_cdb_bytes, 2 ) ||
+				nccb->cam_ch.cam_target_id != ccb->cam_ch.cam_target_id ||
+				nccb->cam_ch.cam_target_lun != ccb->cam_ch.cam_target_lun ||
+				!( nccb->cam_ch.cam_flags & CAM_DATA_PHYS ) ) {
+			break;
+		}
+
+		nsgp = sdmmc_ccb_sgl( nccb, &sge, &nsgc );
+		if( psgc + nsgc > sg_max || ( plen + nccb->cam_dxfer_len ) / blksz > MMC_SBC_BLKS_MAX ) {
+			break;
+		}
+
+		memcpy( &ext->merge_sgl[psgc], nsgp, nsgc * sizeof( sdio_sge_t ) );
+		psgc									+= nsgc;
+		plen									+= nccb->cam_dxfer_len;
+		*timeout								= max( *timeout, nccb->cam_timeout );
+		ext->merge_ccbs[ext->merge_nccbs++]		= nccb;
+		ext->lookahead							= NULL;
+	}
+
+	if( !ext->merge_nccbs ) {
+		return( 0 );
+	}
+
+	memset( hdr, 0, blksz );
+	hdr[0]	= ENDIAN_LE32( MMC_PACKED_HDR( ext->merge_nccbs + 1, MMC_PACKED_CMD_WRITE ) );
+	hdr[2]	= ENDIAN_LE32( *dlen / blksz );
+	hdr[3]	= ENDIAN_LE32( ( di->caps & DEV_CAP_HC ) ? lba : ( lba * blksz ) );
+
+	for( nsgc = 0; nsgc < ext->merge_nccbs; nsgc++ ) {
+		nccb					= ext->merge_ccbs[nsgc];
+		nlba					= sdmmc_ccb_lba( part, nccb );
+		hdr[( nsgc + 2 ) * 2]		= ENDIAN_LE32( nccb->cam_dxfer_len / blksz );
+		hdr[( nsgc + 2 ) * 2 + 1]	= ENDIAN_LE32( ( di->caps & DEV_CAP_HC ) ? nlba : ( nlba * blksz ) );
+	}
+
+	ext->merge_sgl[0].sg_address	= ext->packed_paddr;
+	ext->merge_sgl[0].sg_count		= blksz;
+	*sgl							= ext->merge_sgl;
+	*sgc							= psgc;
+	*dlen							= plen;
+
+	if( ext->rw_prep && ext->rw_prep_ccb != ext->lookahead ) {
+		sdio_free_cmd( ext->rw_prep );
+		ext->rw_prep = NULL;
+	}
+
+	return( ext->merge_nccbs );
+}
+
+// Number of packed entries the device completed before it failed,
+// from the packed command status the device latched in EXT_CSD.
+static int sdmmc_rw_pack_status( SIM_HBA *hba )
+{
+	SIM_SDMMC_EXT	*ext;
+	uint8_t			ecsd[MMC_EXT_CSD_SIZE];
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+
+	if( sdio_send_ext_csd( ext->device, ecsd ) != EOK ) {
+		return( 0 );
+	}
+
+	cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  packed status 0x%x, failure index %d, exception 0x%x", __FUNCTION__,
+			ecsd[ECSD_PACKED_CMD_STATUS], ecsd[ECSD_PACKED_FAILURE_INDEX], ecsd[ECSD_EXP_EVENTS_STATUS] );
+
+	if( ( ecsd[ECSD_PACKED_CMD_STATUS] & ECSD_PCS_INDEXED_ERROR ) && ecsd[ECSD_PACKED_FAILURE_INDEX] ) {
+		return( min( ecsd[ECSD_PACKED_FAILURE_INDEX] - 1, ext->merge_nccbs + 1 ) );
+	}
+
+	return( 0 );
+}
+
+// Complete the ccbs merged behind the nexus.  If the combined transfer
+// failed, the first ndone ccbs (the nexus being the first) are known to
+// have completed, issue each of the others on its own so errors are
+// reported against the ccb they belong to.  Returns the status for the nexus.
+static int sdmmc_rw_merge_cmplt( SIM_HBA *hba, CCB_SCSIIO *ccb, SDMMC_PARTITION *part, int flgs, int status, int ndone )
+{
+	SIM_SDMMC_EXT	*ext;
+	CCB_SCSIIO		*mccb;
+	sdio_sge_t		*sgp;
+	sdio_sge_t		sge;
+	int				sgc;
+	int				idx;
+	int				mstatus;
+	int				xstatus;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	xstatus	= status;			// status of the combined transfer
+
+	if( status != EOK && status != ENXIO ) {
+		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  merged transfer of %d ccbs failed (%d), %d done, splitting", __FUNCTION__, ext->merge_nccbs + 1, status, ndone );
+		if( ndone ) {
+			status = EOK;
+		}
+		else {
+			sgp		= sdmmc_ccb_sgl( ccb, &sge, &sgc );
+			status	= sdmmc_rw( hba, part, flgs, sdmmc_ccb_lba( part, ccb ), ccb->cam_dxfer_len, sgp, sgc, ccb->cam_req_map, ccb->cam_timeout );
+		}
+	}
+
+	for( idx = 0; idx < ext->merge_nccbs; idx++ ) {
+		mccb	= ext->merge_ccbs[idx];
+		mstatus	= ( idx + 1 < ndone ) ? EOK : xstatus;
+
+		if( mstatus != EOK && mstatus != ENXIO ) {
+			sgp		= sdmmc_ccb_sgl( mccb, &sge, &sgc );
+			mstatus	= sdmmc_rw( hba, part, flgs, sdmmc_ccb_lba( part, mccb ), mccb->cam_dxfer_len, sgp, sgc, mccb->cam_req_map, mccb->cam_timeout );
+		}
+
+		mccb->cam_ch.cam_status = mstatus ? sdmmc_error( hba, mccb, mstatus ) : CAM_REQ_CMP;
+		sdmmc_post_ccb( hba, mccb );
+	}
+
+	ext->merge_nccbs	= 0;
+	ext->nexus			= ccb;		// still owned by the caller
+
+	return( status );
+}
+
 int sdmmc_read_write( SIM_HBA *hba, CCB_SCSIIO *ccb, int flgs )
 {
 	SIM_SDMMC_EXT	*ext;
 	SDMMC_PARTITION	*part;
 	uint32_t		lba;
+	uint32_t		timeout;
 	int				status;
 	int				sgc;
+	int				dlen;
+	int				pflgs;
 	sdio_sge_t		*sgp;
 	sdio_sge_t		sge;
 #ifdef SDMMC_SIM_RETRY
@@ -1570,37 +2129,37 @@ int sdmmc_read_write( SIM_HBA *hba, CCB_SCSIIO *ccb, int flgs )
 
 	sdmmc_bkops( hba, CAM_FALSE );	// Check for urgent background operations
 
-	if( ( ccb->cam_ch.cam_flags & CAM_SCATTER_VALID ) ) {
-		sgc				= ccb->cam_sglist_cnt;
-		sgp				= (sdio_sge_t *)ccb->cam_data.cam_sg_ptr;
-	}
-	else {
-		sgc				= 1;
-		sgp				= &sge;
-		sgp->sg_count	= ccb->cam_dxfer_len;
-		sgp->sg_address	= ccb->cam_data.cam_data_ptr;
-	}
+	sgp		= sdmmc_ccb_sgl( ccb, &sge, &sgc );
 
 	if( ( ccb->cam_ch.cam_flags & CAM_DATA_PHYS ) ) {
 		flgs |= SCF_DATA_PHYS;
 	}
 
-	lba		= ENDIAN_BE32( UNALIGNED_RET32( &ccb->cam_cdb_io.cam_cdb_bytes[2] ) );
-
-	if( part->blk_shft ) {
-		lba <<= part->blk_shft;
-	}	
+	lba		= sdmmc_ccb_lba( part, ccb );
+	dlen	= ccb->cam_dxfer_len;
+	timeout	= ccb->cam_timeout;
+	pflgs	= 0;
 
-	lba		+= part->slba;
+#ifndef SDMMC_WRITE_VERIFY
+	if( !sdmmc_rw_merge( hba, ccb, part, lba, &sgp, &sgc, &dlen, &timeout ) && ( flgs & SCF_DIR_OUT ) ) {
+		if( sdmmc_rw_pack( hba, ccb, part, lba, &sgp, &sgc, &dlen, &timeout ) ) {
+			pflgs = SCF_PACKED;
+		}
+	}
+#endif
 
 #ifdef SDMMC_SIM_RETRY
 	retry = SDMMC_RW_RETRIES;
 	do {
-		if( ( status = sdmmc_rw( hba, part, flgs, lba, ccb->cam_dxfer_len, sgp, sgc, ccb->cam_req_map, ccb->cam_timeout ) ) == EOK ) {
+		if( ( status = sdmmc_rw( hba, part, flgs | pflgs, lba, dlen, sgp, sgc, ccb->cam_req_map, timeout ) ) == EOK ) {
 			break;
 		}
 	} while( --retry && status == ETIMEDOUT );
 
+	if( ext->merge_nccbs ) {
+		status = sdmmc_rw_merge_cmplt( hba, ccb, part, flgs, status, ( status && pflgs ) ? sdmmc_rw_pack_status( hba ) : 0 );
+	}
+
 	if( status ) {
 		if( status == ETIMEDOUT ) {					// map timeout to eio
 			status = EIO;
@@ -1608,7 +2167,13 @@ int sdmmc_read_write( SIM_HBA *hba, CCB_SCSIIO *ccb, int flgs )
 		status = sdmmc_error( hba, ccb, status );
 	}
 #else
-	if( ( status = sdmmc_rw( hba, part, flgs, lba, ccb->cam_dxfer_len, sgp, sgc, ccb->cam_req_map, ccb->cam_timeout ) ) != EOK ) {
+	status = sdmmc_rw( hba, part, flgs | pflgs, lba, dlen, sgp, sgc, ccb->cam_req_map, timeout );
+
+	if( ext->merge_nccbs ) {
+		status = sdmmc_rw_merge_cmplt( hba, ccb, part, flgs, status, ( status && pflgs ) ? sdmmc_rw_pack_status( hba ) : 0 );
+	}
+
+	if( status != EOK ) {
 		status = sdmmc_error( hba, ccb, status );
 	}
 #endif
@@ -2082,6 +2647,65 @@ int sdmmc_part_info_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb )
 	return( CAM_REQ_CMP );
 }
 
+int sdmmc_io_stats_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb )
+{
+	SIM_SDMMC_EXT			*ext;
+	SDMMC_PARTITION			*part;
+	SDMMC_IO_STATS			*ios;
+	sdio_hc_info_t			hc_inf;
+	int						status;
+
+	ext		= (SIM_SDMMC_EXT *)hba->ext;
+	ios		= (SDMMC_IO_STATS *)ccb->cam_devctl_data;
+	part	= &ext->targets[ccb->cam_ch.cam_target_id].partitions[ccb->cam_ch.cam_target_lun];
+	status	= EOK;
+
+	if( sdmmc_unit_ready( hba, (CCB_SCSIIO *)ccb ) != CAM_REQ_CMP ) {
+		status = EIO;
+	}
+	else if( ccb->cam_devctl_size < ( sizeof( SDMMC_IO_STATS ) ) ) {
+		status = EINVAL;
+	}
+	else if( ios->action != SDMMC_IOS_ACTION_GET && ios->action != SDMMC_IOS_ACTION_CLR ) {
+		status = EINVAL;
+	}
+	else {
+		sdio_hc_info( ext->device, &hc_inf );
+
+		ios->ptype			= part->config & MMC_PART_MSK;
+		ios->qdepth_max		= part->ios_qdepth_max;
+		ios->qdepth_sum		= part->ios_qdepth_sum;
+		ios->elapsed_ns		= sdmmc_ios_ns( ext, ext->ios_timestamp );
+		ios->qwait			= part->ios_qwait;
+		memcpy( ios->rd, part->ios_rd, sizeof( ios->rd ) );
+		memcpy( ios->wr, part->ios_wr, sizeof( ios->wr ) );
+		ios->bkops			= ext->ios_bkops;
+		ios->flush			= ext->ios_flush;
+		ios->reset			= ext->ios_reset;
+		ios->tune.cnt		= hc_inf.tune_cnt - ext->ios_tune_cnt;
+		ios->tune.total_ns	= hc_inf.tune_ns - ext->ios_tune_ns;
+		ios->tune.max_ns	= hc_inf.tune_max_ns;
+
+		if( ios->action == SDMMC_IOS_ACTION_CLR ) {
+			part->ios_qdepth_max	= 0;
+			part->ios_qdepth_sum	= 0;
+			memset( &part->ios_qwait, 0, sizeof( part->ios_qwait ) );
+			memset( part->ios_rd, 0, sizeof( part->ios_rd ) );
+			memset( part->ios_wr, 0, sizeof( part->ios_wr ) );
+			memset( &ext->ios_bkops, 0, sizeof( ext->ios_bkops ) );
+			memset( &ext->ios_flush, 0, sizeof( ext->ios_flush ) );
+			memset( &ext->ios_reset, 0, sizeof( ext->ios_reset ) );
+			ext->ios_tune_cnt		= hc_inf.tune_cnt;
+			ext->ios_tune_ns		= hc_inf.tune_ns;
+			ext->ios_timestamp		= ClockCycles( );
+		}
+	}
+
+	ccb->cam_devctl_status = status;
+
+	return( CAM_REQ_CMP );
+}
+
 int sdmmc_pwr_mgnt_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb )
 {
 	SIM_SDMMC_EXT			*ext;
@@ -2178,6 +2802,10 @@ int sdmmc_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb )
 			status = sdmmc_pwr_mgnt_devctl( hba, ccb );
 			break;
 
+		case DCMD_SDMMC_IO_STATS:
+			status = sdmmc_io_stats_devctl( hba, ccb );
+			break;
+
 		case DCMD_CAM_VERBOSITY:
 			status = sdmmc_verbosity_devctl( hba, ccb );
 			break;
@@ -2284,16 +2912,53 @@ int sdmmc_scsi_io( SIM_HBA *hba, CCB_SCSIIO *ccb )
 	return( status );
 }
 
+void sdmmc_process_ccb( SIM_HBA *hba, CCB_SCSIIO *ccb )
+{
+	int				status;
+
+	switch( ccb->cam_ch.cam_func_code ) {
+		case XPT_SCSI_IO:
+			status = sdmmc_scsi_io( hba, (CCB_SCSIIO *)ccb );
+			break;
+
+		case XPT_DEVCTL:
+			status = sdmmc_devctl( hba, (CCB_DEVCTL *)ccb );
+			break;
+
+		default:
+			cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1,
+					"%s:  unsupported func code %d", __FUNCTION__, ccb->cam_ch.cam_func_code );
+			status = CAM_REQ_CMP_ERR;
+			break;
+	}
+
+	if( status != CAM_REQ_INPROG ) {
+		ccb->cam_ch.cam_status = status;
+		sdmmc_post_ccb( hba, ccb );
+	}
+}
+
 void sdmmc_start_ccb( SIM_HBA *hba )
 {
 	SIM_SDMMC_EXT	*ext;
 	CCB_SCSIIO		*ccb;
-	int				status;
 
 	ext = (SIM_SDMMC_EXT *)hba->ext;
 
+	if( ( ext->eflags & SDMMC_EFLAG_CMDQ ) ) {
+		sdmmc_cmdq_start_ccb( hba );
+		return;
+	}
+
 	do {
-		if( ( ext->nexus = ccb = simq_ccb_dequeue( hba->simq ) ) == NULL ) {
+		if( ( ccb = ext->lookahead ) != NULL ) {
+			ext->lookahead = NULL;
+		}
+		else {
+			ccb = sdmmc_ccb_dequeue( hba );
+		}
+
+		if( ( ext->nexus = ccb ) == NULL ) {
 #ifdef SDMMC_AGGRESSIVE_PM
 				// In aggressive pm mode we direct call the sdio layer,
 				// so we don't have the overhead of enabling/disabling
@@ -2304,27 +2969,7 @@ void sdmmc_start_ccb( SIM_HBA *hba )
 		}
 
 		sdmmc_pm( hba, PM_ACTIVE );
-
-		switch( ccb->cam_ch.cam_func_code ) {
-			case XPT_SCSI_IO:
-				status = sdmmc_scsi_io( hba, (CCB_SCSIIO *)ccb );
-				break;
-
-			case XPT_DEVCTL:
-				status = sdmmc_devctl( hba, (CCB_DEVCTL *)ccb );
-				break;
-
-			default:
-				cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1,
-						"%s:  unsupported func code %d", __FUNCTION__, ccb->cam_ch.cam_func_code );
-				status = CAM_REQ_CMP_ERR;
-				break;
-		}
-
-		if( status != CAM_REQ_INPROG ) {
-			ccb->cam_ch.cam_status = status;
-			sdmmc_post_ccb( hba, ccb );
-		}
+		sdmmc_process_ccb( hba, ccb );
 
 	} while( ext->nexus == NULL );
 }
@@ -2372,10 +3017,27 @@ void *sdmmc_driver_thread( void *hdl )
 	struct sigevent	event;
 	int				rid;
 	int				stat;
+	int				qdepth;
 
 	hba		= (SIM_HBA *)hdl;
 	ext		= (SIM_SDMMC_EXT *)hba->ext;
 	stat	= CAM_FALSE;
+	qdepth	= 1;
+
+	if( ( ext->eflags & SDMMC_EFLAG_CMDQ ) ) {
+		qdepth = ext->cmdq_depth;
+	}
+	else {
+		if( ( ext->eflags & SDMMC_EFLAG_MERGE ) ) {
+			qdepth = ext->merge_max;
+		}
+		if( ( ext->eflags & SDMMC_EFLAG_PACKED ) ) {
+			qdepth = max( qdepth, ext->packed_max );
+		}
+	}
+
+	ext->ios_cps		= SYSPAGE_ENTRY( qtime )->cycles_per_sec;
+	ext->ios_timestamp	= ClockCycles( );
 
 	if( ( hba->chid = ChannelCreate( _NTO_CHF_DISCONNECT | _NTO_CHF_UNBLOCK ) ) == -1 ) {
 		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s ChannelCreate failure %s", __FUNCTION__, strerror( errno ) ); 
@@ -2393,9 +3055,11 @@ void *sdmmc_driver_thread( void *hdl )
 		stat = CAM_TRUE;
 	}
 
-		// initialize SIM queue routines
+		// initialize SIM queue routines, in command queue mode allow one
+		// ccb per device task plus one waiting for the queue to drain, when
+		// merging or packing allow enough active ccbs to build a transfer
 	if( !stat && ( hba->simq = simq_init( hba->coid, hba, MAX_NARROW_TARGET,
-			MAX_LUN, 2, 1, 2, ( ext->eflags & SDMMC_EFLAG_BKOPS ) ? 1 : 0 ) ) == NULL ) {
+			MAX_LUN, qdepth + 1, qdepth, qdepth + 1, ( ext->eflags & SDMMC_EFLAG_BKOPS ) ? 1 : 0 ) ) == NULL ) {
 		cam_slogf( _SLOGC_SIM_MMC, _SLOG_ERROR, 1, 1, "%s:  simq_init failure", __FUNCTION__ );
 		stat = CAM_TRUE;
 	}
@@ -2636,6 +3300,9 @@ int sdmmc_sim_action( SIM_HBA *hba, CCB *ccbp )
 #ifdef SDMMC_TRACE
 		sdmmc_trace_event( SDMMC_TRACE_EVENT, "%s:  ccb %p, cmd %x", __FUNCTION__, ccb, ((CCB_SCSIIO *)ccb)->cam_cdb_io.cam_cdb_bytes[0] );
 #endif
+		if( ccb->cam_func_code == XPT_SCSI_IO ) {
+			SDMMC_CCB_PRIV( (CCB_SCSIIO *)ccb )->qtime = ClockCycles( );
+		}
 		simq_ccb_enqueue( hba->simq, (CCB_SCSIIO *)ccb );
 		if( MsgSendPulse( hba->coid, ext->priority, SIM_ENQUEUE, 0 ) == -1 ) {
 		}
@@ -2730,6 +3397,9 @@ int sdmmc_sim_args( char *options )
 							"partitions",
 							"bs",
 							"pwroff_notify",
+							"cmdq",
+							"merge",
+							"packed",
 							NULL
 						};
 
@@ -2824,6 +3494,41 @@ int sdmmc_sim_args( char *options )
 
 				break;
 
+			case 8:							// cmdq
+				SDMMC_ARG_VAL( opts[opt], value );
+				if( !strcmp( value, "on" ) ) {
+					ext->eflags |= SDMMC_EFLAG_CMDQ;
+				}
+				else if( ( val = cam_parse_number( value ) ) != CAM_INVALID_NUM && val > 0 ) {
+					ext->eflags		|= SDMMC_EFLAG_CMDQ;
+					ext->cmdq_depth	= min( val, SDMMC_CMDQ_DEPTH_MAX );
+				}
+				break;
+
+			case 9:							// merge
+				SDMMC_ARG_VAL( opts[opt], value );
+				if( !strcmp( value, "on" ) ) {
+					ext->eflags		|= SDMMC_EFLAG_MERGE;
+					ext->merge_max	= SDMMC_MERGE_MAX;
+				}
+				else if( ( val = cam_parse_number( value ) ) != CAM_INVALID_NUM && val > 1 ) {
+					ext->eflags		|= SDMMC_EFLAG_MERGE;
+					ext->merge_max	= min( val, SDMMC_MERGE_MAX );
+				}
+				break;
+
+			case 10:						// packed
+				SDMMC_ARG_VAL( opts[opt], value );
+				if( !strcmp( value, "on" ) ) {
+					ext->eflags		|= SDMMC_EFLAG_PACKED;
+					ext->packed_max	= SDMMC_MERGE_MAX;
+				}
+				else if( ( val = cam_parse_number( value ) ) != CAM_INVALID_NUM && val > 1 ) {
+					ext->eflags		|= SDMMC_EFLAG_PACKED;
+					ext->packed_max	= min( val, SDMMC_MERGE_MAX );
+				}
+				break;
+
 
 			default:
 				break;
@@ -87,6 +87,11 @@
 #define SDMMC_MAX_TARGET				8
 #define SDMMC_MAX_SG					128
 
+#define SDMMC_CMDQ_DEPTH_MAX			32
+#define SDMMC_MERGE_MAX					32
+#define SDMMC_MERGE_BLKS_MAX			0xffff		// host block count / CMD23 limit
+#define SDMMC_PACKED_HDR_SIZE			4096		// header is one block of the largest sector size
+
 #define SDMMC_TRIM_MAX_LBA				0xffffffff
 #define SDMMC_TIMEOUT_MS_TO_NS( _to )	( (uint64_t)( _to ) * 1000LL * 1000LL )
 #define SDMMC_TIMEOUT_S_TO_NS( _to )	( (uint64_t)( _to ) * 1000LL * 1000LL * 1000LL )
@@ -127,6 +132,13 @@ typedef struct _sdmmc_partition {
 	_Uint64t		tc;				// TRIM Count
 	_Uint64t		ec;				// Erase Count
 	_Uint64t		dc;				// Discard Count
+
+		// DCMD_SDMMC_IO_STATS
+	_Uint32t		ios_qdepth_max;
+	_Uint64t		ios_qdepth_sum;
+	SDMMC_IO_HIST	ios_qwait;
+	SDMMC_IO_HIST	ios_rd[SDMMC_IOS_SIZES];
+	SDMMC_IO_HIST	ios_wr[SDMMC_IOS_SIZES];
 } SDMMC_PARTITION;
 
 typedef struct _sdmmc_target {
@@ -135,6 +147,27 @@ typedef struct _sdmmc_target {
 	SDMMC_PARTITION		partitions[SDMMC_PARTITION_MAX];
 } SDMMC_TARGET;
 
+typedef struct _sdmmc_cmdq_task {
+	CCB_SCSIIO			*ccb;
+	SDMMC_PARTITION		*part;
+	_Uint32t			flgs;
+	_Uint32t			addr;
+	_Uint32t			blks;
+	_Uint32t			sgc;
+	sdio_sge_t			*sgl;
+	sdio_sge_t			sge;
+	struct sdio_cmd		*cmd;			// prepared while the previous task is on the bus
+	_Uint64t			qtime;			// ClockCycles() when queued on the device
+} SDMMC_CMDQ_TASK;
+
+// SIM private area of a SCSI IO ccb, the simq library owns the SIMQ_DATA at the start
+typedef struct _sdmmc_ccb_priv {
+	SIMQ_DATA			simq;
+	_Uint64t			qtime;			// ClockCycles() when queued by sdmmc_sim_action
+} SDMMC_CCB_PRIV;
+
+#define SDMMC_CCB_PRIV( _ccb )			( (SDMMC_CCB_PRIV *)( _ccb )->cam_sim_priv )
+
 typedef struct _sim_sdmmc_ext {
 	SIM_HBA					*hba;
 
@@ -148,6 +181,9 @@ typedef struct _sim_sdmmc_ext {
 #define SDMMC_EFLAG_DEV_BUSY			(1 << 7)
 #define SDMMC_EFLAG_CACHE				(1 << 8)
 #define SDMMC_EFLAG_PWROFF_NOTIFY		(1 << 9)
+#define SDMMC_EFLAG_CMDQ				(1 << 10)	// command queue mode
+#define SDMMC_EFLAG_MERGE				(1 << 11)	// merge contiguous read/write ccbs
+#define SDMMC_EFLAG_PACKED				(1 << 12)	// pack queued writes into one transfer
 #define SDMMC_EFLAG_BS					(1 << 24)
 	_Uint32t				eflags;
 	_Uint8t					priority;
@@ -155,6 +191,10 @@ typedef struct _sim_sdmmc_ext {
 	_Uint8t					rsvd[2];
 
 	CCB_SCSIIO				*nexus;
+	CCB_SCSIIO				*lookahead;		// next ccb, dequeued while nexus is on the bus
+	CCB_SCSIIO				*rw_prep_ccb;
+	struct sdio_cmd			*rw_prep;		// read/write command prepared for rw_prep_ccb
+	sdio_sge_t				rw_prep_sge;
 
 	struct sdio_device		*device;
 	sdio_device_instance_t	instance;
@@ -189,6 +229,28 @@ typedef struct _sim_sdmmc_ext {
 	_Uint32t				ntargs;
 	SDMMC_TARGET			targets[SDMMC_TARGET_MAX];
 
+	_Uint32t				cmdq_depth;
+	_Uint32t				cmdq_tmap;		// bitmap of queued task ids
+	SDMMC_PARTITION			*cmdq_part;		// partition of queued tasks
+	CCB_SCSIIO				*cmdq_hold;		// ccb waiting for the queue to drain
+	SDMMC_CMDQ_TASK			cmdq_tasks[SDMMC_CMDQ_DEPTH_MAX];
+	_Uint32t				merge_max;		// max ccbs combined into one transfer
+	_Uint32t				merge_nccbs;	// ccbs merged behind nexus
+	CCB_SCSIIO				*merge_ccbs[SDMMC_MERGE_MAX];
+	sdio_sge_t				merge_sgl[SDMMC_MAX_SG];
+	_Uint32t				packed_max;		// max writes in a packed transfer
+	_Uint32t				*packed_hdr;
+	paddr64_t				packed_paddr;
+
+		// DCMD_SDMMC_IO_STATS, partition histograms are in SDMMC_PARTITION
+	_Uint64t				ios_cps;		// ClockCycles() per second
+	_Uint64t				ios_timestamp;	// ClockCycles() when last cleared
+	SDMMC_IO_TIME			ios_bkops;
+	SDMMC_IO_TIME			ios_flush;
+	SDMMC_IO_TIME			ios_reset;
+	_Uint32t				ios_tune_cnt;	// sdio_hc_info() tuning counts when last cleared
+	_Uint64t				ios_tune_ns;
+
 #ifdef SDMMC_WRITE_VERIFY
 #define SDMMC_VER_BSIZE		( 512 * 256 )
 	char					*ver_vaddr;
@@ -208,9 +270,19 @@ extern void *sdmmc_driver_thread( void *data );
 extern int sdmmc_bkops_cfg( SIM_HBA *hba );
 extern int sdmmc_pwroff_notify( SIM_HBA *hba, uint8_t cfg );
 extern int sdmmc_unit_ready( SIM_HBA *hba, CCB_SCSIIO *ccb );
+extern int sdmmc_error( SIM_HBA *hba, CCB_SCSIIO *ccb, int status );
+extern int sdmmc_post_ccb( SIM_HBA *hba, CCB_SCSIIO *ccb );
+extern void sdmmc_process_ccb( SIM_HBA *hba, CCB_SCSIIO *ccb );
+extern int sdmmc_pm( SIM_HBA *hba, int op );
+extern int sdmmc_bkops( SIM_HBA *hba, int tick );
+extern int sdmmc_reset( SIM_HBA *hba );
 extern int sdmmc_wp_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
 extern int sdmmc_erase_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
 extern int sdmmc_card_register_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
+extern CCB_SCSIIO *sdmmc_ccb_dequeue( SIM_HBA *hba );
+extern void sdmmc_ios_time( SIM_HBA *hba, SDMMC_IO_TIME *iot, _Uint64t start );
+extern void sdmmc_ios_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, int blks, _Uint64t start );
+extern int sdmmc_wait_prog( SIM_HBA *hba, uint32_t *rsp, uint32_t timeout );
 extern int sdmmc_rw( SIM_HBA *hba, SDMMC_PARTITION *part, int flgs, uint32_t addr, int dlen, sdio_sge_t *sgl, int sgc, void *mhdl, uint32_t timeout );
 extern int sim_bs_partition_config( SIM_HBA *hba );
 extern int sim_bs_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
@@ -223,6 +295,11 @@ int sdmmc_assd_status_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
 int sdmmc_assd_control_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
 int sdmmc_assd_properties_devctl( SIM_HBA *hba, CCB_DEVCTL *ccb );
 
+// sim_cmdq.c
+int sdmmc_cmdq_init( SIM_HBA *hba );
+int sdmmc_cmdq_cfg( SIM_HBA *hba, int enable );
+void sdmmc_cmdq_start_ccb( SIM_HBA *hba );
+
 #ifndef EXTERN
 #define EXTERN_ADDED
 #define EXTERN extern
@@ -0,0 +1,175 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2014, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+#include "mx6q.h"
+#include <fcntl.h>
+#include <net/ifdrvcom.h>
+#include <sys/sockio.h>
+#include <hw/imx6x_devnp_ioctl.h>
+
+//
+// Create the shared memory ring for the avtp_ring option. If it can't be
+// made then 1722 frames keep going up through io-pkt as before.
+//
+void
+mx6q_avtp_init (mx6q_dev_t *mx6q)
+{
+    mx6q_avtp_ring_hdr_t	*hdr;
+    int				fd;
+
+    if (mx6q->avtp_slots == 0) {
+	return;
+    }
+
+    snprintf(mx6q->avtp_name, sizeof(mx6q->avtp_name), "/mx6x%d-avtp",
+	     mx6q->cfg.device_index);
+    mx6q->avtp_size = sizeof(*hdr) +
+      (mx6q->avtp_slots * sizeof(mx6q_avtp_slot_t));
+
+    // left over from a previous instance that died?
+    shm_unlink(mx6q->avtp_name);
+    fd = shm_open(mx6q->avtp_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+	log(LOG_ERR, "%s(): shm_open %s failed: %s", __FUNCTION__,
+	    mx6q->avtp_name, strerror(errno));
+	goto fail;
+    }
+    if (ftruncate(fd, mx6q->avtp_size) == -1) {
+	log(LOG_ERR, "%s(): ftruncate %s failed: %s", __FUNCTION__,
+	    mx6q->avtp_name, strerror(errno));
+	close(fd);
+	shm_unlink(mx6q->avtp_name);
+	goto fail;
+    }
+    hdr = mmap(NULL, mx6q->avtp_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+	       fd, 0);
+    close(fd);
+    if (hdr == MAP_FAILED) {
+	log(LOG_ERR, "%s(): mmap %s failed: %s", __FUNCTION__,
+	    mx6q->avtp_name, strerror(errno));
+	shm_unlink(mx6q->avtp_name);
+	goto fail;
+    }
+
+    memset(hdr, 0, mx6q->avtp_size);
+    hdr->slots = mx6q->avtp_slots;
+    hdr->slot_size = sizeof(mx6q_avtp_slot_t);
+    hdr->queue = mx6q->avtp_queue;
+    __sync_synchronize();
+    hdr->magic = MX6Q_AVTP_MAGIC;
+    mx6q->avtp_ring = hdr;
+    return;
+
+fail:
+    mx6q->avtp_name[0] = '\0';
+    mx6q->avtp_slots = 0;
+    mx6q->avtp_poll = 0;
+}
+
+void
+mx6q_avtp_fini (mx6q_dev_t *mx6q)
+{
+    mx6q_avtp_ring_hdr_t	*hdr = mx6q->avtp_ring;
+
+    if (hdr == NULL) {
+	return;
+    }
+    // readers still mapped keep their pages, tell them it's gone
+    hdr->magic = 0;
+    mx6q->avtp_ring = NULL;
+    munmap(hdr, mx6q->avtp_size);
+    shm_unlink(mx6q->avtp_name);
+}
+
+//
+// Copy a received 1722 frame into the next slot. Only the Rx thread
+// serving avtp_queue calls this so there is a single writer. The caller
+// still owns the mbuf.
+//
+void
+mx6q_avtp_put (mx6q_dev_t *mx6q, struct mbuf *m, mpc_bd_t *bd)
+{
+    mx6q_avtp_ring_hdr_t	*hdr = mx6q->avtp_ring;
+    mx6q_avtp_slot_t		*slot;
+    ptp_time_t			t;
+    uint32_t			pos, seq, len;
+
+    len = m->m_pkthdr.len;
+    if (m->m_flags & M_HASFCS) {
+	len -= ETHER_CRC_LEN;
+    }
+    if (len > MX6Q_AVTP_SLOT_DATA) {
+	hdr->too_big++;
+	return;
+    }
+    mx6q_ptp_bd_time(mx6q, bd, &t);
+
+    pos = hdr->head;
+    slot = (mx6q_avtp_slot_t *)(hdr + 1) + (pos & (hdr->slots - 1));
+
+    // odd while the slot is rewritten
+    seq = slot->seq;
+    slot->seq = seq + 1;
+    __sync_synchronize();
+
+    m_copydata(m, 0, len, (caddr_t)slot->data);
+    slot->len = len;
+    slot->sec = t.sec;
+    slot->nsec = t.nsec;
+
+    __sync_synchronize();
+    slot->seq = seq + 2;
+    hdr->head = pos + 1;
+}
+
+int
+mx6q_avtp_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+    mx6q_avtp_ring_info_t	info;
+    mx6q_avtp_ring_hdr_t	*hdr = mx6q->avtp_ring;
+
+    if (ifd->ifd_len != sizeof(info)) {
+	return EINVAL;
+    }
+
+    memset(&info, 0, sizeof(info));
+    if (hdr != NULL) {
+	strlcpy(info.name, mx6q->avtp_name, sizeof(info.name));
+	info.slots = hdr->slots;
+	info.queue = hdr->queue;
+	info.poll = mx6q->avtp_poll;
+	info.frames = hdr->head;
+	info.too_big = hdr->too_big;
+    }
+
+    if (ISSTACK) {
+	return (copyout(&info, (((uint8_t *)ifd) + sizeof(*ifd)),
+			sizeof(info)));
+    } else {
+	memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &info, sizeof(info));
+	return EOK;
+    }
+}
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devnp/mx6x/avtp.c $ $Rev$")
+#endif
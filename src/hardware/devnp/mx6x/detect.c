@@ -32,6 +32,7 @@ static void mx6q_stop(struct ifnet *ifp, int disable);
 static void mx6q_destroy(mx6q_dev_t *mx6q, int how);
 static void mx6q_reset(mx6q_dev_t *mx6q);
 static int mx6q_init(struct ifnet *ifp);
+static void mx6q_set_rx_buf_size(mx6q_dev_t *mx6q, int frame);
 
 static int mx6q_attach(struct device *, struct device *, void *);
 static int mx6q_detach(struct device *, int);
@@ -65,6 +66,21 @@ static  char *mpc_opts [] = {
     "rx_delay", // 7, only used on SoloX
     "tx_frame", // 8, only used on SoloX
     "tx_delay", // 9, only used on SoloX
+    "copybreak", // 10
+    "adaptive_ic", // 11, only used on SoloX
+    "rx_budget", // 12
+    "rxq_threads", // 13
+    "rxq_prio", // 14
+    "rxq_cpu", // 15
+    "rxq_pcp", // 16, only used on SoloX
+    "profile", // 17
+    "mcast_filter", // 18
+    "phy_irq",  // 19
+    "phy_int",  // 20
+    "avtp_ring", // 21
+    "avtp_queue", // 22
+    "avtp_poll", // 23
+    "sim_mac", // 24
     NULL
 };
 
@@ -95,6 +111,28 @@ void dump_mbuf (struct mbuf *m, uint32_t length)
     }
 }
 
+//
+// parse a colon separated list of up to num ints, e.g. rxq_cpu=1:2:3.
+// Entries not given are left alone.
+//
+static void
+mx6q_parse_list (char *value, int *list, int num)
+{
+    char    *end;
+    int     i;
+
+    for (i = 0; i < num; i++) {
+        if (*value != ':') {
+            list[i] = strtol(value, &end, 0);
+            value = end;
+        }
+        if (*value != ':') {
+            break;
+        }
+        value++;
+    }
+}
+
 //
 // called from mx6q_detect()
 //
@@ -207,6 +245,106 @@ mx6q_parse_options (mx6q_dev_t *mx6q, char *options, nic_config_t *cfg, struct m
             }
             break;
 #endif
+
+        case 10:
+            if (mx6q && value) {
+                mx6q->rx_copybreak = strtoul(value, 0, 0);
+            }
+            break;
+
+#ifdef MX6XSLX
+        case 11:
+            if (mx6q) {
+                if (value) {
+                    mx6q->ic_adaptive = strtol(value, 0, 0);
+                } else {
+                    mx6q->ic_adaptive = 1;
+                }
+            }
+            break;
+#endif
+
+        case 12:
+            if (mx6q && value) {
+                mx6q->rx_budget = strtoul(value, 0, 0);
+            }
+            break;
+
+        case 13:
+            if (mx6q) {
+                mx6q->rxq_threads = 1;
+            }
+            break;
+
+        case 14:
+            if (mx6q && value) {
+                mx6q_parse_list(value, mx6q->rxq_prio, NUM_RX_QUEUES);
+            }
+            break;
+
+        case 15:
+            if (mx6q && value) {
+                mx6q_parse_list(value, mx6q->rxq_cpu, NUM_RX_QUEUES);
+            }
+            break;
+
+#ifdef MX6XSLX
+        case 16:
+            if (mx6q && value) {
+                mx6q_parse_list(value, mx6q->rxq_pcp, 8);
+                mx6q->rxq_steer = 1;
+            }
+            break;
+#endif
+
+        case 17:
+            if (mx6q) {
+                mx6q->profile = 1;
+            }
+            break;
+
+        case 18:
+            if (mx6q) {
+                mx6q->mcf_enable = 1;
+            }
+            break;
+
+        case 19:
+            if (mx6q && value) {
+                mx6q->phy_irq = strtol(value, 0, 0);
+            }
+            break;
+
+        case 20:
+            if (mx6q && value) {
+                mx6q_parse_list(value, mx6q->phy_int, 3);
+            }
+            break;
+
+        case 21:
+            if (mx6q && value) {
+                mx6q->avtp_slots = strtoul(value, 0, 0);
+            }
+            break;
+
+        case 22:
+            if (mx6q && value) {
+                mx6q->avtp_queue = strtoul(value, 0, 0);
+            }
+            break;
+
+        case 23:
+            if (mx6q) {
+                mx6q->avtp_poll = 1;
+            }
+            break;
+
+        case 24:
+            if (mx6q) {
+                mx6q->sim_mac = 1;
+            }
+            break;
+
         default:
             if (nic_parse_options (cfg, value) != EOK) {
                     log(LOG_ERR, "%s(): unknown option %s", __FUNCTION__, c);
@@ -224,45 +362,67 @@ mx6q_parse_options (mx6q_dev_t *mx6q, char *options, nic_config_t *cfg, struct m
     return (rc);
 }
 
+static const uint32_t mx6q_rx_ievent[NUM_RX_QUEUES] = {
+    IEVENT_RFINT,
+#ifdef MX6XSLX
+    IEVENT_RXF1,
+    IEVENT_RXF2,
+#endif
+};
+
+static const uint32_t mx6q_rx_imask[NUM_RX_QUEUES] = {
+    IMASK_RFIEN,
+#ifdef MX6XSLX
+    IMASK_RXF1EN,
+    IMASK_RXF2EN,
+#endif
+};
+
 void *mx6q_rx_thread (void *arg)
 {
-    mx6q_dev_t        *mx6q = arg;
-    int                rc, queue;
+    mx6q_rx_thread_t  *thr = arg;
+    mx6q_dev_t        *mx6q = thr->mx6q;
+    int                rc, i, queue;
+    uint32_t           pending = 0;
+    uint32_t           poll = 0;
     struct _pulse      pulse;
     volatile uint32_t *base = mx6q->reg;
+    struct ifnet      *ifp = &mx6q->ecom.ec_if;
+
+    if (mx6q->avtp_poll && (thr->queues & (1 << mx6q->avtp_queue))) {
+        poll = 1 << mx6q->avtp_queue;
+    }
 
     while (1) {
-        rc = MsgReceivePulse(mx6q->chid, &pulse, sizeof(pulse), NULL);
+        /*
+         * A busy-polled queue is always pending while the interface is
+         * up and not stalled, its interrupt stays masked after the first.
+         */
+        if (poll && (ifp->if_flags & IFF_RUNNING) &&
+            ((mx6q->rx_full & poll) == 0)) {
+            pending |= poll;
+        }
+
+        /*
+         * Queues that used up their budget last time round stay masked
+         * and in pending. Only block when there are none, otherwise just
+         * pick up a pulse if there is one waiting.
+         */
+        if (pending) {
+            TimerTimeout(CLOCK_MONOTONIC, _NTO_TIMEOUT_RECEIVE,
+                         NULL, NULL, NULL);
+        }
+        rc = MsgReceivePulse(thr->chid, &pulse, sizeof(pulse), NULL);
         if (rc == EOK) {
             switch (pulse.code) {
             case MX6Q_RX_PULSE:
-            queue = pulse.value.sival_int;
-#ifdef MX6XSLX
-            if (queue == 1) {
-                *(base + MX6Q_IEVENT) = IEVENT_RXF1;
-                if (mx6q_receive(mx6q, WTP, 1)) {
-                    InterruptLock(&mx6q->spinlock);
-                    *(base + MX6Q_IMASK) |= IMASK_RXF1EN;
-                    InterruptUnlock(&mx6q->spinlock);
-                }
-            } else if (queue == 2) {
-                *(base + MX6Q_IEVENT) = IEVENT_RXF2;
-                if (mx6q_receive(mx6q, WTP, 2)) {
-                    InterruptLock(&mx6q->spinlock);
-                    *(base + MX6Q_IMASK) |= IMASK_RXF2EN;
-                    InterruptUnlock(&mx6q->spinlock);
-                }
-            } else
-#endif
-            if (queue == 0) {
-                *(base + MX6Q_IEVENT) = IEVENT_RFINT;
-                if (mx6q_receive(mx6q, WTP, 0)) {
-                    InterruptLock(&mx6q->spinlock);
-                    *(base + MX6Q_IMASK) |= IMASK_RFIEN;
-                    InterruptUnlock(&mx6q->spinlock);
+                queue = pulse.value.sival_int;
+                if ((queue < NUM_RX_QUEUES) && (thr->queues & (1 << queue))) {
+                    pending |= 1 << queue;
+                } else {
+                    log(LOG_ERR, "mx6 Rx: Bad queue %d", queue);
                 }
-            }
-            break;
+                break;
             case MX6Q_QUIESCE_PULSE:
                 quiesce_block(pulse.value.sival_int);
                 break;
@@ -270,31 +430,71 @@ void *mx6q_rx_thread (void *arg)
                 log(LOG_ERR, "mx6 Rx: Unknown pulse %d received", pulse.code);
                 break;
             }
-        } else {
+        } else if (!pending || (errno != ETIMEDOUT)) {
           log(LOG_ERR, "mx6 Rx: MsgReceivePulse: %s", strerror(rc));
         }
+
+        /* One budget from each queue with work, AVB queues first */
+        for (i = 0; i < NUM_RX_QUEUES; i++) {
+            queue = (i + 1) % NUM_RX_QUEUES;
+            if ((pending & (1 << queue)) == 0) {
+                continue;
+            }
+            *(base + MX6Q_IEVENT) = mx6q_rx_ievent[queue];
+            switch (mx6q_receive(mx6q, WTP, queue)) {
+            case MX6Q_RX_MORE:
+                break;
+            case MX6Q_RX_DONE:
+                if ((poll & (1 << queue)) && (ifp->if_flags & IFF_RUNNING)) {
+                    break;
+                }
+                InterruptLock(&mx6q->spinlock);
+                *(base + MX6Q_IMASK) |= mx6q_rx_imask[queue];
+                InterruptUnlock(&mx6q->spinlock);
+                pending &= ~(1 << queue);
+                break;
+            default:
+                /* Stays masked until mx6q_enable_queue() */
+                pending &= ~(1 << queue);
+                break;
+            }
+        }
     }
     return NULL;
 }
 
 void mx6q_rx_thread_quiesce (void *arg, int die)
 {
-    mx6q_dev_t          *mx6q = arg;
+    mx6q_rx_thread_t    *thr = arg;
 
-    MsgSendPulse(mx6q->coid, SIGEV_PULSE_PRIO_INHERIT,
+    MsgSendPulse(thr->coid, SIGEV_PULSE_PRIO_INHERIT,
          MX6Q_QUIESCE_PULSE, die);
     return;
 }
 
 static int mx6q_rx_thread_init (void *arg)
 {
-    mx6q_dev_t          *mx6q = arg;
+    mx6q_rx_thread_t    *thr = arg;
     struct nw_work_thread   *wtp = WTP;
+    char                name[16];
+
+    if (thr->mx6q->num_rx_threads > 1) {
+        snprintf(name, sizeof(name), "mx6 Rx%d", ffs(thr->queues) - 1);
+        pthread_setname_np(gettid(), name);
+    } else {
+        pthread_setname_np(gettid(), "mx6 Rx");
+    }
 
-    pthread_setname_np(gettid(), "mx6 Rx");
+    if (thr->cpu >= 0) {
+        if (ThreadCtl(_NTO_TCTL_RUNMASK,
+                      (void *)(uintptr_t)(1 << thr->cpu)) == -1) {
+            log(LOG_ERR, "%s(): runmask cpu %d failed: %s",
+                __FUNCTION__, thr->cpu, strerror(errno));
+        }
+    }
 
     wtp->quiesce_callout = mx6q_rx_thread_quiesce;
-    wtp->quiesce_arg = mx6q;
+    wtp->quiesce_arg = thr;
     return EOK;
 }
 
@@ -331,8 +531,9 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     struct nw_stk_ctl  *sctlp;
     struct mx6q_arg    *mx6q_arg;
     mpc_bd_t           *bd;
-    struct mbuf        *m;
+    mx6q_rxbuf_t       *rb;
     volatile uint32_t  *base;
+    mx6q_rx_thread_t   *thr;
 
 #ifdef MX6XSLX
     uint32_t           rxic_val = 0;
@@ -351,6 +552,9 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     mx6q->iid_tx = -1;
     mx6q->iid_err = -1;
     mx6q->iid_1588 = -1;
+    mx6q->iid_phy = -1;
+    mx6q->phy_irq = -1;
+    mx6q->phy_int[0] = -1;
 
     ifp = &mx6q->ecom.ec_if;
     ifp->if_softc = mx6q;
@@ -371,6 +575,27 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
 
     mx6q->num_tx_descriptors = DEFAULT_NUM_TX_DESCRIPTORS;
     mx6q->num_rx_descriptors = DEFAULT_NUM_RX_DESCRIPTORS;
+    mx6q->rx_copybreak = DEFAULT_RX_COPYBREAK;
+    mx6q->rx_budget = DEFAULT_RX_BUDGET;
+    mx6q->avtp_queue = NUM_RX_QUEUES - 1;
+
+    /*
+     * Start each class of traffic at the default rx_prio but increment
+     * by 2 for each class to allow a process to run at (class - 1)
+     * receiving and still have priority over the lower class traffic
+     * without impacting the dequeueing of packets from the limited Rx
+     * descriptors.
+     */
+    for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+        mx6q->rxq_prio[queue] = sctlp->rx_prio + (2 * queue);
+        mx6q->rxq_cpu[queue] = -1;
+    }
+#ifdef MX6XSLX
+    /* Priority 2,3 to class 2, 4-7 to class 1 */
+    for (i = 0; i < 8; i++) {
+        mx6q->rxq_pcp[i] = (i < 2) ? 0 : (i < 4) ? 2 : 1;
+    }
+#endif
 
 #ifdef MX6XSLX
     mx6q->rx_frame = RX_FRAME_DEFAULT;
@@ -478,6 +703,28 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
         mx6q->num_rx_descriptors = MAX_NUM_RX_DESCRIPTORS;
     }
 
+    if (mx6q->rx_copybreak > MHLEN) {
+        mx6q->rx_copybreak = MHLEN;
+    }
+
+    if (mx6q->avtp_slots != 0) {
+        // round up to a power of 2 for the ring index
+        i = MX6Q_AVTP_MIN_SLOTS;
+        while ((i < mx6q->avtp_slots) && (i < MX6Q_AVTP_MAX_SLOTS)) {
+            i <<= 1;
+        }
+        mx6q->avtp_slots = i;
+        if (mx6q->avtp_queue >= NUM_RX_QUEUES) {
+            log(LOG_ERR, "%s(): avtp_queue %u out of range, using %d",
+                __FUNCTION__, mx6q->avtp_queue, NUM_RX_QUEUES - 1);
+            mx6q->avtp_queue = NUM_RX_QUEUES - 1;
+        }
+    }
+    if (mx6q->avtp_poll && (mx6q->avtp_slots == 0)) {
+        log(LOG_ERR, "%s(): avtp_poll needs avtp_ring, ignored", __FUNCTION__);
+        mx6q->avtp_poll = 0;
+    }
+
     mx6q->num_tx_descriptors &= ~3;
     if (mx6q->num_tx_descriptors < MIN_NUM_TX_DESCRIPTORS) {
         mx6q->num_tx_descriptors = MIN_NUM_TX_DESCRIPTORS;
@@ -555,6 +802,18 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     }
     memset(mx6q->tx_pkts, 0x00, size);
 
+    // submit times for the tx latency histogram
+    if (mx6q->profile) {
+        mx6q->ns_per_kcycle = 1000000000000ULL /
+          SYSPAGE_ENTRY(qtime)->cycles_per_sec;
+        size = sizeof(uint64_t) * mx6q->num_tx_descriptors * NUM_TX_QUEUES;
+        mx6q->tx_stamp = malloc(size, M_DEVBUF, M_NOWAIT);
+        if (mx6q->tx_stamp == NULL) {
+            log(LOG_ERR, "%s(): malloc tx_stamp failed, no tx latency",
+                __FUNCTION__);
+        }
+    }
+
     // init tx descr ring
     for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
         offset =  mx6q->num_tx_descriptors * queue;
@@ -579,23 +838,37 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
         return rc;
     }
 
-    // alloc mbuf pointer array, corresponding to rx descr ring
-    size = sizeof(struct mbuf *) * mx6q->num_rx_descriptors * NUM_RX_QUEUES;
-    mx6q->rx_pkts = malloc(size, M_DEVBUF, M_NOWAIT);
-    if (mx6q->rx_pkts == NULL) {
+    // alloc buffer pointer array, corresponding to rx descr ring
+    size = sizeof(mx6q_rxbuf_t *) * mx6q->num_rx_descriptors * NUM_RX_QUEUES;
+    mx6q->rx_bufs = malloc(size, M_DEVBUF, M_NOWAIT);
+    if (mx6q->rx_bufs == NULL) {
         rc = ENOBUFS;
-        log(LOG_ERR, "%s(): malloc rx_pkts failed", __FUNCTION__);
+        log(LOG_ERR, "%s(): malloc rx_bufs failed", __FUNCTION__);
         mx6q_destroy(mx6q, 6);
         return rc;
     }
-    memset(mx6q->rx_pkts, 0x00, size);
-
-    mx6q->chid = ChannelCreate(0);
-    mx6q->coid = ConnectAttach(ND_LOCAL_NODE, 0, mx6q->chid,
-                   _NTO_SIDE_CHANNEL, 0);
+    memset(mx6q->rx_bufs, 0x00, size);
+
+    mx6q->num_rx_threads = mx6q->rxq_threads ? NUM_RX_QUEUES : 1;
+    for (i = 0; i < mx6q->num_rx_threads; i++) {
+        thr = &mx6q->rx_thread[i];
+        thr->mx6q = mx6q;
+        thr->queues = mx6q->rxq_threads ? (1 << i) :
+          ((1 << NUM_RX_QUEUES) - 1);
+        thr->cpu = mx6q->rxq_cpu[i];
+        thr->chid = ChannelCreate(0);
+        thr->coid = ConnectAttach(ND_LOCAL_NODE, 0, thr->chid,
+                                  _NTO_SIDE_CHANNEL, 0);
+    }
 
-    // init rx descr ring
+    // init rx descr ring, each queue from its own buffer pool
     for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+        mx6q->rxp[queue] = mx6q_rxp_create(mx6q,
+                             MX6Q_RXP_BUFS(mx6q->num_rx_descriptors));
+        if (mx6q->rxp[queue] == NULL) {
+            mx6q_destroy(mx6q, 7);
+            return ENOMEM;
+        }
         offset =  mx6q->num_rx_descriptors * queue;
         for (i = 0; i < mx6q->num_rx_descriptors; i++) {
             bd = &mx6q->rx_bd[offset + i];
@@ -605,28 +878,18 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
             }
             bd->estatus = RXBD_ESTATUS_INT;
 
-            m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
-            if (m == NULL) {
-                mx6q_destroy(mx6q, 7);
-                return ENOMEM;
-            }
-            mx6q->rx_pkts[offset + i] = m;
-            bd->buffer = pool_phys(m->m_data, m->m_ext.ext_page);
-            CACHE_INVAL(&mx6q->cachectl, m->m_data, bd->buffer,
-                    m->m_ext.ext_size);
+            rb = mx6q_rxp_get(mx6q->rxp[queue]);
+            mx6q->rx_bufs[offset + i] = rb;
+            bd->buffer = (uint32_t)rb->phys;
         }
         mx6q->rx_cidx[queue] = 0;
         /*
-         * Create a pulse for each class of traffic. Start at the
-         * default rx_prio but increment by 2 for each class to
-         * allow a process to run at (class - 1) receiving and still
-         * have priority over the lower class traffic without
-         * impacting the dequeueing of packets from the limited Rx
-         * descriptors.
+         * Create a pulse for each class of traffic, the Rx thread
+         * serving the queue runs at the pulse priority.
          */
-        SIGEV_PULSE_INIT(&mx6q->isr_event[queue], mx6q->coid,
-             sctlp->rx_prio + (2 * queue),
-             MX6Q_RX_PULSE, queue);
+        thr = &mx6q->rx_thread[mx6q->rxq_threads ? queue : 0];
+        SIGEV_PULSE_INIT(&mx6q->isr_event[queue], thr->coid,
+             mx6q->rxq_prio[queue], MX6Q_RX_PULSE, queue);
     }
 
     // one hardware interrupt
@@ -663,11 +926,20 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     IFQ_SET_MAXLEN(&mx6q->rx_queue, IFQ_MAXLEN);
 
     memset(&mx6q->rtc_spinner, 0, sizeof(mx6q->rtc_spinner));
+    mx6q_ptp_init(mx6q);
     memset(&mx6q->spinlock, 0, sizeof(mx6q->spinlock));
+    mx6q_avtp_init(mx6q);
 
-    nw_pthread_create(&mx6q->tid, NULL,
-              mx6q_rx_thread, mx6q, 0,
-              mx6q_rx_thread_init, mx6q);
+    for (i = 0; i < mx6q->num_rx_threads; i++) {
+        thr = &mx6q->rx_thread[i];
+        nw_pthread_create(&thr->tid, NULL,
+                  mx6q_rx_thread, thr, 0,
+                  mx6q_rx_thread_init, thr);
+    }
+    if ((rc = mx6q_sim_init(mx6q)) != EOK) {
+        mx6q_destroy(mx6q, 11);
+        return rc;
+    }
 
     /* Reset the chip */
     mx6q_reset(mx6q);
@@ -685,18 +957,9 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     // Set transmit FIFO to store and forward
     *(base + MX6Q_X_WMRK) = X_WMRK_STR_FWD;
 
-    /*
-     * Set maximum receive buffer size.
-     * Freescale have confirmed the spec is wrong, only bits 6-10 should
-     * be used.
-     */
-    *(base + MX6Q_R_BUFF_SIZE) = min(MCLBYTES, MX6Q_MAX_RBUFF_SIZE) &
-                    MX6Q_MAX_RBUFF_SIZE;
+    // Receive buffer size for the default MTU, mx6q_init() redoes it
+    mx6q_set_rx_buf_size(mx6q, ETHERMTU + ETHER_HDR_LEN + ETHER_CRC_LEN);
 #ifdef MX6XSLX
-    *(base + MX6Q_R_BUFF_SIZE1) = min(MCLBYTES, MX6Q_MAX_RBUFF_SIZE) &
-                    MX6Q_MAX_RBUFF_SIZE;
-    *(base + MX6Q_R_BUFF_SIZE2) = min(MCLBYTES, MX6Q_MAX_RBUFF_SIZE) &
-                    MX6Q_MAX_RBUFF_SIZE;
 
     /*
      * DMA classes need to be enabled before enabling the chip.
@@ -726,6 +989,10 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     *(base + MX6Q_MIB_CONTROL) |= MIB_CLEAR;
     *(base + MX6Q_MIB_CONTROL) &= ~MIB_CLEAR;
     mx6q_clear_stats(mx6q);
+    callout_init(&mx6q->stats_callout);
+#ifdef MX6XSLX
+    callout_init(&mx6q->ic_callout);
+#endif
 
     // Set media interface type
     if (mx6q->rmii) {
@@ -846,10 +1113,6 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
         }
     }
 
-    *(base + MX6SLX_TXIC0) = txic_val;
-    *(base + MX6SLX_TXIC1) = txic_val;
-    *(base + MX6SLX_TXIC2) = txic_val;
-
     /* Setup Interrupt coalescence for RX interrupts */
     if (mx6q->rx_frame || mx6q->rx_delay) {
         if (!mx6q->rx_frame || !mx6q->rx_delay) {
@@ -860,6 +1123,20 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
         }
     }
 
+    if (mx6q->ic_adaptive) {
+        /* Start out tuned for latency, mx6q_ic_adapt() takes it from here */
+        mx6q->ic_level = MX6Q_IC_LEVEL_IDLE;
+        mx6q_ic_values(mx6q, mx6q->ic_level, &rxic_val, &txic_val);
+    } else {
+        mx6q->ic_level = MX6Q_IC_LEVEL_BULK;
+    }
+    mx6q->ic_rxic = rxic_val;
+    mx6q->ic_txic = txic_val;
+
+    *(base + MX6SLX_TXIC0) = txic_val;
+    *(base + MX6SLX_TXIC1) = txic_val;
+    *(base + MX6SLX_TXIC2) = txic_val;
+
     /* Only enable on Queue 0. Other queues have AVB traffic. */
     *(base + MX6SLX_RXIC0) = rxic_val;
 #else
@@ -879,6 +1156,12 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
 	bsd_mii_initmedia(mx6q);
     }
 
+    // Link changes by interrupt if the board wires up the PHY
+    if (mx6q_phy_irq_init(mx6q) != EOK) {
+	mx6q_destroy(mx6q, -1);
+	return ENODEV;
+    }
+
     // Configure 1588 timer
     mx6q_ptp_start(mx6q);
 
@@ -897,6 +1180,12 @@ mx6q_attach(struct device *parent, struct device *self, void *aux)
     mx6q->ecom.ec_capabilities |= ETHERCAP_VLAN_MTU;
     mx6q->ecom.ec_capabilities |= ETHERCAP_JUMBO_MTU;
 
+    /* IPv4, TCP and UDP checksums can be offloaded, enable via ifconfig */
+    ifp->if_capabilities_rx = IFCAP_CSUM_IPv4 | IFCAP_CSUM_TCPv4 |
+      IFCAP_CSUM_UDPv4;
+    ifp->if_capabilities_tx = IFCAP_CSUM_IPv4 | IFCAP_CSUM_TCPv4 |
+      IFCAP_CSUM_UDPv4;
+
     /* Intercept if_output for pulling off AVB packets */
     mx6q->stack_output = mx6q->ecom.ec_if.if_output;
     mx6q->ecom.ec_if.if_output = mx6q_output;
@@ -914,6 +1203,7 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
     struct ifnet        *ifp;
     int         i;
     struct mbuf     *m;
+    mx6q_rxbuf_t    *rb;
 
     ifp = &mx6q->ecom.ec_if;
 
@@ -935,6 +1225,10 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
         // shut down callbacks
         callout_stop(&mx6q->mii_callout);
         callout_stop(&mx6q->sqi_callout);
+        callout_stop(&mx6q->stats_callout);
+#ifdef MX6XSLX
+        callout_stop(&mx6q->ic_callout);
+#endif
 
         mx6q_reset(mx6q);
 
@@ -942,6 +1236,7 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
         if_detach(ifp);
 
         bsd_mii_finimedia(mx6q);
+        mx6q_phy_irq_fini(mx6q);
         mx6q_fini_phy(mx6q);
 
     //
@@ -969,8 +1264,12 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
 	    mx6q->iid_err = -1;
 	}
     case 11:
-        nw_pthread_reap(mx6q->tid);
+        mx6q_sim_fini(mx6q);
+        for (i = 0; i < mx6q->num_rx_threads; i++) {
+            nw_pthread_reap(mx6q->rx_thread[i].tid);
+        }
     case 10:
+        mx6q_avtp_fini(mx6q);
         pthread_mutex_destroy(&mx6q->rx_mutex);
     case 9:
         interrupt_entry_remove(&mx6q->inter_queue, NULL);
@@ -979,15 +1278,30 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
     case 7:
         IF_PURGE(&mx6q->rx_queue);
         pthread_mutex_destroy(&mx6q->rx_mutex);
-        ConnectDetach(mx6q->coid);
-        ChannelDestroy(mx6q->chid);
+        for (i = 0; i < mx6q->num_rx_threads; i++) {
+            ConnectDetach(mx6q->rx_thread[i].coid);
+            ChannelDestroy(mx6q->rx_thread[i].chid);
+        }
+        for (i = 0; i < NUM_RX_QUEUES; i++) {
+            if ((m = mx6q->rpkt[i])) {
+                m_freem(m);
+                mx6q->rpkt[i] = mx6q->rpkt_tail[i] = NULL;
+            }
+        }
+        // Lent buffers free the retired pools when the stack lets go
         for (i = 0; i < mx6q->num_rx_descriptors * NUM_RX_QUEUES;
              i++) {
-            if ((m = mx6q->rx_pkts[i])) {
-                m_freem(m);
+            if ((rb = mx6q->rx_bufs[i])) {
+                mx6q_rxp_put(rb);
+            }
+        }
+        for (i = 0; i < NUM_RX_QUEUES; i++) {
+            if (mx6q->rxp[i] != NULL) {
+                mx6q_rxp_retire(mx6q->rxp[i]);
+                mx6q->rxp[i] = NULL;
             }
         }
-        free(mx6q->rx_pkts, M_DEVBUF);
+        free(mx6q->rx_bufs, M_DEVBUF);
 
     case 6:
         munmap(mx6q->rx_bd, sizeof(mpc_bd_t) *
@@ -1001,6 +1315,10 @@ mx6q_destroy(mx6q_dev_t *mx6q, int how)
             }
         }
         free(mx6q->tx_pkts, M_DEVBUF);
+        if (mx6q->tx_stamp != NULL) {
+            free(mx6q->tx_stamp, M_DEVBUF);
+            mx6q->tx_stamp = NULL;
+        }
 
     case 4:
         munmap(mx6q->tx_bd, sizeof(mpc_bd_t) *
@@ -1190,6 +1508,37 @@ void DumpPhy(mx6q_dev_t *mx6q)
     log(LOG_INFO,"--------DumpPhy END----------\r\n");
 }
 
+//
+// Program the receive buffer size so a frame of up to frame bytes lands
+// in one descriptor. The buffers are io-pkt clusters, so when mclbytes is
+// smaller than the frame the MAC fills whole clusters and mx6q_receive()
+// chains them. The descriptors always hold full clusters, so this can
+// change under a running MAC without touching the ring.
+//
+static void
+mx6q_set_rx_buf_size (mx6q_dev_t *mx6q, int frame)
+{
+    volatile uint32_t   *base = mx6q->reg;
+    uint32_t            size, max;
+
+    // R_BUF_SIZE, bits 13:4 of ENET_MRBR, caps a buffer at 16368 bytes
+    max = min(MCLBYTES, MX6Q_MRBR_MASK) & ~(MX6Q_RBUFF_ALIGN - 1);
+    size = (frame + MX6Q_RBUFF_ALIGN - 1) & ~(MX6Q_RBUFF_ALIGN - 1);
+    if (size > max) {
+        log(LOG_INFO, "%s(): %d byte frames span %d byte rx buffers, start "
+            "io-pkt with mclbytes=%d to receive them in one", __FUNCTION__,
+            frame, max, size);
+        size = max;
+    }
+    mx6q->rx_buf_size = size;
+
+    *(base + MX6Q_R_BUFF_SIZE) = size & MX6Q_MRBR_MASK;
+#ifdef MX6XSLX
+    *(base + MX6Q_R_BUFF_SIZE1) = size & MX6Q_MRBR_MASK;
+    *(base + MX6Q_R_BUFF_SIZE2) = size & MX6Q_MRBR_MASK;
+#endif
+}
+
 static int
 mx6q_init (struct ifnet *ifp)
 {
@@ -1197,7 +1546,7 @@ mx6q_init (struct ifnet *ifp)
     nic_config_t        *cfg = &mx6q->cfg;
     volatile uint32_t   *base = mx6q->reg;
     int                  mtu;
-    uint32_t             rcntrl;
+    uint32_t             rcntrl, tacc;
 
     if (cfg->verbose > 3) {
         log(LOG_ERR, "%s(): starting: idx %d\n",
@@ -1243,6 +1592,22 @@ mx6q_init (struct ifnet *ifp)
         *(base + MX6Q_TRUNC_FL_ADDR) = mtu;
     }
 
+    mx6q_set_rx_buf_size(mx6q, mtu);
+
+    /*
+     * Tx checksum insertion as enabled by ifconfig. This relies on the
+     * Tx FIFO being in store and forward mode which is set at attach.
+     * Rx checksum results are always in the enhanced descriptors.
+     */
+    tacc = 0;
+    if (ifp->if_capenable_tx & IFCAP_CSUM_IPv4) {
+        tacc |= TACC_IPCHK;
+    }
+    if (ifp->if_capenable_tx & (IFCAP_CSUM_TCPv4 | IFCAP_CSUM_UDPv4)) {
+        tacc |= TACC_PROCHK;
+    }
+    *(base + MX6Q_IPACCTXCONF_ADDR) = tacc;
+
     if ((ifp->if_flags & IFF_RUNNING) == 0) {
 	NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
 	InterruptLock(&mx6q->spinlock);
@@ -1251,20 +1616,36 @@ mx6q_init (struct ifnet *ifp)
 	InterruptUnlock(&mx6q->spinlock);
 	NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
 
-        if (!mx6_is_br_phy(mx6q)) {
-	    bsd_mii_mediachange(ifp);
+	if (mx6q->sim_mac) {
+	    // The MAC stays off, the sim thread does the DMA's work
+	    mx6q_sim_start(mx6q);
 	} else {
-	    mx6q_MDI_MonitorPhy(mx6q);
-	}
+	    if (!mx6_is_br_phy(mx6q)) {
+		bsd_mii_mediachange(ifp);
+	    } else {
+		mx6q_MDI_MonitorPhy(mx6q);
+	    }
+
+	    // PHY is now ready, turn on MAC
+	    *(base + MX6Q_ECNTRL) |= ECNTRL_ETHER_EN;
+	    *(base + MX6Q_ECNTRL) &= ~ECNTRL_SLEEP;
 
-	// PHY is now ready, turn on MAC
-	*(base + MX6Q_ECNTRL) |= ECNTRL_ETHER_EN;
-	*(base + MX6Q_ECNTRL) &= ~ECNTRL_SLEEP;
+	    // Instruct MAC to process recieve frames
+	    *(base + MX6Q_R_DES_ACTIVE) = R_DES_ACTIVE;
+	}
 
-	// Instruct MAC to process recieve frames
-	*(base + MX6Q_R_DES_ACTIVE) = R_DES_ACTIVE;
+	// Start the periodic MIB harvest
+	callout_msec(&mx6q->stats_callout, MX6Q_STATS_INTERVAL,
+		     mx6q_stats_callout, mx6q);
 #ifdef MX6XSLX
-	if ((*(base + MX6Q_QOS_SCHEME) & QOS_SCHEME_RX_FLUSH0) != 0) {
+	if (mx6q->ic_adaptive) {
+	    mx6q_ic_start(mx6q);
+	}
+	if (mx6q->rxq_steer) {
+	    mx6q_set_rx_class(mx6q);
+	}
+	if (((*(base + MX6Q_QOS_SCHEME) & QOS_SCHEME_RX_FLUSH0) != 0) ||
+	    mx6q->rxq_steer) {
 	    /* Rx class match is setup enable Rx on class 1 & 2 */
 	  *(base + MX6Q_R_DES_ACTIVE1) = R_DES_ACTIVE;
 	  *(base + MX6Q_R_DES_ACTIVE2) = R_DES_ACTIVE;
@@ -1314,32 +1695,18 @@ mx6q_speeduplex (mx6q_dev_t *mx6q)
     }
 }
 
+//
+// Stop the MAC by putting it to sleep and wait for the DMA to gracefully
+// stop. Tx must be locked out by the caller.
+//
 static void
-mx6q_stop(struct ifnet *ifp, int disable)
+mx6q_sleep(mx6q_dev_t *mx6q)
 {
-    mx6q_dev_t		*mx6q = ifp->if_softc;
-    uint32_t		rx_active, tx_active, i, queue, offset;
+    uint32_t		rx_active, tx_active, i;
     volatile uint32_t	rx, tx;
-    mpc_bd_t		*bd;
-    struct mbuf		*m;
     volatile uint32_t	*base = mx6q->reg;
 
-    // shut down mii probing
-    callout_stop(&mx6q->mii_callout);
-    callout_stop(&mx6q->sqi_callout);
-    MDI_DisableMonitor(mx6q->mdi);
-    mx6q->cfg.flags |= NIC_FLAG_LINK_DOWN;
-    if_link_state_change(ifp, LINK_STATE_DOWN);
-
-    /* Take the locks */
-    NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
     InterruptLock(&mx6q->spinlock);
-
-    /* Mark the interface as down */
-    ifp->if_flags &= ~(IFF_RUNNING);
-    ifp->if_flags_tx &= ~(IFF_OACTIVE | IFF_RUNNING);
-
-    // stop the MAC by putting it to sleep
     *(base + MX6Q_ECNTRL) |= ECNTRL_SLEEP;
 
     /* If the DMA was running wait for it to gracefully stop */
@@ -1363,6 +1730,41 @@ mx6q_stop(struct ifnet *ifp, int disable)
     if (i >= STOP_TIMEOUT) {
 	log(LOG_ERR, "%s(): Failed to gracefully stop", __FUNCTION__);
     }
+}
+
+static void
+mx6q_stop(struct ifnet *ifp, int disable)
+{
+    mx6q_dev_t		*mx6q = ifp->if_softc;
+    uint32_t		i, queue, offset;
+    mpc_bd_t		*bd;
+    struct mbuf		*m;
+
+    // shut down mii probing and the MIB harvest
+    callout_stop(&mx6q->mii_callout);
+    callout_stop(&mx6q->sqi_callout);
+    callout_stop(&mx6q->stats_callout);
+#ifdef MX6XSLX
+    callout_stop(&mx6q->ic_callout);
+#endif
+    MDI_DisableMonitor(mx6q->mdi);
+    mx6q->cfg.flags |= NIC_FLAG_LINK_DOWN;
+    if_link_state_change(ifp, LINK_STATE_DOWN);
+
+    /* Take the locks */
+    NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+    InterruptLock(&mx6q->spinlock);
+
+    /* Mark the interface as down */
+    ifp->if_flags &= ~(IFF_RUNNING);
+    ifp->if_flags_tx &= ~(IFF_OACTIVE | IFF_RUNNING);
+
+    InterruptUnlock(&mx6q->spinlock);
+
+    if (mx6q->sim_mac) {
+        mx6q_sim_stop(mx6q);
+    }
+    mx6q_sleep(mx6q);
 
     for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
         offset = mx6q->num_tx_descriptors * queue;
@@ -1396,6 +1798,287 @@ mx6q_stop(struct ifnet *ifp, int disable)
     }
 }
 
+//
+// Resize the descriptor rings without taking the interface down. The Rx
+// threads are quiesced and Tx locked out while the MAC sleeps and the
+// rings are swapped. Anything still in the old rings is carried over in
+// order, so shrinking below what is in flight fails with EBUSY. A new Rx
+// ring size gets new buffer pools, the old ones are retired and go once
+// their buffers have all come back.
+//
+int
+mx6q_ring_resize(mx6q_dev_t *mx6q, uint32_t num_rx, uint32_t num_tx)
+{
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    volatile uint32_t	*base = mx6q->reg;
+    mpc_bd_t		*rx_bd, *tx_bd, *old_rx_bd, *old_tx_bd, *bd;
+    mx6q_rxbuf_t	**rx_bufs, **old_rx_bufs, *rb;
+    mx6q_rxpool_t	*rxp[NUM_RX_QUEUES], *old_rxp;
+    struct mbuf		**tx_pkts, **old_tx_pkts, *m;
+    uint64_t		*tx_stamp, *old_tx_stamp;
+    uint32_t		old_rx, old_tx, queue, i, j, full;
+    uint32_t		ecntrl, rx_active;
+    int			rc = EOK;
+
+    old_rx = mx6q->num_rx_descriptors;
+    old_tx = mx6q->num_tx_descriptors;
+    if (num_rx == 0) {
+        num_rx = old_rx;
+    }
+    if (num_tx == 0) {
+        num_tx = old_tx;
+    }
+    num_rx &= ~3;
+    num_rx = max(num_rx, MIN_NUM_RX_DESCRIPTORS);
+    num_rx = min(num_rx, MAX_NUM_RX_DESCRIPTORS);
+    num_tx &= ~3;
+    num_tx = max(num_tx, MIN_NUM_TX_DESCRIPTORS);
+    num_tx = min(num_tx, MAX_NUM_TX_DESCRIPTORS);
+    if ((num_rx == old_rx) && (num_tx == old_tx)) {
+        return EOK;
+    }
+
+    // Get everything that can fail before traffic stops
+    rx_bd = tx_bd = MAP_FAILED;
+    rx_bufs = NULL;
+    tx_pkts = NULL;
+    tx_stamp = NULL;
+    memset(rxp, 0, sizeof(rxp));
+
+    rx_bd = mmap(NULL, sizeof(mpc_bd_t) * num_rx * NUM_RX_QUEUES,
+                 PROT_READ | PROT_WRITE | PROT_NOCACHE,
+                 MAP_ANON | MAP_PHYS | MAP_SHARED, NOFD, 0);
+    tx_bd = mmap(NULL, sizeof(mpc_bd_t) * num_tx * NUM_TX_QUEUES,
+                 PROT_READ | PROT_WRITE | PROT_NOCACHE,
+                 MAP_ANON | MAP_PHYS | MAP_SHARED, NOFD, 0);
+    rx_bufs = malloc(sizeof(mx6q_rxbuf_t *) * num_rx * NUM_RX_QUEUES,
+                     M_DEVBUF, M_NOWAIT);
+    tx_pkts = malloc(sizeof(struct mbuf *) * num_tx * NUM_TX_QUEUES,
+                     M_DEVBUF, M_NOWAIT);
+    if ((rx_bd == MAP_FAILED) || (tx_bd == MAP_FAILED) ||
+        (rx_bufs == NULL) || (tx_pkts == NULL)) {
+        log(LOG_ERR, "%s(): ring alloc failed", __FUNCTION__);
+        rc = ENOBUFS;
+        goto done;
+    }
+    memset(rx_bufs, 0, sizeof(mx6q_rxbuf_t *) * num_rx * NUM_RX_QUEUES);
+    memset(tx_pkts, 0, sizeof(struct mbuf *) * num_tx * NUM_TX_QUEUES);
+    if (mx6q->tx_stamp != NULL) {
+        tx_stamp = malloc(sizeof(uint64_t) * num_tx * NUM_TX_QUEUES,
+                          M_DEVBUF, M_NOWAIT);
+        if (tx_stamp == NULL) {
+            log(LOG_ERR, "%s(): malloc tx_stamp failed, no tx latency",
+                __FUNCTION__);
+        }
+    }
+    if (num_rx != old_rx) {
+        for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+            rxp[queue] = mx6q_rxp_create(mx6q, MX6Q_RXP_BUFS(num_rx));
+            if (rxp[queue] == NULL) {
+                rc = ENOBUFS;
+                goto done;
+            }
+        }
+    }
+
+    quiesce_all();
+    NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+
+    ecntrl = *(base + MX6Q_ECNTRL);
+    rx_active = (*(base + MX6Q_R_DES_ACTIVE) != 0) ? (1 << 0) : 0;
+#ifdef MX6XSLX
+    rx_active |= (*(base + MX6Q_R_DES_ACTIVE1) != 0) ? (1 << 1) : 0;
+    rx_active |= (*(base + MX6Q_R_DES_ACTIVE2) != 0) ? (1 << 2) : 0;
+#endif
+    mx6q_sleep(mx6q);
+
+    // Will what is in flight fit?
+    for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+        mx6q_transmit_complete(mx6q, queue);
+        if (mx6q->tx_descr_inuse[queue] > num_tx) {
+            rc = EBUSY;
+        }
+    }
+    for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+        for (full = 0; full < old_rx; full++) {
+            bd = &mx6q->rx_bd[(queue * old_rx) +
+                              ((mx6q->rx_cidx[queue] + full) % old_rx)];
+            if (bd->status & RXBD_E) {
+                break;
+            }
+        }
+        if (full > num_rx) {
+            rc = EBUSY;
+        }
+    }
+
+    if (rc == EOK) {
+        // Rx, filled descriptors first then the empty ones, topped up
+        for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+            for (i = 0; i < num_rx; i++) {
+                bd = &rx_bd[(queue * num_rx) + i];
+                if (i < old_rx) {
+                    j = (queue * old_rx) + ((mx6q->rx_cidx[queue] + i) % old_rx);
+                    *bd = mx6q->rx_bd[j];
+                    rx_bufs[(queue * num_rx) + i] = mx6q->rx_bufs[j];
+                    mx6q->rx_bufs[j] = NULL;
+                } else {
+                    // Growing, so there is a new pool
+                    rb = mx6q_rxp_get(rxp[queue]);
+                    rx_bufs[(queue * num_rx) + i] = rb;
+                    memset(bd, 0, sizeof(*bd));
+                    bd->status = RXBD_E;
+                    bd->estatus = RXBD_ESTATUS_INT;
+                    bd->buffer = (uint32_t)rb->phys;
+                }
+                bd->status &= ~RXBD_W;
+                if (i == (num_rx - 1)) {
+                    bd->status |= RXBD_W;
+                }
+            }
+            mx6q->rx_cidx[queue] = 0;
+        }
+
+        // Tx, whatever hasn't gone out yet moves to the start
+        for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+            for (i = 0; i < num_tx; i++) {
+                bd = &tx_bd[(queue * num_tx) + i];
+                if (i < mx6q->tx_descr_inuse[queue]) {
+                    j = (queue * old_tx) + ((mx6q->tx_cidx[queue] + i) % old_tx);
+                    *bd = mx6q->tx_bd[j];
+                    tx_pkts[(queue * num_tx) + i] = mx6q->tx_pkts[j];
+                    mx6q->tx_pkts[j] = NULL;
+                    if (tx_stamp != NULL) {
+                        tx_stamp[(queue * num_tx) + i] = mx6q->tx_stamp[j];
+                    }
+                } else {
+                    memset(bd, 0, sizeof(*bd));
+                    bd->estatus = (queue << 20) | TXBD_ESTATUS_INT;
+                }
+                bd->status &= ~TXBD_W;
+                if (i == (num_tx - 1)) {
+                    bd->status |= TXBD_W;
+                }
+            }
+            mx6q->tx_cidx[queue] = 0;
+            mx6q->tx_pidx[queue] = mx6q->tx_descr_inuse[queue] % num_tx;
+        }
+
+        old_rx_bd = mx6q->rx_bd;
+        old_tx_bd = mx6q->tx_bd;
+        old_rx_bufs = mx6q->rx_bufs;
+        old_tx_pkts = mx6q->tx_pkts;
+        old_tx_stamp = mx6q->tx_stamp;
+
+        InterruptLock(&mx6q->spinlock);
+        // Disabling the MAC points the DMA back at the ring starts
+        *(base + MX6Q_ECNTRL) &= ~ECNTRL_ETHER_EN;
+        mx6q->rx_bd = rx_bd;
+        mx6q->tx_bd = tx_bd;
+        mx6q->rx_bufs = rx_bufs;
+        for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+            if (rxp[queue] != NULL) {
+                old_rxp = mx6q->rxp[queue];
+                mx6q->rxp[queue] = rxp[queue];
+                rxp[queue] = old_rxp;
+            }
+        }
+        mx6q->tx_pkts = tx_pkts;
+        mx6q->tx_stamp = tx_stamp;
+        mx6q->num_rx_descriptors = num_rx;
+        mx6q->num_tx_descriptors = num_tx;
+        *(base + MX6Q_X_DES_START) = vtophys((void *)&mx6q->tx_bd[0]);
+        *(base + MX6Q_R_DES_START) = vtophys((void *)&mx6q->rx_bd[0]);
+#ifdef MX6XSLX
+        *(base + MX6Q_X_DES_START1) = vtophys((void *)&mx6q->tx_bd[num_tx]);
+        *(base + MX6Q_R_DES_START1) = vtophys((void *)&mx6q->rx_bd[num_rx]);
+        *(base + MX6Q_X_DES_START2) = vtophys((void *)&mx6q->tx_bd[num_tx * 2]);
+        *(base + MX6Q_R_DES_START2) = vtophys((void *)&mx6q->rx_bd[num_rx * 2]);
+#endif
+        InterruptUnlock(&mx6q->spinlock);
+
+        // The old ones get freed below
+        rx_bd = old_rx_bd;
+        tx_bd = old_tx_bd;
+        rx_bufs = old_rx_bufs;
+        tx_pkts = old_tx_pkts;
+        tx_stamp = old_tx_stamp;
+        num_rx = old_rx;
+        num_tx = old_tx;
+    } else {
+        log(LOG_ERR, "%s(): frames in flight won't fit, try again",
+            __FUNCTION__);
+    }
+
+    // Back to how it was, kicking any queue with work
+    InterruptLock(&mx6q->spinlock);
+    *(base + MX6Q_ECNTRL) = ecntrl;
+    if ((ecntrl & ECNTRL_ETHER_EN) && !(ecntrl & ECNTRL_SLEEP)) {
+        if (rx_active & (1 << 0)) {
+            *(base + MX6Q_R_DES_ACTIVE) = R_DES_ACTIVE;
+        }
+        if (mx6q->tx_descr_inuse[0]) {
+            *(base + MX6Q_X_DES_ACTIVE) = X_DES_ACTIVE;
+        }
+#ifdef MX6XSLX
+        if (rx_active & (1 << 1)) {
+            *(base + MX6Q_R_DES_ACTIVE1) = R_DES_ACTIVE;
+        }
+        if (rx_active & (1 << 2)) {
+            *(base + MX6Q_R_DES_ACTIVE2) = R_DES_ACTIVE;
+        }
+        if (mx6q->tx_descr_inuse[1]) {
+            *(base + MX6Q_X_DES_ACTIVE1) = X_DES_ACTIVE;
+        }
+        if (mx6q->tx_descr_inuse[2]) {
+            *(base + MX6Q_X_DES_ACTIVE2) = X_DES_ACTIVE;
+        }
+#endif
+    }
+    InterruptUnlock(&mx6q->spinlock);
+    if (mx6q->sim_mac) {
+        // Picked up once the sim thread is unquiesced
+        mx6q_sim_sync(mx6q);
+        mx6q_sim_kick(mx6q);
+    }
+
+    NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+    unquiesce_all();
+
+done:
+    if (rx_bufs != NULL) {
+        for (i = 0; i < num_rx * NUM_RX_QUEUES; i++) {
+            if ((rb = rx_bufs[i])) {
+                mx6q_rxp_put(rb);
+            }
+        }
+        free(rx_bufs, M_DEVBUF);
+    }
+    for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+        if (rxp[queue] != NULL) {
+            mx6q_rxp_retire(rxp[queue]);
+        }
+    }
+    if (tx_pkts != NULL) {
+        for (i = 0; i < num_tx * NUM_TX_QUEUES; i++) {
+            if ((m = tx_pkts[i])) {
+                m_freem(m);
+            }
+        }
+        free(tx_pkts, M_DEVBUF);
+    }
+    if (tx_stamp != NULL) {
+        free(tx_stamp, M_DEVBUF);
+    }
+    if (rx_bd != MAP_FAILED) {
+        munmap(rx_bd, sizeof(mpc_bd_t) * num_rx * NUM_RX_QUEUES);
+    }
+    if (tx_bd != MAP_FAILED) {
+        munmap(tx_bd, sizeof(mpc_bd_t) * num_tx * NUM_TX_QUEUES);
+    }
+    return rc;
+}
+
 //
 // called from mx6q_entry() in mx6q.c
 //
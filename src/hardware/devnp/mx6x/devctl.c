@@ -33,11 +33,8 @@ mx6q_get_stats(mx6q_dev_t *mx6q, void *data)
 {
 	nic_stats_t				*stats = data;
 
-	// read nic hardware registers into mx6q data struct stats 
-	mx6q_update_stats(mx6q);
-
-	// copy it to the user buffer
-	memcpy(stats, &mx6q->stats, sizeof(mx6q->stats));
+	// read nic hardware registers and fold in the queue counters
+	mx6q_snapshot_stats(mx6q, stats);
 }
 
 int
@@ -147,6 +144,52 @@ mx6q_ioctl(struct ifnet *ifp, unsigned long cmd, caddr_t data)
 			error = mx6q_br_lowpower_disable_ioctl(mx6q, ifd);
 			break;
 
+		case GET_DRV_STATS:
+			error = mx6q_drv_stats_ioctl(mx6q, ifd);
+			break;
+
+		case GET_QUEUE_STATS:
+			error = mx6q_queue_stats_ioctl(mx6q, ifd);
+			break;
+
+		case GET_TX_TELEMETRY:
+			error = mx6q_tx_telemetry_ioctl(mx6q, ifd);
+			break;
+
+		case GET_PTP_TIMESTAMPS:
+			error = mx6q_ptp_batch_ioctl(mx6q, ifd);
+			break;
+
+		case GET_HISTOGRAMS:
+			error = mx6q_hist_get_ioctl(mx6q, ifd);
+			break;
+
+		case CLEAR_HISTOGRAMS:
+			error = mx6q_hist_clear_ioctl(mx6q, ifd);
+			break;
+
+		case GET_AVTP_RING:
+			error = mx6q_avtp_ioctl(mx6q, ifd);
+			break;
+
+		case GET_RING_SIZE:
+			error = mx6q_ring_get_ioctl(mx6q, ifd);
+			break;
+
+		case SET_RING_SIZE:
+			error = mx6q_ring_set_ioctl(mx6q, ifd);
+			break;
+
+#ifdef MX6XSLX
+		case GET_IC_STATE:
+			error = mx6q_ic_get_ioctl(mx6q, ifd);
+			break;
+
+		case SET_IC_ADAPTIVE:
+			error = mx6q_ic_set_ioctl(mx6q, ifd);
+			break;
+#endif
+
 		default:
 			error = mx6q_ptp_ioctl(mx6q, ifd);
 			break;
@@ -300,6 +343,290 @@ int mx6q_br_lowpower_disable_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	return EOK;
 }
 
+int mx6q_drv_stats_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	mx6q_drv_stats_t	drv_stats;
+	int			queue;
+
+	if (ifd->ifd_len != sizeof(drv_stats)) {
+		return EINVAL;
+	}
+
+	memset(&drv_stats, 0, sizeof(drv_stats));
+	drv_stats.tx_defrag = mx6q->tx_defrag;
+	drv_stats.tx_frag_copies = mx6q->tx_frag_copies;
+	drv_stats.mcast_groups = mx6q->mcf_groups;
+	drv_stats.mcast_gaddr_shared = mx6q->mcf_gaddr_shared;
+	drv_stats.mcast_probe_collisions = mx6q->mcf_probe_collisions;
+	drv_stats.sim_dropped = mx6q->sim_dropped;
+	for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+		drv_stats.mcast_dropped += mx6q->mcf_dropped[queue];
+		drv_stats.rx_pool_copies += mx6q->rx_pool_copies[queue];
+	}
+
+	if (ISSTACK) {
+		return (copyout(&drv_stats, (((uint8_t *)ifd) + sizeof(*ifd)),
+					sizeof(drv_stats)));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &drv_stats, sizeof(drv_stats));
+		return EOK;
+	}
+}
+
+int mx6q_queue_stats_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	mx6q_queue_stats_t	qstats;
+	mx6q_qstats_t		snap;
+	int			queue;
+
+	if (ifd->ifd_len != sizeof(qstats)) {
+		return EINVAL;
+	}
+
+	memset(&qstats, 0, sizeof(qstats));
+	qstats.num_rx_queues = NUM_RX_QUEUES;
+	qstats.num_tx_queues = NUM_TX_QUEUES;
+	for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+		mx6q_qstats_snap(&mx6q->rx_qstats[queue], &snap);
+		qstats.rx[queue].frames = snap.frames;
+		qstats.rx[queue].bytes = snap.bytes;
+		qstats.rx[queue].multicast = snap.multicast;
+		qstats.rx[queue].broadcast = snap.broadcast;
+		qstats.rx[queue].cycles = snap.cycles;
+		qstats.rx[queue].allocs = snap.allocs;
+	}
+	for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+		mx6q_qstats_snap(&mx6q->tx_qstats[queue], &snap);
+		qstats.tx[queue].frames = snap.frames;
+		qstats.tx[queue].bytes = snap.bytes;
+		qstats.tx[queue].multicast = snap.multicast;
+		qstats.tx[queue].broadcast = snap.broadcast;
+		qstats.tx[queue].cycles = snap.cycles;
+		qstats.tx[queue].allocs = snap.allocs;
+	}
+
+	if (ISSTACK) {
+		return (copyout(&qstats, (((uint8_t *)ifd) + sizeof(*ifd)),
+					sizeof(qstats)));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &qstats, sizeof(qstats));
+		return EOK;
+	}
+}
+
+int mx6q_tx_telemetry_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	struct ifnet		*ifp = &mx6q->ecom.ec_if;
+	mx6q_tx_telemetry_t		tel;
+	mx6q_txq_telemetry_t	*q;
+	mx6q_qstats_t		snap;
+	uint64_t			now;
+	int				queue;
+
+	if (ifd->ifd_len != sizeof(tel)) {
+		return EINVAL;
+	}
+
+	memset(&tel, 0, sizeof(tel));
+	tel.num_queues = NUM_TX_QUEUES;
+	tel.num_descriptors = mx6q->num_tx_descriptors;
+
+	now = mx6q_tx_now();
+	NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+	for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+		q = &tel.q[queue];
+		mx6q_qstats_snap(&mx6q->tx_qstats[queue], &snap);
+		q->frames = snap.frames;
+		q->bytes = snap.bytes;
+		q->blocked_ns = mx6q->tx_tel[queue].blocked_ns;
+		if (mx6q->tx_tel[queue].blk_start != 0) {
+			/* Still blocked, count it up to now */
+			q->blocked_ns += now - mx6q->tx_tel[queue].blk_start;
+		}
+		q->drops = mx6q->tx_tel[queue].drops;
+		q->inuse = mx6q->tx_descr_inuse[queue];
+		q->hwm = mx6q->tx_tel[queue].hwm;
+	}
+	NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+
+#ifdef MX6XSLX
+	tel.q[1].idle_slope = mx6q_get_idleslope(mx6q, 1);
+	tel.q[2].idle_slope = mx6q_get_idleslope(mx6q, 2);
+#endif
+
+	if (ISSTACK) {
+		return (copyout(&tel, (((uint8_t *)ifd) + sizeof(*ifd)),
+						sizeof(tel)));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &tel, sizeof(tel));
+		return EOK;
+	}
+}
+
+int mx6q_hist_get_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	struct ifnet		*ifp = &mx6q->ecom.ec_if;
+	mx6q_hist_t		*hist;
+	int			queue, err;
+
+	if (ifd->ifd_len != sizeof(*hist)) {
+		return EINVAL;
+	}
+
+	hist = malloc(sizeof(*hist), M_DEVBUF, M_NOWAIT);
+	if (hist == NULL) {
+		return ENOMEM;
+	}
+	memset(hist, 0, sizeof(*hist));
+	hist->num_rx_queues = NUM_RX_QUEUES;
+	hist->num_tx_queues = NUM_TX_QUEUES;
+
+	for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+		memcpy(hist->rx_irq_ns[queue], mx6q->h_rx_irq[queue],
+		       sizeof(mx6q->h_rx_irq[queue]));
+		memcpy(hist->rx_ring[queue], mx6q->h_rx_ring[queue],
+		       sizeof(mx6q->h_rx_ring[queue]));
+	}
+	NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+	for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+		memcpy(hist->tx_ring[queue], mx6q->h_tx_ring[queue],
+		       sizeof(mx6q->h_tx_ring[queue]));
+		memcpy(hist->tx_done_ns[queue], mx6q->h_tx_done[queue],
+		       sizeof(mx6q->h_tx_done[queue]));
+	}
+	NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+
+	if (ISSTACK) {
+		err = copyout(hist, (((uint8_t *)ifd) + sizeof(*ifd)),
+			      sizeof(*hist));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), hist, sizeof(*hist));
+		err = EOK;
+	}
+	free(hist, M_DEVBUF);
+	return err;
+}
+
+int mx6q_ring_get_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	mx6q_ring_size_t	rs;
+
+	if (ifd->ifd_len != sizeof(rs)) {
+		return EINVAL;
+	}
+
+	rs.num_rx_descriptors = mx6q->num_rx_descriptors;
+	rs.num_tx_descriptors = mx6q->num_tx_descriptors;
+
+	if (ISSTACK) {
+		return (copyout(&rs, (((uint8_t *)ifd) + sizeof(*ifd)),
+				sizeof(rs)));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &rs, sizeof(rs));
+		return EOK;
+	}
+}
+
+int mx6q_ring_set_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	mx6q_ring_size_t	rs;
+
+	if (ifd->ifd_len != sizeof(rs)) {
+		return EINVAL;
+	}
+
+	if (ISSTACK) {
+		if (copyin((((uint8_t *)ifd) + sizeof(*ifd)),
+			&rs, sizeof(rs))) {
+				return EINVAL;
+		}
+	} else {
+		memcpy(&rs, (((uint8_t *)ifd) + sizeof(*ifd)), sizeof(rs));
+	}
+
+	return mx6q_ring_resize(mx6q, rs.num_rx_descriptors,
+				rs.num_tx_descriptors);
+}
+
+int mx6q_hist_clear_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	struct ifnet		*ifp = &mx6q->ecom.ec_if;
+
+	/* Rx side may lose a count or two racing with the Rx threads */
+	memset(mx6q->h_rx_irq, 0, sizeof(mx6q->h_rx_irq));
+	memset(mx6q->h_rx_ring, 0, sizeof(mx6q->h_rx_ring));
+	NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+	memset(mx6q->h_tx_ring, 0, sizeof(mx6q->h_tx_ring));
+	memset(mx6q->h_tx_done, 0, sizeof(mx6q->h_tx_done));
+	NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+
+	return EOK;
+}
+
+#ifdef MX6XSLX
+int mx6q_ic_get_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	mx6q_ic_state_t	ic;
+
+	if (ifd->ifd_len != sizeof(ic)) {
+		return EINVAL;
+	}
+
+	InterruptLock(&mx6q->spinlock);
+	ic.adaptive = mx6q->ic_adaptive;
+	ic.level = mx6q->ic_level;
+	ic.rx_frame = (mx6q->ic_rxic >> 20) & 0xff;
+	ic.rx_delay = mx6q->ic_rxic & 0xffff;
+	ic.tx_frame = (mx6q->ic_txic >> 20) & 0xff;
+	ic.tx_delay = mx6q->ic_txic & 0xffff;
+	ic.pkt_rate = mx6q->ic_rate;
+	ic.changes = mx6q->ic_changes;
+	InterruptUnlock(&mx6q->spinlock);
+
+	if (ISSTACK) {
+		return (copyout(&ic, (((uint8_t *)ifd) + sizeof(*ifd)),
+					sizeof(ic)));
+	} else {
+		memcpy((((uint8_t *)ifd) + sizeof(*ifd)), &ic, sizeof(ic));
+		return EOK;
+	}
+}
+
+int mx6q_ic_set_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+	uint32_t	adaptive;
+
+	if (ifd->ifd_len != sizeof(adaptive)) {
+		return EINVAL;
+	}
+
+	if (ISSTACK) {
+		if (copyin((((uint8_t *)ifd) + sizeof(*ifd)),
+			&adaptive, sizeof(adaptive))) {
+				return EINVAL;
+		}
+	} else {
+		memcpy(&adaptive, (((uint8_t *)ifd) + sizeof(*ifd)), sizeof(adaptive));
+	}
+
+	if (adaptive) {
+		if (!mx6q->ic_adaptive) {
+			mx6q->ic_adaptive = 1;
+			if (mx6q->ecom.ec_if.if_flags & IFF_RUNNING) {
+				mx6q_ic_start(mx6q);
+			}
+		}
+	} else {
+		/* Back to the configured rx/tx_frame and rx/tx_delay */
+		mx6q->ic_adaptive = 0;
+		callout_stop(&mx6q->ic_callout);
+		mx6q_ic_program(mx6q, MX6Q_IC_LEVEL_BULK);
+	}
+
+	return EOK;
+}
+#endif
+
 #if defined(__QNXNTO__) && defined(__USESRCVERSION)
 #include <sys/srcversion.h>
 __SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devnp/mx6x/devctl.c $ $Rev: 806401 $")
@@ -123,12 +123,18 @@ mx6q_isr(void *arg, int iid)
         ((ievent & IEVENT_RXF1) != 0)) {
         *(base + MX6Q_IMASK) = imask & (~IMASK_RXF1EN);
         InterruptUnlock(&mx6q->spinlock);
+        if (mx6q->profile) {
+            mx6q->rx_irq_stamp[1] = ClockCycles();
+        }
         return &mx6q->isr_event[1];
     }
     if (((imask & IMASK_RXF2EN) != 0) &&
         ((ievent & IEVENT_RXF2) != 0)) {
         *(base + MX6Q_IMASK) = imask & (~IMASK_RXF2EN);
         InterruptUnlock(&mx6q->spinlock);
+        if (mx6q->profile) {
+            mx6q->rx_irq_stamp[2] = ClockCycles();
+        }
         return &mx6q->isr_event[2];
     }
 #endif
@@ -136,6 +142,9 @@ mx6q_isr(void *arg, int iid)
         ((ievent & IEVENT_RFINT) != 0)) {
         *(base + MX6Q_IMASK) = imask & (~IMASK_RFIEN);
         InterruptUnlock(&mx6q->spinlock);
+        if (mx6q->profile) {
+            mx6q->rx_irq_stamp[0] = ClockCycles();
+        }
         return &mx6q->isr_event[0];
     }
 
@@ -269,6 +278,168 @@ mx6q_process_interrupt(void *arg, struct nw_work_thread *wtp)
     return 1;
 }
 
+#ifdef MX6XSLX
+/*
+ * Register values for each adaptive interrupt coalescence level. Bulk is
+ * whatever was configured with rx/tx_frame and rx/tx_delay.
+ */
+void
+mx6q_ic_values(mx6q_dev_t *mx6q, uint32_t level, uint32_t *rxic, uint32_t *txic)
+{
+    *rxic = 0;
+    *txic = 0;
+
+    switch (level) {
+    case MX6Q_IC_LEVEL_MODERATE:
+	*rxic = RXIC_ICEN | RXIC_ICFT(RX_FRAME_MODERATE) |
+	  RXIC_ICTT(RX_DELAY_MODERATE);
+	*txic = TXIC_ICEN | TXIC_ICFT(TX_FRAME_MODERATE) |
+	  TXIC_ICTT(TX_DELAY_MODERATE);
+	break;
+    case MX6Q_IC_LEVEL_BULK:
+	if (mx6q->rx_frame && mx6q->rx_delay) {
+	    *rxic = RXIC_ICEN | RXIC_ICFT(mx6q->rx_frame) |
+	      RXIC_ICTT(mx6q->rx_delay);
+	}
+	if (mx6q->tx_frame && mx6q->tx_delay) {
+	    *txic = TXIC_ICEN | TXIC_ICFT(mx6q->tx_frame) |
+	      TXIC_ICTT(mx6q->tx_delay);
+	}
+	break;
+    default:
+	/* Idle, coalescence off for lowest latency */
+	break;
+    }
+}
+
+void
+mx6q_ic_program(mx6q_dev_t *mx6q, uint32_t level)
+{
+    volatile uint32_t	*base = mx6q->reg;
+    uint32_t		rxic, txic;
+
+    mx6q_ic_values(mx6q, level, &rxic, &txic);
+
+    InterruptLock(&mx6q->spinlock);
+    /* Adaptive mode may have been switched off in the meantime */
+    if (!mx6q->ic_adaptive && (level != MX6Q_IC_LEVEL_BULK)) {
+	InterruptUnlock(&mx6q->spinlock);
+	return;
+    }
+    /* ICEN must be cleared before the thresholds can be changed */
+    if (txic != mx6q->ic_txic) {
+	*(base + MX6SLX_TXIC0) = 0;
+	*(base + MX6SLX_TXIC1) = 0;
+	*(base + MX6SLX_TXIC2) = 0;
+	*(base + MX6SLX_TXIC0) = txic;
+	*(base + MX6SLX_TXIC1) = txic;
+	*(base + MX6SLX_TXIC2) = txic;
+	mx6q->ic_txic = txic;
+    }
+    if (rxic != mx6q->ic_rxic) {
+	*(base + MX6SLX_RXIC0) = 0;
+	*(base + MX6SLX_RXIC0) = rxic;
+	mx6q->ic_rxic = rxic;
+    }
+    if (level != mx6q->ic_level) {
+	mx6q->ic_level = level;
+	mx6q->ic_changes++;
+    }
+    InterruptUnlock(&mx6q->spinlock);
+}
+
+/*
+ * Called from mx6q_ic_callout(). Samples the packet rate and steps the
+ * coalescence level up one at a time. An idle link drops straight from
+ * bulk to off so the next frame is not held for the bulk ICTT.
+ */
+void
+mx6q_ic_adapt(mx6q_dev_t *mx6q)
+{
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    struct timespec	ts;
+    uint64_t		now, elapsed, pkts;
+    uint32_t		level;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = timespec2nsec(&ts);
+    elapsed = now - mx6q->ic_stamp;
+    if (elapsed == 0) {
+	return;
+    }
+
+    pkts = ifp->if_ipackets + ifp->if_opackets;
+    mx6q->ic_rate = (uint32_t)(((pkts - mx6q->ic_pkts) * 1000000000ULL) /
+			       elapsed);
+    mx6q->ic_pkts = pkts;
+    mx6q->ic_stamp = now;
+
+    level = mx6q->ic_level;
+    switch (level) {
+    case MX6Q_IC_LEVEL_IDLE:
+	if (mx6q->ic_rate > MX6Q_IC_MODERATE_UP) {
+	    level = MX6Q_IC_LEVEL_MODERATE;
+	}
+	break;
+    case MX6Q_IC_LEVEL_MODERATE:
+	if (mx6q->ic_rate > MX6Q_IC_BULK_UP) {
+	    level = MX6Q_IC_LEVEL_BULK;
+	} else if (mx6q->ic_rate < MX6Q_IC_MODERATE_DOWN) {
+	    level = MX6Q_IC_LEVEL_IDLE;
+	}
+	break;
+    default:
+	if (mx6q->ic_rate < MX6Q_IC_MODERATE_DOWN) {
+	    level = MX6Q_IC_LEVEL_IDLE;
+	} else if (mx6q->ic_rate < MX6Q_IC_BULK_DOWN) {
+	    level = MX6Q_IC_LEVEL_MODERATE;
+	}
+	break;
+    }
+
+    if (level != mx6q->ic_level) {
+	if (mx6q->cfg.verbose > 4) {
+	    log(LOG_INFO, "%s(): %u pkts/sec, level %u -> %u", __FUNCTION__,
+		mx6q->ic_rate, mx6q->ic_level, level);
+	}
+	mx6q_ic_program(mx6q, level);
+    }
+}
+
+/*
+ * Start sampling from now, called from mx6q_init() and SET_IC_ADAPTIVE
+ */
+void
+mx6q_ic_start(mx6q_dev_t *mx6q)
+{
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    mx6q->ic_stamp = timespec2nsec(&ts);
+    mx6q->ic_pkts = ifp->if_ipackets + ifp->if_opackets;
+    callout_msec(&mx6q->ic_callout, MX6Q_IC_INTERVAL, mx6q_ic_callout, mx6q);
+}
+
+/*
+ * Periodic rate sample, runs from the stack so it is serialised with
+ * SET_IC_ADAPTIVE and keeps running while no frames arrive
+ */
+void
+mx6q_ic_callout(void *arg)
+{
+    mx6q_dev_t		*mx6q = arg;
+
+    if (!mx6q->ic_adaptive || mx6q->dying) {
+	return;
+    }
+
+    mx6q_ic_adapt(mx6q);
+
+    callout_msec(&mx6q->ic_callout, MX6Q_IC_INTERVAL, mx6q_ic_callout, mx6q);
+}
+#endif
+
 #if defined(__QNXNTO__) && defined(__USESRCVERSION)
 #include <sys/srcversion.h>
 __SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devnp/mx6x/event.c $ $Rev: 807530 $")
@@ -24,6 +24,28 @@
 
 static pthread_mutex_t  mii_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Wait for an MDIO frame to finish. It takes 64 MDC clocks so there is
+ * no point looking before most of that has gone by, after which poll
+ * finely rather than overshooting by up to 10us. Same 10ms limit as
+ * before. Returns 0 on timeout.
+ */
+static int
+mx6q_mii_wait (volatile uint32_t *base)
+{
+    int                 timeout = MPC_TIMEOUT * 10;
+
+    nanospin_ns(MX6Q_MDIO_FRAME_NS);
+    while (timeout--) {
+        if (*(base + MX6Q_IEVENT) & IEVENT_MII) {
+            *(base + MX6Q_IEVENT) = IEVENT_MII;
+            return 1;
+        }
+        nanospin_ns(1000);
+    }
+    return 0;
+}
+
 /*
  * On the i.MX6 SoloX there are two interfaces but the PHYs are
  * typically both hung off the MDIO on the first. To overcome this
@@ -43,7 +65,6 @@ mx6q_mii_read (void *handle, uint8_t phy_add, uint8_t reg_add)
 {
     mx6q_dev_t         *mx6q = (mx6q_dev_t *) handle;
     volatile uint32_t  *base = mx6q->phy_reg;
-    int                 timeout = MPC_TIMEOUT;
     uint32_t            val;
     uint16_t            retval;
 
@@ -59,15 +80,7 @@ mx6q_mii_read (void *handle, uint8_t phy_add, uint8_t reg_add)
     val = ((1 << 30) | (0x2 << 28) | (phy_add << 23) | (reg_add << 18) | (2 << 16));
     *(base + MX6Q_MII_DATA) = val;
 
-    while (timeout--) {
-        if (*(base + MX6Q_IEVENT) & IEVENT_MII) {
-                *(base + MX6Q_IEVENT) = IEVENT_MII;
-                 break;
-        }
-        nanospin_ns (10000);
-    }
-
-    retval = ((timeout <= 0) ? 0 : (*(base + MX6Q_MII_DATA) & 0xffff));
+    retval = (mx6q_mii_wait(base) ? (*(base + MX6Q_MII_DATA) & 0xffff) : 0);
 
     _mutex_unlock(&mii_mutex);
 
@@ -79,7 +92,6 @@ mx6q_mii_write (void *handle, uint8_t phy_add, uint8_t reg_add, uint16_t data)
 {
     mx6q_dev_t         *mx6q = (mx6q_dev_t *) handle;
     volatile uint32_t  *base = mx6q->phy_reg;
-    int                 timeout = MPC_TIMEOUT;
     uint32_t            phy_data;
 
     _mutex_lock(&mii_mutex);
@@ -93,13 +105,7 @@ mx6q_mii_write (void *handle, uint8_t phy_add, uint8_t reg_add, uint16_t data)
     *(base + MX6Q_IEVENT) = IEVENT_MII;
     phy_data = ((1 << 30) | (0x1 << 28) | (phy_add << 23) | (reg_add << 18) | (2 << 16) | data);
     *(base + MX6Q_MII_DATA) = phy_data;
-    while (timeout--) {
-        if (*(base + MX6Q_IEVENT) & IEVENT_MII) {
-            *(base + MX6Q_IEVENT) = IEVENT_MII;
-            break;
-        }
-        nanospin_ns (10000);
-    }
+    mx6q_mii_wait(base);
 
     _mutex_unlock(&mii_mutex);
 }
@@ -474,17 +480,23 @@ mx6q_MDI_MonitorPhy (void *arg)
     mx6q_dev_t      *mx6q   = arg;
     nic_config_t        *cfg        = &mx6q->cfg;
     struct ifnet        *ifp        = &mx6q->ecom.ec_if;
+    uint32_t            link_down   = cfg->flags & NIC_FLAG_LINK_DOWN;
+    int                 interval;
 
     //
     // we will probe the PHY if:
     //   the user has forced it from the cmd line, or
+    //   the PHY interrupted or the link changed recently, or
     //   we have not rxd any packets since the last time we ran, or
     //   the link is considered down
     //
     if (mx6q->probe_phy ||
+      mx6q->phy_kick ||
+      mx6q->phy_fast ||
       !mx6q->rxd_pkts   ||
       cfg->media_rate <= 0 ||
       cfg->flags & NIC_FLAG_LINK_DOWN) {
+        mx6q->phy_kick = 0;
         if (cfg->verbose > 4) {
             log(LOG_ERR, "%s(): calling MDI_MonitorPhy()\n",  __FUNCTION__);
         }
@@ -503,7 +515,7 @@ mx6q_MDI_MonitorPhy (void *arg)
 
     //
     // Clean out the tx descriptor ring if it has not
-    // been done by the start routine in the last 2 seconds
+    // been done by the start routine since we last ran
     //
     if (!mx6q->tx_reaped) {
         NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
@@ -515,8 +527,131 @@ mx6q_MDI_MonitorPhy (void *arg)
     mx6q->tx_reaped = 0;  // reset for next time we are called
 
 
-    // restart timer to call us again in 2 seconds
-    callout_msec(&mx6q->mii_callout, 2 * 1000, mx6q_MDI_MonitorPhy, mx6q);
+    //
+    // Poll quickly for a while after the link changes so a flapping
+    // cable or autoneg restart settles fast, and back off when stable.
+    //
+    if ((cfg->flags & NIC_FLAG_LINK_DOWN) != link_down) {
+        mx6q->phy_fast = MX6Q_PHY_FAST_POLLS;
+
+        // a PHY reset clears the interrupt enables and drops the link,
+        // so set them again here rather than on every pass
+        if (mx6q->iid_phy != -1) {
+            mx6q_mii_write(mx6q, cfg->phy_addr, mx6q->phy_int[0],
+                           mx6q->phy_int[1]);
+        }
+    }
+    if (mx6q->phy_fast) {
+        mx6q->phy_fast--;
+        interval = MX6Q_PHY_POLL_FAST;
+    } else if (mx6q->iid_phy != -1) {
+        // PHY interrupt tells us about changes, this is just a backstop
+        interval = MX6Q_PHY_POLL_IRQ;
+    } else if (cfg->flags & NIC_FLAG_LINK_DOWN) {
+        interval = MX6Q_PHY_POLL_DOWN;
+    } else {
+        interval = MX6Q_PHY_POLL_SLOW;
+    }
+
+    callout_msec(&mx6q->mii_callout, interval, mx6q_MDI_MonitorPhy, mx6q);
+}
+
+//
+// PHY INT line, masked here until mx6q_phy_process() has cleared
+// the cause in the PHY.
+//
+static const struct sigevent *
+mx6q_phy_isr (void *arg, int iid)
+{
+    mx6q_dev_t          *mx6q = arg;
+
+    InterruptMask(mx6q->phy_irq, iid);
+    return interrupt_queue(mx6q->iopkt, &mx6q->inter_phy);
+}
+
+static int
+mx6q_phy_process (void *arg, struct nw_work_thread *wtp)
+{
+    mx6q_dev_t          *mx6q = arg;
+    struct ifnet        *ifp  = &mx6q->ecom.ec_if;
+
+    // reading the status clears the PHY interrupt
+    mx6q_mii_read(mx6q, mx6q->cfg.phy_addr, mx6q->phy_int[2]);
+    mx6q->phy_events++;
+
+    // let the monitor probe right away, from stack context as usual,
+    // but don't restart it once mx6q_stop() has stopped it, nor run it
+    // at all under sim_mac where the link is always up
+    if (!mx6q->dying && !mx6q->sim_mac && (ifp->if_flags & IFF_RUNNING)) {
+        mx6q->phy_kick = 1;
+        callout_msec(&mx6q->mii_callout, 0, mx6q_MDI_MonitorPhy, mx6q);
+    }
+    return 1;
+}
+
+static int
+mx6q_phy_enable (void *arg)
+{
+    mx6q_dev_t          *mx6q = arg;
+
+    InterruptUnmask(mx6q->phy_irq, mx6q->iid_phy);
+    return 1;
+}
+
+//
+// Hook up the PHY interrupt if phy_irq and phy_int were given.
+//
+int
+mx6q_phy_irq_init (mx6q_dev_t *mx6q)
+{
+    nic_config_t        *cfg = &mx6q->cfg;
+    int                 rc;
+
+    if (mx6q->phy_irq == -1) {
+        return EOK;
+    }
+    if (mx6q->phy_int[0] == -1) {
+        log(LOG_ERR, "%s(): phy_irq needs phy_int, polling the PHY",
+            __FUNCTION__);
+        return EOK;
+    }
+
+    mx6q->inter_phy.func = mx6q_phy_process;
+    mx6q->inter_phy.enable = mx6q_phy_enable;
+    mx6q->inter_phy.arg = mx6q;
+
+    if ((rc = interrupt_entry_init(&mx6q->inter_phy, 0, NULL,
+        cfg->priority)) != EOK) {
+        log(LOG_ERR, "%s(): interrupt_entry_init(phy) failed: %d",
+            __FUNCTION__, rc);
+        return rc;
+    }
+
+    // clear anything stale then enable link interrupts in the PHY
+    mx6q_mii_read(mx6q, cfg->phy_addr, mx6q->phy_int[2]);
+    mx6q_mii_write(mx6q, cfg->phy_addr, mx6q->phy_int[0], mx6q->phy_int[1]);
+
+    if ((rc = InterruptAttach_r(mx6q->phy_irq, mx6q_phy_isr,
+        mx6q, sizeof(*mx6q), _NTO_INTR_FLAGS_TRK_MSK)) < 0) {
+        rc = -rc;
+        log(LOG_ERR, "%s(): InterruptAttach_r(phy) failed: %d",
+            __FUNCTION__, rc);
+        interrupt_entry_remove(&mx6q->inter_phy, NULL);
+        return rc;
+    }
+    mx6q->iid_phy = rc;
+
+    return EOK;
+}
+
+void
+mx6q_phy_irq_fini (mx6q_dev_t *mx6q)
+{
+    if (mx6q->iid_phy != -1) {
+        InterruptDetach(mx6q->iid_phy);
+        mx6q->iid_phy = -1;
+        interrupt_entry_remove(&mx6q->inter_phy, NULL);
+    }
 }
 
 static int mx6_get_phy_addr (mx6q_dev_t *mx6q)
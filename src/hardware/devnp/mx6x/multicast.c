@@ -23,11 +23,90 @@
 
 #define NUM_GADDR 2
 
+//
+// Software filter slot for a group address. Groups of one kind (IP
+// mapped, MAAP, AVTP streams) differ in the low bytes so hash those.
+//
+static inline uint32_t
+mx6q_mcf_hash(const uint8_t *addr)
+{
+	uint32_t			v;
+
+	v = (addr[2] << 24) | (addr[3] << 16) | (addr[4] << 8) | addr[5];
+	return ((v * 2654435761u) >> 16) & (MX6Q_MCF_SIZE - 1);
+}
+
+static void
+mx6q_mcf_add(mx6q_dev_t *mx6q, const uint8_t *addr)
+{
+	mx6q_mcf_ent_t			*ent;
+	uint32_t			h, i;
+
+	if (mx6q->mcf_groups >= MX6Q_MCF_MAX) {
+		/* Table would get too full to probe quickly */
+		mx6q->mcf_all = 1;
+		return;
+	}
+
+	h = mx6q_mcf_hash(addr);
+	for (i = 0; i < MX6Q_MCF_SIZE; i++) {
+		ent = &mx6q->mcf_table[(h + i) & (MX6Q_MCF_SIZE - 1)];
+		if (!ent->used) {
+			memcpy(ent->addr, addr, ETHER_ADDR_LEN);
+			ent->used = 1;
+			mx6q->mcf_groups++;
+			return;
+		}
+		if (memcmp(ent->addr, addr, ETHER_ADDR_LEN) == 0) {
+			return;
+		}
+		mx6q->mcf_probe_collisions++;
+	}
+}
+
+//
+// Called from the Rx path for multicast frames that passed the GADDR
+// hash. Returns non zero if a group we joined, or if the table is being
+// rebuilt under us in which case the stack gets to decide.
+//
+int
+mx6q_mcf_match(mx6q_dev_t *mx6q, const uint8_t *addr)
+{
+	mx6q_mcf_ent_t			*ent;
+	uint32_t			seq, h, i;
+	int				found = 0;
+
+	seq = mx6q->mcf_seq;
+	if ((seq & 1) || mx6q->mcf_all) {
+		return 1;
+	}
+	__sync_synchronize();
+
+	h = mx6q_mcf_hash(addr);
+	for (i = 0; i < MX6Q_MCF_SIZE; i++) {
+		ent = &mx6q->mcf_table[(h + i) & (MX6Q_MCF_SIZE - 1)];
+		if (!ent->used) {
+			break;
+		}
+		if (memcmp(ent->addr, addr, ETHER_ADDR_LEN) == 0) {
+			found = 1;
+			break;
+		}
+	}
+
+	__sync_synchronize();
+	if (seq != mx6q->mcf_seq) {
+		return 1;
+	}
+	return found;
+}
+
 
 // 
 // called from mx6q_init() and mx6q_ioctl()
 // to calculate the multicast group address hash 
 // mask for the current set of multicast addresses
+// and rebuild the software exact match filter
 //
 
 void
@@ -40,13 +119,22 @@ mx6q_set_multicast(mx6q_dev_t *mx6q)
 	struct ether_multistep		step;
 	int				i;
 	uint32_t			gaddr_val[NUM_GADDR];
-	uint32_t			h;
+	uint32_t			h, bit;
 
 	// wipe our temporary image of gaddr registers on the stack
 	for(i=0; i<NUM_GADDR; i++) {
 		gaddr_val[i] = 0;
 	}	
 
+	// readers skip the software filter until seq is even again
+	mx6q->mcf_seq++;
+	__sync_synchronize();
+	memset(mx6q->mcf_table, 0, sizeof(mx6q->mcf_table));
+	mx6q->mcf_all = 0;
+	mx6q->mcf_groups = 0;
+	mx6q->mcf_gaddr_shared = 0;
+	mx6q->mcf_probe_collisions = 0;
+
 	ETHER_FIRST_MULTI(step, ec, enm);
 	while (enm != NULL) {
                 if (memcmp(enm->enm_addrlo, enm->enm_addrhi, ETHER_ADDR_LEN)) {
@@ -67,11 +155,15 @@ mx6q_set_multicast(mx6q_dev_t *mx6q)
 		/* Just want the 6 most-significant bits. */
                 h = (h >> 26) & 0x3f;
 
-		if (h & 0x20) {
-			gaddr_val[0] |= 1 << (h & 0x1f);
-		} else {
-			gaddr_val[1] |= 1 << (h & 0x1f);
+		bit = 1 << (h & 0x1f);
+		i = (h & 0x20) ? 0 : 1;
+		if (gaddr_val[i] & bit) {
+			/* Hardware can't tell this one from an earlier group */
+			mx6q->mcf_gaddr_shared++;
 		}
+		gaddr_val[i] |= bit;
+
+		mx6q_mcf_add(mx6q, enm->enm_addrlo);
 
 		ETHER_NEXT_MULTI(step, enm);
 	}
@@ -84,6 +176,7 @@ allmulti:
 		gaddr_val[i] = 0xffffffff;
 	}	
 	ifp->if_flags |= IFF_ALLMULTI;
+	mx6q->mcf_all = 1;
 
 	//
 	// write our calculated gaddr vals out to hardware registers
@@ -99,6 +192,9 @@ setit:
 	for(i=0; i<NUM_GADDR; i++) {
 		gaddr_reg[i] = gaddr_val[i];
 	}
+
+	__sync_synchronize();
+	mx6q->mcf_seq++;
 }
 
 #if defined(__QNXNTO__) && defined(__USESRCVERSION)
@@ -53,6 +53,7 @@
 #include <netdrvr/ptp.h>
 
 #include <hw/nicinfo.h>
+#include <hw/imx6x_devnp_ioctl.h>
 
 #include <net/if.h>
 #include <net/if_dl.h>
@@ -74,6 +75,7 @@
 
 #define MX6Q_QUIESCE_PULSE  _PULSE_CODE_MINAVAIL
 #define MX6Q_RX_PULSE       (MX6Q_QUIESCE_PULSE + 1)
+#define MX6Q_SIM_PULSE      (MX6Q_RX_PULSE + 1)
 
 /*
  * Timer registers
@@ -121,15 +123,27 @@
  * Note that in general a TCP stream sends packets in 3 descriptors:
  * header, last part of previous cluster, first part of next cluster.
  * Extending this to a jumbo frame of 9k gives a header + 6 clusters.
- * Allow a few extras to try and avoid defragging all the time.
+ * Longer chains do turn up from io-pkt though, and spanning them across
+ * more descriptors is far cheaper than copying the frame. This many are
+ * kept free for the next frame, so it is held to a quarter of
+ * MIN_NUM_TX_DESCRIPTORS; longer chains still go through mx6q_defrag().
  */
-#define MX6Q_MAX_FRAGS          10
+#define MX6Q_MAX_FRAGS          16
 
 /*
- * Freescale have confirmed the spec is wrong, only bits 6-10 should be set.
- * N.B. This is used as a mask as well as a max.
+ * mx6q_start() loads up to this many frames from if_snd before it
+ * kicks X_DES_ACTIVE, rather than kicking for every frame.
  */
-#define MX6Q_MAX_RBUFF_SIZE     1984
+#define MX6Q_TX_BATCH           16
+
+/*
+ * ENET_MRBR R_BUF_SIZE is bits 13:4, the receive buffer size in bytes
+ * with the low four bits always zero (i.MX6 RM, Maximum Receive Buffer
+ * Size Register), so at most 16368 bytes. Buffers are kept to a multiple
+ * of 64 bytes, the uDMA burst.
+ */
+#define MX6Q_MRBR_MASK          0x3ff0
+#define MX6Q_RBUFF_ALIGN        64
 
 /*
  * io-pkt defaults to 8192 clusters of 2048 bytes each.
@@ -147,6 +161,24 @@
 #define MAX_NUM_RX_DESCRIPTORS      2048
 #define MAX_NUM_TX_DESCRIPTORS      2048
 
+/*
+ * Received frames up to this size (including FCS) are copied into a
+ * plain mbuf and the rx cluster is handed straight back to the nic.
+ * Can't be more than MHLEN.
+ */
+#define DEFAULT_RX_COPYBREAK        128
+
+/*
+ * Max rx descriptors handled per queue in one mx6q_receive() pass before
+ * the Rx thread moves on to the next queue. 0 is no limit.
+ */
+#define DEFAULT_RX_BUDGET           64
+
+/* mx6q_receive() return values */
+#define MX6Q_RX_STALL               0   /* flow controlled, left masked */
+#define MX6Q_RX_DONE                1   /* ring drained, unmask */
+#define MX6Q_RX_MORE                2   /* budget used up, poll again */
+
 #ifdef MX6XSLX
 #define NUM_TX_QUEUES           3
 #define NUM_RX_QUEUES           3
@@ -164,9 +196,31 @@
 #define RX_DELAY_DEFAULT        240
 #define TX_FRAME_DEFAULT        255
 #define TX_DELAY_DEFAULT        240
+
+/*
+ * Adaptive interrupt coalescence. The combined rx+tx packet rate is
+ * sampled from a callout every MX6Q_IC_INTERVAL, so the level also
+ * decays while the link is idle, and the thresholds stepped between
+ * off (idle link, lowest latency), the moderate values below and the
+ * rx/tx_frame and rx/tx_delay values (bulk). Rates are in packets/sec,
+ * each level has separate up and down rates for hysteresis.
+ */
+#define MX6Q_IC_LEVEL_IDLE      0
+#define MX6Q_IC_LEVEL_MODERATE  1
+#define MX6Q_IC_LEVEL_BULK      2
+#define MX6Q_IC_INTERVAL        50          /* msec */
+#define MX6Q_IC_MODERATE_UP     10000
+#define MX6Q_IC_MODERATE_DOWN   5000
+#define MX6Q_IC_BULK_UP         50000
+#define MX6Q_IC_BULK_DOWN       30000
+#define RX_FRAME_MODERATE       16
+#define RX_DELAY_MODERATE       64
+#define TX_FRAME_MODERATE       64
+#define TX_DELAY_MODERATE       120
 #endif
 
 #define MPC_TIMEOUT     1000
+#define MX6Q_MDIO_FRAME_NS  25000   // most of a 64 clock MDIO frame at 2.4MHz MDC
 #define STOP_TIMEOUT	100
 
 /* ENET General Control and Status Registers */
@@ -384,6 +438,9 @@
 #define MX6Q_IPG_LENGTH_ADDR                    (0x01ac >> 2)
 #define MX6Q_TRUNC_FL_ADDR                      (0x01b0 >> 2)
 #define MX6Q_IPACCTXCONF_ADDR                   (0x01c0 >> 2)
+        #define TACC_PROCHK                     (1 << 4)
+        #define TACC_IPCHK                      (1 << 3)
+        #define TACC_SHIFT16                    (1 << 0)
 #define MX6Q_IPACCRXCONF_ADDR                   (0x01c4 >> 2)
 
 #define MX6Q_R_CLS_MATCH1           (0x01C8 >> 2)
@@ -398,6 +455,7 @@
 #define MX6Q_DMACFG2                (0x01DC >> 2)
     #define DMACFG_CALC_NOIPGEN     (1 << 17)
     #define DMACFG_DMA_CLASSEN      (1 << 16)
+    #define DMACFG_IDLE_SLOPE_MASK  0xffff
 
 #define MX6Q_R_DES_ACTIVE1          (0x01E0 >> 2)
 #define MX6Q_X_DES_ACTIVE1          (0x01E4 >> 2)
@@ -549,10 +607,119 @@ typedef struct {
 #define NEXT_RX(x)              ((x + 1) % mx6q->num_rx_descriptors)
 #define PREV_TX(x)              ((x == 0) ? mx6q->num_tx_descriptors - 1 : x - 1)
 
-#define MX6Q_TX_TIMESTAMP_BUF_SZ    16      // Amount of timestamps of transmitted packets
-#define MX6Q_RX_TIMESTAMP_BUF_SZ    64      // Amount of timestamps of received packets
+#define MX6Q_TX_TIMESTAMP_BUF_SZ    64      // Tx timestamps kept, power of 2
+#define MX6Q_RX_TIMESTAMP_BUF_SZ    256     // Rx timestamps kept per queue, power of 2
+#define MX6Q_TS_PROBE               4       // hash slots tried per timestamp
+#define MX6Q_PTP_ACTIVE_TICKS       30      // stats intervals without PTP ioctls before Rx timestamping stops
+
+#define MX6Q_MCF_SIZE               128     // software multicast filter slots, power of 2
+#define MX6Q_MCF_MAX                (MX6Q_MCF_SIZE / 2) // more groups than this accepts all
+
+#define MX6Q_AVTP_MIN_SLOTS         16      // avtp_ring shared memory slots, power of 2
+#define MX6Q_AVTP_MAX_SLOTS         4096
+
+#define MX6Q_PHY_POLL_FAST          250     // msec, just after a link change
+#define MX6Q_PHY_FAST_POLLS         8       // fast polls after a link change
+#define MX6Q_PHY_POLL_DOWN          500     // msec, while link is down
+#define MX6Q_PHY_POLL_SLOW          2000    // msec, link up and stable
+#define MX6Q_PHY_POLL_IRQ           5000    // msec, stable with a PHY interrupt
 
 #define MX6Q_SQI_SAMPLING_INTERVAL  1       // SQI sampling interval, in second
+#define MX6Q_STATS_INTERVAL         1000    // MIB harvest interval, in msec
+#define MX6Q_NHIST                  MX6Q_HIST_BUCKETS   // log2 histogram buckets, copied out by GET_HISTOGRAMS
+
+/*
+ * Software per-queue counters. Each one has a single writer (the Rx
+ * thread, or whoever holds if_snd_ex for Tx) so no lock is needed, but
+ * the writer bumps seq around each update so readers can take a
+ * consistent copy of the 64bit values. Cache line aligned so the Rx and
+ * Tx sides don't share lines.
+ */
+typedef struct {
+    volatile uint32_t   seq;
+    uint64_t            frames;
+    uint64_t            bytes;
+    uint64_t            multicast;
+    uint64_t            broadcast;
+    uint64_t            cycles;         // ClockCycles() in the path, profile only
+    uint64_t            allocs;         // mbufs/clusters allocated, profile only
+} __attribute__((aligned(64))) mx6q_qstats_t;
+
+/*
+ * Tx queue telemetry, only touched with if_snd_ex held. blk_start is
+ * non zero while the ring is full, which on the shaped AVB queues means
+ * frames are waiting on credit.
+ */
+typedef struct {
+    uint32_t            hwm;            // descriptors in use high water mark
+    uint32_t            drops;          // frames dropped, ring full
+    uint64_t            blocked_ns;     // total time the ring was full
+    uint64_t            blk_start;
+} mx6q_txq_tel_t;
+
+/* One joined group in the software multicast filter */
+typedef struct {
+    uint8_t             addr[ETHER_ADDR_LEN];
+    uint8_t             used;
+} mx6q_mcf_ent_t;
+
+/*
+ * PTP timestamp store. Timestamps go into a ring in arrival order and a
+ * hash of the (msg_type, sequence_id, port identity) key remembers where
+ * so ptpd lookups don't scan. Each store has a single writer, the Rx
+ * thread of its queue or whoever holds if_snd_ex for Tx. Readers check
+ * gen either side of their copy instead of taking a lock.
+ */
+typedef struct {
+    volatile uint32_t   gen;            // ring position + 1, 0 while being written
+    uint32_t            epoch;          // ts_epoch when added
+    ptp_extts_t         ts;
+} mx6q_ts_ent_t;
+
+typedef struct {
+    volatile uint32_t   head;           // timestamps ever added
+    uint32_t            tail;           // next one for GET_PTP_TIMESTAMPS
+    uint32_t            size;           // ring entries, power of 2
+    mx6q_ts_ent_t       *ring;
+    volatile uint32_t   *hash;          // size * 2 slots of ring position + 1
+} mx6q_ts_store_t;
+
+/*
+ * Count v in a log2 histogram, bucket n holds [2^n, 2^(n+1)) with 0 and
+ * 1 both in bucket 0. Profile only, so a lost update under a race with
+ * a clear doesn't matter.
+ */
+static inline void
+mx6q_hist_add (uint64_t *hist, uint64_t v)
+{
+    int                 b;
+
+    b = (v == 0) ? 0 : 63 - __builtin_clzll(v);
+    if (b >= MX6Q_NHIST) {
+        b = MX6Q_NHIST - 1;
+    }
+    hist[b]++;
+}
+
+/*
+ * Interface counters the Rx threads share. With rxq_threads the queues
+ * run in parallel, so a plain ++ can lose updates.
+ */
+#define MX6Q_RX_COUNT(_cnt)     __sync_fetch_and_add(&(_cnt), 1)
+
+static inline void
+mx6q_qstats_begin (mx6q_qstats_t *qs)
+{
+    qs->seq++;
+    __sync_synchronize();
+}
+
+static inline void
+mx6q_qstats_end (mx6q_qstats_t *qs)
+{
+    __sync_synchronize();
+    qs->seq++;
+}
 
 typedef enum {
   MX6_FLOW_AUTO = -1,
@@ -562,19 +729,77 @@ typedef enum {
   MX6_FLOW_RX
 } mx6_flow_t;
 
+/*
+ * Rx threads. Either one thread serves all the queues or, with the
+ * rxq_threads option, each queue gets its own thread and channel.
+ */
+typedef struct {
+    struct _nic_mx6q_ext *mx6q;
+    int                 tid;
+    int                 chid;
+    int                 coid;
+    uint32_t            queues;         // bitmask of the rx queues served
+    int                 cpu;            // runmask cpu, -1 for any
+} mx6q_rx_thread_t;
+
+/*
+ * Rx buffer pool, one per queue. The clusters stay with the driver with
+ * their physical address looked up once. A frame goes up to the stack as
+ * a header mbuf with the cluster attached as external storage, and comes
+ * back to the free list when the stack frees it, so refilling a
+ * descriptor needs no cluster allocation, pool_phys() or flush of the
+ * whole cluster. A retired pool frees its clusters as they come back.
+ */
+struct _mx6q_rxpool;
+
+typedef struct {
+    struct _mx6q_rxpool *pool;
+    struct mbuf         *m;             // the cluster, owned by the pool
+    caddr_t             buf;
+    off64_t             phys;
+    uint32_t            len;            // bytes lent to the stack, flushed before reuse
+} mx6q_rxbuf_t;
+
+typedef struct _mx6q_rxpool {
+    pthread_mutex_t     mutex;          // buffers come back from any stack thread
+    struct cache_ctrl   *cachectl;
+    uint32_t            nbufs;          // not yet freed
+    uint32_t            nfree;
+    int                 dead;
+    mx6q_rxbuf_t        **free;
+    mx6q_rxbuf_t        *bufs;
+} mx6q_rxpool_t;
+
+// Buffers per rx queue pool, the ring plus half as many again lent out
+#define MX6Q_RXP_BUFS(n)            ((n) + ((n) / 2))
+
 typedef struct _nic_mx6q_ext {
     struct device       dev;
     struct ethercom     ecom;
 
-    int                 tid;
-    int                 chid;
-    int                 coid;
+    mx6q_rx_thread_t    rx_thread[NUM_RX_QUEUES];
+    int                 num_rx_threads;
+    int                 rxq_threads;
+    int                 rxq_prio[NUM_RX_QUEUES];
+    int                 rxq_cpu[NUM_RX_QUEUES];
+#ifdef MX6XSLX
+    int                 rxq_pcp[8];     // vlan priority to rx queue
+    int                 rxq_steer;      // rxq_pcp given, classify from init
+#endif
     struct sigevent     isr_event[NUM_RX_QUEUES];
     struct _iopkt_inter inter;
     struct _iopkt_inter inter_queue;
     int                 iid_rx;
     int                 iid_tx;
     int                 iid_err;
+    // Optional PHY interrupt, phy_int is enable reg:enable value:status reg
+    int                 phy_irq;
+    int                 phy_int[3];
+    int                 iid_phy;
+    struct _iopkt_inter inter_phy;
+    int                 phy_fast;       // fast link polls left
+    volatile int        phy_kick;       // PHY interrupt seen, probe now
+    uint32_t            phy_events;
     int                 iid_1588;
     void               *sdhook;
 
@@ -587,11 +812,42 @@ typedef struct _nic_mx6q_ext {
     //
     // rx
     //
+    mx6q_qstats_t       rx_qstats[NUM_RX_QUEUES];
     int                 rxd_pkts;
     int                 num_rx_descriptors;
+    uint32_t            rx_copybreak;
+    uint32_t            rx_budget;
+    uint32_t            rx_buf_size;    // MRBR, bytes the MAC puts in each rx buffer
+    int                 profile;        // account cycles and allocs per queue
+    // Latency and ring histograms, profile only
+    uint64_t            ns_per_kcycle;  // ns per 1000 ClockCycles()
+    volatile uint64_t   rx_irq_stamp[NUM_RX_QUEUES];
+    uint64_t            *tx_stamp;      // per tx descriptor, when handed to us
+    uint64_t            h_rx_irq[NUM_RX_QUEUES][MX6Q_NHIST];
+    uint64_t            h_rx_ring[NUM_RX_QUEUES][MX6Q_NHIST];
+    uint64_t            h_tx_ring[NUM_TX_QUEUES][MX6Q_NHIST];
+    uint64_t            h_tx_done[NUM_TX_QUEUES][MX6Q_NHIST];
+    // Software exact match multicast filter, rebuilt by mx6q_set_multicast()
+    int                 mcf_enable;
+    int                 mcf_all;        // ranges or too many groups, accept all
+    volatile uint32_t   mcf_seq;        // odd while the table is being rebuilt
+    uint32_t            mcf_groups;
+    uint32_t            mcf_gaddr_shared; // groups sharing a GADDR bit with another
+    uint32_t            mcf_probe_collisions;
+    uint32_t            mcf_dropped[NUM_RX_QUEUES];
+    mx6q_mcf_ent_t      mcf_table[MX6Q_MCF_SIZE];
+    // 1722 frames from avtp_queue go to a shared memory ring, not io-pkt
+    uint32_t            avtp_slots;     // avtp_ring option, 0 is off
+    uint32_t            avtp_queue;
+    int                 avtp_poll;      // busy-poll avtp_queue instead of interrupts
+    char                avtp_name[32];
+    void               *avtp_ring;      // mx6q_avtp_ring_hdr_t then the slots
+    size_t              avtp_size;
     mpc_bd_t           *rx_bd;
     int                 rx_cidx[NUM_RX_QUEUES];
-    struct mbuf       **rx_pkts;
+    mx6q_rxbuf_t      **rx_bufs;
+    mx6q_rxpool_t      *rxp[NUM_RX_QUEUES];
+    uint32_t            rx_pool_copies[NUM_RX_QUEUES];
     pthread_mutex_t     rx_mutex;
     int                 rx_running;
     int                 rx_full;
@@ -626,6 +882,15 @@ typedef struct _nic_mx6q_ext {
     uint32_t            rx_delay;
     uint32_t            tx_frame;
     uint32_t            tx_delay;
+    int                 ic_adaptive;
+    uint32_t            ic_level;
+    uint32_t            ic_rxic;        // currently programmed RXIC0
+    uint32_t            ic_txic;        // currently programmed TXICn
+    uint64_t            ic_stamp;
+    uint64_t            ic_pkts;
+    uint32_t            ic_rate;
+    uint32_t            ic_changes;
+    struct callout      ic_callout;
 #endif
 
     //
@@ -659,10 +924,34 @@ typedef struct _nic_mx6q_ext {
     volatile bool	tx_full;
     struct mbuf       **tx_pkts;
     int                 tx_reaped;      // flag for periodic descr ring cleaning
+    uint32_t            tx_defrag;      // whole frames copied by mx6q_defrag()
+    uint32_t            tx_frag_copies; // single fragments copied for alignment
+    mx6q_qstats_t       tx_qstats[NUM_TX_QUEUES];
+    mx6q_txq_tel_t      tx_tel[NUM_TX_QUEUES];
+    struct callout      stats_callout;
+    // sim_mac, a thread stands in for the DMA and loops Tx back to Rx
+    int                 sim_mac;
+    int                 sim_tid;
+    int                 sim_chid;
+    int                 sim_coid;
+    volatile uint32_t   sim_kicked;     // pulse outstanding
+    pthread_mutex_t     sim_mutex;      // held while the rings are serviced
+    uint32_t            sim_tx_idx[NUM_TX_QUEUES]; // next for the "DMA"
+    uint32_t            sim_rx_idx[NUM_RX_QUEUES];
+    uint32_t            sim_dropped;    // Rx ring full
     // Real Time Clock value (sec.)
     volatile uint32_t   rtc;
     volatile uint32_t	rtc_half; /* Half rollover flag */
     intrspin_t		rtc_spinner;
+    // PTP timestamps, ts_epoch bumps when the clock is set
+    volatile uint32_t   ts_epoch;
+    volatile uint32_t   ptp_active;     // non zero while a PTP client is using us
+    mx6q_ts_store_t     rx_ts[NUM_RX_QUEUES];
+    mx6q_ts_store_t     tx_ts;
+    mx6q_ts_ent_t       rx_ts_ring[NUM_RX_QUEUES][MX6Q_RX_TIMESTAMP_BUF_SZ];
+    uint32_t            rx_ts_hash[NUM_RX_QUEUES][MX6Q_RX_TIMESTAMP_BUF_SZ * 2];
+    mx6q_ts_ent_t       tx_ts_ring[MX6Q_TX_TIMESTAMP_BUF_SZ];
+    uint32_t            tx_ts_hash[MX6Q_TX_TIMESTAMP_BUF_SZ * 2];
     //sqi
     uint8_t             sqi;
     struct callout      sqi_callout;
@@ -676,14 +965,45 @@ int mx6q_enable_interrupt(void *arg);
 int mx6q_process_interrupt(void *arg, struct nw_work_thread *);
 int mx6q_enable_queue(void *arg);
 int mx6q_process_queue(void *arg, struct nw_work_thread *);
+#ifdef MX6XSLX
+void mx6q_ic_values(mx6q_dev_t *, uint32_t, uint32_t *, uint32_t *);
+void mx6q_ic_program(mx6q_dev_t *, uint32_t);
+void mx6q_ic_adapt(mx6q_dev_t *);
+void mx6q_ic_start(mx6q_dev_t *);
+void mx6q_ic_callout(void *);
+#endif
+
+// avtp.c
+void mx6q_avtp_init(mx6q_dev_t *);
+void mx6q_avtp_fini(mx6q_dev_t *);
+void mx6q_avtp_put(mx6q_dev_t *, struct mbuf *, mpc_bd_t *);
+int mx6q_avtp_ioctl(mx6q_dev_t *, struct ifdrv *);
+
+// rxpool.c
+mx6q_rxpool_t *mx6q_rxp_create(mx6q_dev_t *, uint32_t);
+void mx6q_rxp_retire(mx6q_rxpool_t *);
+mx6q_rxbuf_t *mx6q_rxp_get(mx6q_rxpool_t *);
+void mx6q_rxp_put(mx6q_rxbuf_t *);
+struct mbuf *mx6q_rxp_lend(mx6q_rxbuf_t *, uint32_t, int,
+                           struct nw_work_thread *);
+
+// sim.c
+int mx6q_sim_init(mx6q_dev_t *);
+void mx6q_sim_fini(mx6q_dev_t *);
+void mx6q_sim_start(mx6q_dev_t *);
+void mx6q_sim_stop(mx6q_dev_t *);
+void mx6q_sim_sync(mx6q_dev_t *);
+void mx6q_sim_kick(mx6q_dev_t *);
 
 // multicast.c
 void mx6q_set_multicast(mx6q_dev_t *);
+int mx6q_mcf_match(mx6q_dev_t *, const uint8_t *);
 
 // detect.c
 void dump_mbuf(struct mbuf *, uint32_t);
 int mx6q_detect(void *dll_hdl, struct _iopkt_self *iopkt, char *options);
 void mx6q_speeduplex(mx6q_dev_t *);
+int mx6q_ring_resize(mx6q_dev_t *, uint32_t, uint32_t);
 
 /* devctl.c */
 int mx6q_ioctl(struct ifnet *, unsigned long, caddr_t);
@@ -692,19 +1012,39 @@ int mx6q_mii_read_ioctl(mx6q_dev_t *, struct ifdrv *);
 int mx6q_mii_write_ioctl(mx6q_dev_t *, struct ifdrv *);
 int mx6q_br_lowpower_enable_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd);
 int mx6q_br_lowpower_disable_ioctl(mx6q_dev_t *mx6q, struct ifdrv *ifd);
+int mx6q_drv_stats_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_queue_stats_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_tx_telemetry_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_hist_get_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_hist_clear_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_ring_get_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_ring_set_ioctl(mx6q_dev_t *, struct ifdrv *);
+#ifdef MX6XSLX
+int mx6q_ic_get_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_ic_set_ioctl(mx6q_dev_t *, struct ifdrv *);
+#endif
 
 // transmit.c
 void mx6q_start(struct ifnet *);
 void mx6q_transmit_complete(mx6q_dev_t *, uint8_t);
 int mx6q_set_tx_bw (mx6q_dev_t *mx6q, struct ifdrv *ifd);
+#ifdef MX6XSLX
+uint32_t mx6q_get_idleslope(mx6q_dev_t *, int);
+#endif
+uint64_t mx6q_tx_now(void);
 int mx6q_output (struct ifnet *, struct mbuf *,
          struct sockaddr *, struct rtentry *);
 // receive.c
 int mx6q_receive(mx6q_dev_t *, struct nw_work_thread *, uint8_t);
+#ifdef MX6XSLX
+void mx6q_set_rx_class(mx6q_dev_t *);
+#endif
 
 // mii.c
 void mx6q_MDI_MonitorPhy(void *);
 int mx6q_init_phy(mx6q_dev_t *);
+int mx6q_phy_irq_init(mx6q_dev_t *);
+void mx6q_phy_irq_fini(mx6q_dev_t *);
 void mx6q_fini_phy(mx6q_dev_t *);
 int mx6_is_br_phy (mx6q_dev_t *);
 uint16_t mx6q_mii_read (void *handle, uint8_t phy_add, uint8_t reg_add);
@@ -721,6 +1061,9 @@ int mx6_calculate_sqi(unsigned val);
 // stats.c
 void mx6q_update_stats(mx6q_dev_t *);
 void mx6q_clear_stats(mx6q_dev_t *);
+void mx6q_stats_callout(void *);
+void mx6q_qstats_snap(mx6q_qstats_t *, mx6q_qstats_t *);
+void mx6q_snapshot_stats(mx6q_dev_t *, nic_stats_t *);
 
 // bsd_media.c
 void bsd_mii_initmedia(mx6q_dev_t *);
@@ -728,13 +1071,16 @@ int bsd_mii_mediachange(struct ifnet *ifp);
 void bsd_mii_finimedia(mx6q_dev_t *);
 
 // ptp.c
+void mx6q_ptp_init(mx6q_dev_t *);
 void mx6q_ptp_start(mx6q_dev_t *);
 int mx6q_ptp_is_eventmsg(struct mbuf *, ptpv2hdr_t **);
-void mx6q_ptp_add_rx_timestamp(mx6q_dev_t *, ptpv2hdr_t *, mpc_bd_t *);
+void mx6q_ptp_add_rx_timestamp(mx6q_dev_t *, ptpv2hdr_t *, mpc_bd_t *, uint8_t);
 void mx6q_ptp_add_tx_timestamp(mx6q_dev_t *, ptpv2hdr_t *, mpc_bd_t *);
+void mx6q_ptp_bd_time(mx6q_dev_t *, mpc_bd_t *, ptp_time_t *);
 int mx6q_ptp_get_rx_timestamp(mx6q_dev_t *, ptp_extts_t *);
 int mx6q_ptp_get_tx_timestamp(mx6q_dev_t *, ptp_extts_t *);
 int mx6q_ptp_ioctl(mx6q_dev_t *, struct ifdrv *);
+int mx6q_ptp_batch_ioctl(mx6q_dev_t *, struct ifdrv *);
 void mx6q_ptp_get_cnt(mx6q_dev_t *, ptp_time_t *);
 void mx6q_ptp_set_cnt(mx6q_dev_t *, ptp_time_t);
 void mx6q_ptp_set_compensation(mx6q_dev_t *, ptp_comp_t);
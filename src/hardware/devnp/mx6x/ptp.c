@@ -23,11 +23,8 @@
 #include <netinet/ip.h>
 #include <netinet/udp.h>
 #include <netinet/in.h>
-
-ptp_extts_t	tx_ts[MX6Q_TX_TIMESTAMP_BUF_SZ];
-uint32_t	tx_ts_cnt;
-ptp_extts_t	rx_ts[MX6Q_RX_TIMESTAMP_BUF_SZ];
-uint32_t	rx_ts_cnt;
+#include <net/if_vlanvar.h>
+#include <hw/imx6x_devnp_ioctl.h>
 
 uint32_t mx6q_clock_period; /* in nanoseconds */
 uint32_t mx6q_clock_freq;   /* in Hz */
@@ -159,7 +156,8 @@ void mx6q_ptp_start (mx6q_dev_t *mx6q)
  */
 int mx6q_ptp_is_eventmsg (struct mbuf *m, ptpv2hdr_t **ph)
 {
-    int				remain, pktlen;
+    int				remain, pktlen, hlen;
+    uint16_t			type;
     struct ether_header		*eh;
     struct ip			*iph;
     struct udphdr		*udph;
@@ -175,14 +173,28 @@ int mx6q_ptp_is_eventmsg (struct mbuf *m, ptpv2hdr_t **ph)
     }
 
     eh = (struct ether_header *)m->m_data;
+    type = ntohs(eh->ether_type);
+    hlen = sizeof(struct ether_header);
+
+    /* Look through a single VLAN tag */
+    if (type == ETHERTYPE_VLAN) {
+	if (m->m_len < sizeof(struct ether_vlan_header)) {
+	    return 0;
+	}
+	type = ntohs(((struct ether_vlan_header *)eh)->evl_proto);
+	hlen += ETHER_VLAN_ENCAP_LEN;
+	if (m->m_pkthdr.len < hlen + sizeof(ptpv2hdr_t)) {
+	    return 0;
+	}
+    }
 
-    switch(ntohs(eh->ether_type)) {
+    switch(type) {
 
     case ETHERTYPE_PTP:
         /* This is a native ethernet frame
          * defined for IEEE1588v2
          */
-	remain = sizeof(struct ether_header);
+	remain = hlen;
 	while (remain >= m->m_len) {
 	    remain -= m->m_len;
 	    m = m->m_next;
@@ -199,7 +211,7 @@ int mx6q_ptp_is_eventmsg (struct mbuf *m, ptpv2hdr_t **ph)
     case ETHERTYPE_IP:
 	pktlen = m->m_pkthdr.len;
 
-	remain = sizeof(struct ether_header);
+	remain = hlen;
 	while (remain >= m->m_len) {
 	    remain -= m->m_len;
 	    m = m->m_next;
@@ -210,7 +222,7 @@ int mx6q_ptp_is_eventmsg (struct mbuf *m, ptpv2hdr_t **ph)
 	    return 0;
 	}
 
-	if (pktlen < sizeof(struct ether_header) + (iph->ip_hl << 2) +
+	if (pktlen < hlen + (iph->ip_hl << 2) +
 	    sizeof(struct udphdr) + sizeof (ptpv2hdr_t)) {
 	    return 0;
 	}
@@ -241,64 +253,240 @@ int mx6q_ptp_is_eventmsg (struct mbuf *m, ptpv2hdr_t **ph)
 	break;
 
     default:
-        // VLAN & IPv6 protocols are not supported
+        // IPv6 and stacked VLANs are not supported
 	break;
     }
     return 0;
 }
 
 /*
- * mx6q_ptp_add_rx_timestamp()
+ * mx6q_ptp_init()
  *
- * Description: This function inserts RX timestamp into
- * the corresponding buffer (depends on the message type).
- * If the corresponding buffer already full, the timestamp
- * will be inserted into the start of the buffer
+ * Description: Hooks the timestamp stores up to their storage.
  *
  * Returns: none
  *
  */
-void mx6q_ptp_add_rx_timestamp (mx6q_dev_t *mx6q, ptpv2hdr_t *ph, mpc_bd_t *bd)
+void mx6q_ptp_init (mx6q_dev_t *mx6q)
 {
-    if ((ph == NULL) || (bd == NULL) ||
-        ((ph->version & 0x0f) != 0x2) ) {
-        /* Only PTPv2 currently supported */
-        return;
+    mx6q_ts_store_t	*st;
+    int			i;
+
+    for (i = 0; i < NUM_RX_QUEUES; i++) {
+	st = &mx6q->rx_ts[i];
+	memset(st, 0, sizeof(*st));
+	st->size = MX6Q_RX_TIMESTAMP_BUF_SZ;
+	st->ring = mx6q->rx_ts_ring[i];
+	st->hash = mx6q->rx_ts_hash[i];
     }
+    st = &mx6q->tx_ts;
+    memset(st, 0, sizeof(*st));
+    st->size = MX6Q_TX_TIMESTAMP_BUF_SZ;
+    st->ring = mx6q->tx_ts_ring;
+    st->hash = mx6q->tx_ts_hash;
+}
 
-    /* Add the details */
-    rx_ts[rx_ts_cnt].msg_type = ph->messageId & 0x0f;
-    rx_ts[rx_ts_cnt].sequence_id = ntohs(ph->sequenceId);
-    memcpy(rx_ts[rx_ts_cnt].clock_identity, ph->clockIdentity,
-	   sizeof(rx_ts[rx_ts_cnt].clock_identity));
-    rx_ts[rx_ts_cnt].sport_id = ntohs(ph->sportId);
-    rx_ts[rx_ts_cnt].ts.nsec = bd->timestamp;
+/*
+ * First hash slot for a timestamp. The port identity picks the base and
+ * the sequence id and message type are added on, so consecutive messages
+ * of one stream land in consecutive slots.
+ */
+static uint32_t mx6q_ts_slot (mx6q_ts_store_t *st, ptp_extts_t *ts)
+{
+    uint32_t	h = 2166136261u;
+    int		i;
+
+    for (i = 0; i < sizeof(ts->clock_identity); i++) {
+	h = (h ^ ts->clock_identity[i]) * 16777619u;
+    }
+    h = (h ^ ts->sport_id) * 16777619u;
+    h += ((uint32_t)ts->sequence_id << 4) | (ts->msg_type & 0x0f);
+
+    return h & ((st->size * 2) - 1);
+}
+
+static int mx6q_ts_match (ptp_extts_t *a, ptp_extts_t *b)
+{
+    return ((a->msg_type == b->msg_type) &&
+	    (a->sequence_id == b->sequence_id) &&
+	    (a->sport_id == b->sport_id) &&
+	    !memcmp(a->clock_identity, b->clock_identity,
+		    sizeof(a->clock_identity)));
+}
+
+/*
+ * Copy out the entry at ring position pos. Fails if it has been
+ * overwritten, or is being overwritten, by the writer.
+ */
+static int mx6q_ts_read (mx6q_ts_store_t *st, uint32_t pos, mx6q_ts_ent_t *ent)
+{
+    mx6q_ts_ent_t	*e = &st->ring[pos & (st->size - 1)];
+
+    if (e->gen != pos + 1) {
+	return 0;
+    }
+    __sync_synchronize();
+    ent->epoch = e->epoch;
+    ent->ts = e->ts;
+    __sync_synchronize();
+    return (e->gen == pos + 1);
+}
+
+/*
+ * Is the ring position in a hash slot still in the ring?
+ */
+static inline int mx6q_ts_live (mx6q_ts_store_t *st, uint32_t slot_val)
+{
+    return ((slot_val != 0) && ((st->head - (slot_val - 1)) <= st->size));
+}
+
+/*
+ * mx6q_ptp_bd_time()
+ *
+ * Description: Converts the 1588 nanoseconds in a completed descriptor
+ * into a full time using the seconds kept in software.
+ *
+ * Returns: none
+ *
+ */
+void mx6q_ptp_bd_time (mx6q_dev_t *mx6q, mpc_bd_t *bd, ptp_time_t *t)
+{
+    t->nsec = bd->timestamp;
 
     InterruptLock(&mx6q->rtc_spinner);
-    rx_ts[rx_ts_cnt].ts.sec = mx6q->rtc;
+    t->sec = mx6q->rtc;
     /*
      * Handle rollovers of the timer and async updates of the
      * seconds stored in software.
      */
-    if ((rx_ts[rx_ts_cnt].ts.nsec > 750000000) &&
+    if ((t->nsec > 750000000) &&
 	(mx6q->rtc_half == 0)) {
 	/*
 	 * Captured from hardware before the second but by the time
 	 * we read the software seconds then it had incremented.
 	 */
-	rx_ts[rx_ts_cnt].ts.sec--;
-    } else if ((rx_ts[rx_ts_cnt].ts.nsec < 250000000) &&
+	t->sec--;
+    } else if ((t->nsec < 250000000) &&
 	       (mx6q->rtc_half == 1)) {
 	/*
 	 * Captured from hardware after the second but the software
 	 * seconds have not incremented yet.
 	 */
-	rx_ts[rx_ts_cnt].ts.sec++;
+	t->sec++;
     }
     InterruptUnlock(&mx6q->rtc_spinner);
+}
+
+/*
+ * mx6q_ts_add()
+ *
+ * Description: Stamps the seconds on a captured timestamp and adds it to
+ * the store, overwriting the oldest one if the store is full. Only ever
+ * called by the single writer of the store.
+ *
+ * Returns: none
+ *
+ */
+static void mx6q_ts_add (mx6q_dev_t *mx6q, mx6q_ts_store_t *st,
+			 ptpv2hdr_t *ph, mpc_bd_t *bd)
+{
+    mx6q_ts_ent_t	*e;
+    uint32_t		pos, base, slot, victim, i;
+
+    pos = st->head;
+    e = &st->ring[pos & (st->size - 1)];
+
+    /* Mark it invalid while it is rewritten */
+    e->gen = 0;
+    __sync_synchronize();
+
+    /* Add the details */
+    e->epoch = mx6q->ts_epoch;
+    e->ts.msg_type = ph->messageId & 0x0f;
+    e->ts.sequence_id = ntohs(ph->sequenceId);
+    memcpy(e->ts.clock_identity, ph->clockIdentity,
+	   sizeof(e->ts.clock_identity));
+    e->ts.sport_id = ntohs(ph->sportId);
+    mx6q_ptp_bd_time(mx6q, bd, &e->ts.ts);
+
+    __sync_synchronize();
+    e->gen = pos + 1;
+
+    /*
+     * Index it. Take the first free or stale slot in the probe window,
+     * otherwise push out the oldest entry in it.
+     */
+    base = mx6q_ts_slot(st, &e->ts);
+    victim = base;
+    for (i = 0; i < MX6Q_TS_PROBE; i++) {
+	slot = (base + i) & ((st->size * 2) - 1);
+	if (!mx6q_ts_live(st, st->hash[slot])) {
+	    victim = slot;
+	    break;
+	}
+	if (st->hash[slot] < st->hash[victim]) {
+	    victim = slot;
+	}
+    }
+    st->hash[victim] = pos + 1;
+
+    __sync_synchronize();
+    st->head = pos + 1;
+}
+
+/*
+ * mx6q_ts_lookup()
+ *
+ * Description: Finds the timestamp matching the msg_type, sequence_id and
+ * port identity in ts, probing at most MX6Q_TS_PROBE hash slots.
+ *
+ * Returns: Non zero value if the timestamp has been found.
+ *
+ */
+static int mx6q_ts_lookup (mx6q_dev_t *mx6q, mx6q_ts_store_t *st,
+			   ptp_extts_t *ts)
+{
+    mx6q_ts_ent_t	ent;
+    uint32_t		base, val, i;
+
+    base = mx6q_ts_slot(st, ts);
+    for (i = 0; i < MX6Q_TS_PROBE; i++) {
+	val = st->hash[(base + i) & ((st->size * 2) - 1)];
+	if (!mx6q_ts_live(st, val)) {
+	    continue;
+	}
+	if (!mx6q_ts_read(st, val - 1, &ent)) {
+	    continue;
+	}
+	if ((ent.epoch == mx6q->ts_epoch) && mx6q_ts_match(ts, &ent.ts)) {
+	    ts->ts.nsec = ent.ts.ts.nsec;
+	    ts->ts.sec = ent.ts.ts.sec;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/*
+ * mx6q_ptp_add_rx_timestamp()
+ *
+ * Description: This function inserts RX timestamp into the store
+ * of the queue it was received on. If the store is full the oldest
+ * timestamp is overwritten.
+ *
+ * Returns: none
+ *
+ */
+void mx6q_ptp_add_rx_timestamp (mx6q_dev_t *mx6q, ptpv2hdr_t *ph,
+				mpc_bd_t *bd, uint8_t queue)
+{
+    if ((ph == NULL) || (bd == NULL) ||
+        ((ph->version & 0x0f) != 0x2) ) {
+        /* Only PTPv2 currently supported */
+        return;
+    }
 
-    /* Advance the counter including wrapping */
-    rx_ts_cnt = (rx_ts_cnt + 1) % MX6Q_RX_TIMESTAMP_BUF_SZ;
+    mx6q_ts_add(mx6q, &mx6q->rx_ts[queue], ph, bd);
 
     if (mx6q->cfg.verbose > 4) {
         log(LOG_ERR, "RX 1588 message:");
@@ -312,10 +500,9 @@ void mx6q_ptp_add_rx_timestamp (mx6q_dev_t *mx6q, ptpv2hdr_t *ph, mpc_bd_t *bd)
 /*
  * mx6q_ptp_add_tx_timestamp()
  *
- * Description: This function inserts TX timestamp into
- * the corresponding buffer (depends on the message type).
- * If the corresponding buffer already full, the timestamp
- * will be inserted into the start of the buffer
+ * Description: This function inserts TX timestamp into the store.
+ * If the store is full the oldest timestamp is overwritten.
+ * Called with if_snd_ex held.
  *
  * Returns: none
  *
@@ -328,39 +515,7 @@ void mx6q_ptp_add_tx_timestamp (mx6q_dev_t *mx6q, ptpv2hdr_t *ph, mpc_bd_t *bd)
         return;
     }
 
-    /* Add the details */
-    tx_ts[tx_ts_cnt].msg_type = ph->messageId & 0x0f;
-    tx_ts[tx_ts_cnt].sequence_id = ntohs(ph->sequenceId);
-    memcpy(tx_ts[tx_ts_cnt].clock_identity, ph->clockIdentity,
-	   sizeof(tx_ts[tx_ts_cnt].clock_identity));
-    tx_ts[tx_ts_cnt].sport_id = ntohs(ph->sportId);
-    tx_ts[tx_ts_cnt].ts.nsec = bd->timestamp;
-
-    InterruptLock(&mx6q->rtc_spinner);
-    tx_ts[tx_ts_cnt].ts.sec = mx6q->rtc;
-    /*
-     * Handle rollovers of the timer and async updates of the
-     * seconds stored in software.
-     */
-    if ((tx_ts[tx_ts_cnt].ts.nsec > 750000000) &&
-	(mx6q->rtc_half == 0)) {
-	/*
-	 * Captured from hardware before the second but by the time
-	 * we read the software seconds then it had incremented.
-	 */
-	tx_ts[tx_ts_cnt].ts.sec--;
-    } else if ((tx_ts[tx_ts_cnt].ts.nsec < 250000000) &&
-	       (mx6q->rtc_half == 1)) {
-	/*
-	 * Captured from hardware after the second but the software
-	 * seconds have not incremented yet.
-	 */
-	tx_ts[tx_ts_cnt].ts.sec++;
-    }
-    InterruptUnlock(&mx6q->rtc_spinner);
-
-    /* Advance the counter including wrapping */
-    tx_ts_cnt = (tx_ts_cnt + 1) % MX6Q_TX_TIMESTAMP_BUF_SZ;
+    mx6q_ts_add(mx6q, &mx6q->tx_ts, ph, bd);
 
     if (mx6q->cfg.verbose > 4) {
         log(LOG_ERR, "TX 1588 message:");
@@ -374,7 +529,7 @@ void mx6q_ptp_add_tx_timestamp (mx6q_dev_t *mx6q, ptpv2hdr_t *ph, mpc_bd_t *bd)
 /*
  * mx6q_ptp_get_rx_timestamp()
  *
- * Description: This function searches a timestamp in the corresponding RX buffer,
+ * Description: This function looks up a timestamp in the RX stores,
  * according to message type, sequence id and the source port id.
  *
  * Returns: Non zero value if the timestamp has been found. Timestamp will
@@ -389,15 +544,9 @@ int mx6q_ptp_get_rx_timestamp (mx6q_dev_t *mx6q, ptp_extts_t *ts)
 	return 0;
     }
 
-    for (i = 0; i < MX6Q_RX_TIMESTAMP_BUF_SZ; i++) {
-	if ((ts->msg_type == rx_ts[i].msg_type) &&
-	    (ts->sequence_id == rx_ts[i].sequence_id) &&
-	    (ts->sport_id == rx_ts[i].sport_id) &&
-	    !memcmp(ts->clock_identity, rx_ts[i].clock_identity,
-		    sizeof(ts->clock_identity))) {
-	  ts->ts.nsec =  rx_ts[i].ts.nsec;
-	  ts->ts.sec =  rx_ts[i].ts.sec;
-	  return 1;
+    for (i = 0; i < NUM_RX_QUEUES; i++) {
+	if (mx6q_ts_lookup(mx6q, &mx6q->rx_ts[i], ts)) {
+	    return 1;
 	}
     }
     return 0;
@@ -407,7 +556,7 @@ int mx6q_ptp_get_rx_timestamp (mx6q_dev_t *mx6q, ptp_extts_t *ts)
 /*
  * mx6q_ptp_get_tx_timestamp()
  *
- * Description: This function searches a timestamp in the corresponding TX buffer,
+ * Description: This function looks up a timestamp in the TX store,
  * according to message type, sequence id and the source port id.
  *
  * Returns: Non zero value if the timestamp has been found. Timestamp will
@@ -423,6 +572,11 @@ int mx6q_ptp_get_tx_timestamp (mx6q_dev_t *mx6q, ptp_extts_t *ts)
 	return 0;
     }
 
+    /* Only reap if we don't already have it */
+    if (mx6q_ts_lookup(mx6q, &mx6q->tx_ts, ts)) {
+	return 1;
+    }
+
     /* Reap the descriptors to pick up any new timestamps */
     ifp = &mx6q->ecom.ec_if;
     NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
@@ -431,18 +585,96 @@ int mx6q_ptp_get_tx_timestamp (mx6q_dev_t *mx6q, ptp_extts_t *ts)
     }
     NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
 
-    for (i = 0; i < MX6Q_TX_TIMESTAMP_BUF_SZ; i++) {
-	if ((ts->msg_type == tx_ts[i].msg_type) &&
-	    (ts->sequence_id == tx_ts[i].sequence_id) &&
-	    (ts->sport_id == tx_ts[i].sport_id) &&
-	    !memcmp(ts->clock_identity, tx_ts[i].clock_identity,
-		    sizeof(ts->clock_identity))) {
-	  ts->ts.nsec =  tx_ts[i].ts.nsec;
-	  ts->ts.sec =  tx_ts[i].ts.sec;
-	  return 1;
+    return mx6q_ts_lookup(mx6q, &mx6q->tx_ts, ts);
+}
+
+/*
+ * Move timestamps added since the last call into the batch, up to
+ * MX6Q_PTP_BATCH_MAX in total.
+ */
+static void mx6q_ts_drain (mx6q_dev_t *mx6q, mx6q_ts_store_t *st,
+			   uint8_t dir, mx6q_ptp_ts_batch_t *batch)
+{
+    mx6q_ts_ent_t	ent;
+    mx6q_ptp_ts_t	*out;
+    uint32_t		head;
+
+    head = st->head;
+    __sync_synchronize();
+    if ((head - st->tail) > st->size) {
+	batch->lost += (head - st->tail) - st->size;
+	st->tail = head - st->size;
+    }
+    while (st->tail != head) {
+	if (batch->count == MX6Q_PTP_BATCH_MAX) {
+	    batch->more = 1;
+	    return;
+	}
+	if (!mx6q_ts_read(st, st->tail, &ent)) {
+	    /* Overwritten while we were looking */
+	    batch->lost++;
+	} else if (ent.epoch == mx6q->ts_epoch) {
+	    out = &batch->ts[batch->count++];
+	    out->dir = dir;
+	    out->msg_type = ent.ts.msg_type;
+	    out->sequence_id = ent.ts.sequence_id;
+	    memcpy(out->clock_identity, ent.ts.clock_identity,
+		   sizeof(out->clock_identity));
+	    out->sport_id = ent.ts.sport_id;
+	    out->sec = ent.ts.ts.sec;
+	    out->nsec = ent.ts.ts.nsec;
 	}
+	st->tail++;
     }
-    return 0;
+}
+
+/*
+ * mx6q_ptp_batch_ioctl()
+ *
+ * Description: Returns all Rx and Tx timestamps captured since the last
+ * call in one go, so a busy ptpd doesn't need a query per message.
+ *
+ * Returns: Non zero value if the error has been occured.
+ *
+ */
+int mx6q_ptp_batch_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
+{
+    struct ifnet		*ifp = &mx6q->ecom.ec_if;
+    mx6q_ptp_ts_batch_t		*batch;
+    int				i, err;
+
+    if (ifd->ifd_len != sizeof(*batch)) {
+	return EINVAL;
+    }
+    mx6q->ptp_active = MX6Q_PTP_ACTIVE_TICKS;
+
+    batch = malloc(sizeof(*batch), M_DEVBUF, M_NOWAIT);
+    if (batch == NULL) {
+	return ENOMEM;
+    }
+    memset(batch, 0, sizeof(*batch));
+
+    /* Reap the descriptors to pick up any new Tx timestamps */
+    NW_SIGLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+    for (i = 0; i < NUM_TX_QUEUES; i++) {
+	mx6q_transmit_complete(mx6q, i);
+    }
+    NW_SIGUNLOCK(&ifp->if_snd_ex, mx6q->iopkt);
+
+    mx6q_ts_drain(mx6q, &mx6q->tx_ts, MX6Q_PTP_TS_TX, batch);
+    for (i = 0; i < NUM_RX_QUEUES; i++) {
+	mx6q_ts_drain(mx6q, &mx6q->rx_ts[i], MX6Q_PTP_TS_RX, batch);
+    }
+
+    if (ISSTACK) {
+	err = copyout(batch, (((uint8_t *)ifd) + sizeof(*ifd)),
+		      sizeof(*batch));
+    } else {
+	memcpy((((uint8_t *)ifd) + sizeof(*ifd)), batch, sizeof(*batch));
+	err = EOK;
+    }
+    free(batch, M_DEVBUF);
+    return err;
 }
 
 /*
@@ -627,6 +859,7 @@ int mx6q_ptp_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 
         case PTP_GET_RX_TIMESTAMP:
         case PTP_GET_TX_TIMESTAMP:
+	    mx6q->ptp_active = MX6Q_PTP_ACTIVE_TICKS;
 	    if (ifd->ifd_len != sizeof(ts)) {
 		return EINVAL;
 	    }
@@ -659,6 +892,7 @@ int mx6q_ptp_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	    break;
 
         case PTP_GET_TIME:
+	    mx6q->ptp_active = MX6Q_PTP_ACTIVE_TICKS;
 	    if (ifd->ifd_len != sizeof(time)) {
 		return EINVAL;
 	    }
@@ -673,6 +907,7 @@ int mx6q_ptp_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	    break;
 
         case PTP_SET_TIME:
+	    mx6q->ptp_active = MX6Q_PTP_ACTIVE_TICKS;
 	    if (ifd->ifd_len != sizeof(time)) {
 		return EINVAL;
 	    }
@@ -686,12 +921,12 @@ int mx6q_ptp_ioctl (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	    }
 	    mx6q_ptp_set_cnt(mx6q, time);
 	    /* Clock has changed so all old ts are invalid */
-	    memset(tx_ts, 0, sizeof(tx_ts));
-	    memset(rx_ts, 0, sizeof(rx_ts));
+	    mx6q->ts_epoch++;
 	    return EOK;
 	    break;
 
         case PTP_SET_COMPENSATION:
+	    mx6q->ptp_active = MX6Q_PTP_ACTIVE_TICKS;
 	    if (ifd->ifd_len != sizeof(comp)) {
 		return EINVAL;
 	    }
@@ -32,6 +32,17 @@
 #define WRITE_BRCM_MII	0x1002
 #define ENABLE_BRCM_PHY_LOWPOWER		0x1003
 #define DISABLE_BRCM_PHY_LOWPOWER		0x1004
+#define GET_IC_STATE	0x1005
+#define SET_IC_ADAPTIVE	0x1006
+#define GET_DRV_STATS	0x1007
+#define GET_QUEUE_STATS	0x1008
+#define GET_TX_TELEMETRY	0x1009
+#define GET_PTP_TIMESTAMPS	0x100A
+#define GET_HISTOGRAMS	0x100B
+#define CLEAR_HISTOGRAMS	0x100C
+#define GET_AVTP_RING	0x100D
+#define GET_RING_SIZE	0x100E
+#define SET_RING_SIZE	0x100F
 
 typedef struct {
     uint8_t	sqi;		/* sqi  */
@@ -42,6 +53,154 @@ typedef struct {
 	uint16_t	data;			/* for read, data is the value read from register, for write, data is the value write to the register*/
 } mx6q_mii_request_t;
 
+/* Interrupt coalescence state, SoloX only */
+typedef struct {
+	uint32_t	adaptive;		/* 1 if adaptive mode is on, set with SET_IC_ADAPTIVE */
+	uint32_t	level;			/* 0 idle, 1 moderate, 2 bulk */
+	uint32_t	rx_frame;		/* currently programmed rx ICFT, 0 if off */
+	uint32_t	rx_delay;		/* currently programmed rx ICTT, 0 if off */
+	uint32_t	tx_frame;		/* currently programmed tx ICFT, 0 if off */
+	uint32_t	tx_delay;		/* currently programmed tx ICTT, 0 if off */
+	uint32_t	pkt_rate;		/* last sampled rx+tx packets/sec */
+	uint32_t	changes;		/* number of level changes */
+} mx6q_ic_state_t;
+
+/* Driver counters not covered by nic_stats_t */
+typedef struct {
+	uint32_t	tx_defrag;		/* tx frames copied whole into a new cluster */
+	uint32_t	tx_frag_copies;	/* tx fragments copied on their own to fix alignment */
+	uint32_t	mcast_groups;		/* groups in the software multicast filter */
+	uint32_t	mcast_gaddr_shared;	/* groups sharing a GADDR hash bit with another */
+	uint32_t	mcast_probe_collisions;	/* extra software filter probes on insert */
+	uint32_t	mcast_dropped;		/* unjoined multicast dropped, needs mcast_filter */
+	uint32_t	rx_pool_copies;		/* rx frames copied as no pool buffer was free */
+	uint32_t	sim_dropped;		/* sim_mac frames dropped with the rx ring full */
+} mx6q_drv_stats_t;
+
+/* Per-queue good frame counters, only the first num_*_queues are used */
+#define MX6Q_MAX_QUEUES	3
+
+typedef struct {
+	uint64_t	frames;
+	uint64_t	bytes;
+	uint64_t	multicast;
+	uint64_t	broadcast;
+	uint64_t	cycles;			/* ClockCycles() spent, 0 unless the profile option is set */
+	uint64_t	allocs;			/* mbufs/clusters allocated, 0 unless the profile option is set */
+} mx6q_queue_counters_t;
+
+typedef struct {
+	uint32_t	num_rx_queues;
+	uint32_t	num_tx_queues;
+	mx6q_queue_counters_t	rx[MX6Q_MAX_QUEUES];
+	mx6q_queue_counters_t	tx[MX6Q_MAX_QUEUES];
+} mx6q_queue_stats_t;
+
+/* Per Tx queue shaper telemetry, only the first num_queues are used */
+typedef struct {
+	uint64_t	frames;			/* frames queued */
+	uint64_t	bytes;			/* bytes queued */
+	uint64_t	blocked_ns;		/* time the ring was full, i.e. waiting on credit */
+	uint32_t	drops;			/* frames dropped as the ring was full */
+	uint32_t	inuse;			/* descriptors in use now */
+	uint32_t	hwm;			/* descriptors in use high water mark */
+	uint32_t	idle_slope;		/* programmed idle slope, 0 if not shaped */
+} mx6q_txq_telemetry_t;
+
+typedef struct {
+	uint32_t	num_queues;
+	uint32_t	num_descriptors;	/* per queue */
+	mx6q_txq_telemetry_t	q[MX6Q_MAX_QUEUES];
+} mx6q_tx_telemetry_t;
+
+/* PTP timestamps captured since the last GET_PTP_TIMESTAMPS */
+#define MX6Q_PTP_TS_RX	0
+#define MX6Q_PTP_TS_TX	1
+#define MX6Q_PTP_BATCH_MAX	64
+
+typedef struct {
+	uint8_t		dir;			/* MX6Q_PTP_TS_RX or MX6Q_PTP_TS_TX */
+	uint8_t		msg_type;
+	uint16_t	sequence_id;
+	uint8_t		clock_identity[8];
+	uint16_t	sport_id;
+	uint16_t	reserved;
+	uint32_t	sec;
+	uint32_t	nsec;
+} mx6q_ptp_ts_t;
+
+typedef struct {
+	uint32_t	count;			/* entries filled in ts[] */
+	uint32_t	more;			/* 1 if more are pending, call again */
+	uint32_t	lost;			/* overwritten before they could be returned */
+	mx6q_ptp_ts_t	ts[MX6Q_PTP_BATCH_MAX];
+} mx6q_ptp_ts_batch_t;
+
+/*
+ * log2 histograms, bucket n counts values in [2^n, 2^(n+1)) with 0 and 1
+ * both in bucket 0. Only filled in with the profile option.
+ */
+#define MX6Q_HIST_BUCKETS	32
+
+typedef struct {
+	uint32_t	num_rx_queues;
+	uint32_t	num_tx_queues;
+	uint64_t	rx_irq_ns[MX6Q_MAX_QUEUES][MX6Q_HIST_BUCKETS];	/* interrupt to mx6q_receive() */
+	uint64_t	rx_ring[MX6Q_MAX_QUEUES][MX6Q_HIST_BUCKETS];	/* descriptors handled per pass */
+	uint64_t	tx_ring[MX6Q_MAX_QUEUES][MX6Q_HIST_BUCKETS];	/* descriptors in use at each reap */
+	uint64_t	tx_done_ns[MX6Q_MAX_QUEUES][MX6Q_HIST_BUCKETS];	/* queued to reaped after Tx */
+} mx6q_hist_t;
+
+/*
+ * With the avtp_ring option, 1722 frames received on avtp_queue are put in
+ * a shared memory ring instead of going up to io-pkt. Open it read only
+ * with shm_open() on the name from GET_AVTP_RING. The header is followed
+ * by the slots. The driver never waits for readers: a slot's seq is odd
+ * while it is being written and goes up by 2 for each frame, so a reader
+ * spins on head, copies the slot, and retries or counts a loss if seq
+ * moved in the meantime.
+ */
+#define MX6Q_AVTP_MAGIC		0x41565450	/* "AVTP" */
+#define MX6Q_AVTP_SLOT_DATA	1520
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	slots;			/* power of 2 */
+	uint32_t	slot_size;		/* sizeof(mx6q_avtp_slot_t) */
+	uint32_t	queue;			/* rx queue the frames come from */
+	volatile uint32_t	head;		/* frames written, next is slot head & (slots - 1) */
+	volatile uint32_t	too_big;	/* frames dropped for not fitting a slot */
+	uint32_t	reserved[10];
+} mx6q_avtp_ring_hdr_t;
+
+typedef struct {
+	volatile uint32_t	seq;
+	uint32_t	len;			/* frame length, no FCS */
+	uint32_t	sec;			/* 1588 receive time */
+	uint32_t	nsec;
+	uint8_t		data[MX6Q_AVTP_SLOT_DATA];
+} mx6q_avtp_slot_t;
+
+typedef struct {
+	char		name[32];		/* shared memory object, empty if no ring */
+	uint32_t	slots;
+	uint32_t	queue;
+	uint32_t	poll;			/* 1 if avtp_queue is busy-polled */
+	uint32_t	frames;
+	uint32_t	too_big;
+} mx6q_avtp_ring_info_t;
+
+/*
+ * Descriptors per queue. SET_RING_SIZE resizes the rings with the
+ * interface up, 0 leaves that side alone. The counts are rounded down to
+ * a multiple of 4 and clamped, read them back with GET_RING_SIZE. Fails
+ * with EBUSY if more frames are in flight than the new size can hold.
+ */
+typedef struct {
+	uint32_t	num_rx_descriptors;
+	uint32_t	num_tx_descriptors;
+} mx6q_ring_size_t;
+
 #endif
 
 #if defined(__QNXNTO__) && defined(__USESRCVERSION)
@@ -25,6 +25,8 @@
 #include "mx6q.h"
 #include <net/if_vlanvar.h>
 #include <netinet/in.h>
+#include <netinet/in_systm.h>
+#include <netinet/ip.h>
 #include <netdrvr/avb.h>
 
 #if NBPFILTER > 0
@@ -32,35 +34,176 @@
 #include <net/bpfdesc.h>
 #endif
 
-static void
-mx6q_add_pkt (mx6q_dev_t *mx6q, struct mbuf *new, int idx)
+//
+// Hand the buffer already attached to this rx descriptor back to the
+// nic. The descriptor still holds its physical address and the CPU has
+// not dirtied the buffer, so no pool_phys() lookup or flush is needed.
+//
+static inline void
+mx6q_reuse_pkt (mx6q_dev_t *mx6q, int idx)
 {
     mpc_bd_t	*bd = &mx6q->rx_bd[idx];
     uint16_t	status = RXBD_E;
-    off64_t	phys = pool_phys(new->m_data, new->m_ext.ext_page);
-
-    CACHE_FLUSH(&mx6q->cachectl, new->m_data, phys, new->m_ext.ext_size);
 
     // set wrap bit if on last rx descriptor
     if ((idx % mx6q->num_rx_descriptors) == (mx6q->num_rx_descriptors - 1)) {
 	status |= RXBD_W;
     }
 
-    // remember mbuf pointer for this rx descriptor
-    mx6q->rx_pkts[idx] = new;
-
-    // stuff rx descriptor
-    bd->buffer = (uint32_t)phys;
     bd->length = 0;
+    bd->estatus = RXBD_ESTATUS_INT;
+    bd->bdu = 0;
     bd->status = status;
 }
 
+//
+// Put a pool buffer on an rx descriptor. mx6q_rxp_get() has already done
+// any cache maintenance and the physical address is cached.
+//
+static inline void
+mx6q_add_pkt (mx6q_dev_t *mx6q, mx6q_rxbuf_t *rb, int idx)
+{
+    mpc_bd_t	*bd = &mx6q->rx_bd[idx];
+
+    // remember the buffer for this rx descriptor
+    mx6q->rx_bufs[idx] = rb;
+
+    // stuff rx descriptor
+    bd->buffer = (uint32_t)rb->phys;
+    mx6q_reuse_pkt(mx6q, idx);
+}
+
+//
+// Translate the accelerator checksum status in the last descriptor
+// of a frame into mbuf csum flags. Only untagged or single tagged
+// IPv4 is validated by the ENET, anything else is left to the stack.
+//
+static void
+mx6q_rx_csum (struct ifnet *ifp, struct mbuf *m, uint32_t estatus)
+{
+    struct ether_header	*eh;
+    struct ip		*iph;
+    int			hlen;
+
+    eh = mtod(m, struct ether_header *);
+    hlen = sizeof(struct ether_header);
+    if (ntohs(eh->ether_type) == ETHERTYPE_VLAN) {
+	if (ntohs(mtod(m, struct ether_vlan_header *)->evl_proto) !=
+	    ETHERTYPE_IP) {
+	    return;
+	}
+	hlen += ETHER_VLAN_ENCAP_LEN;
+    } else if (ntohs(eh->ether_type) != ETHERTYPE_IP) {
+	return;
+    }
+    if ((estatus & RXBD_ESTATUS_IPV6) ||
+	(m->m_len < hlen + sizeof(struct ip))) {
+	return;
+    }
+
+    if (ifp->if_capenable_rx & IFCAP_CSUM_IPv4) {
+	m->m_pkthdr.csum_flags |= M_CSUM_IPv4;
+	if (estatus & RXBD_ESTATUS_ICE) {
+	    m->m_pkthdr.csum_flags |= M_CSUM_IPv4_BAD;
+	}
+    }
+
+    /* No protocol checksum on fragments or if the IP header was bad */
+    if (estatus & (RXBD_ESTATUS_FRAG | RXBD_ESTATUS_ICE)) {
+	return;
+    }
+
+    iph = (struct ip *)(mtod(m, uint8_t *) + hlen);
+    switch (iph->ip_p) {
+    case IPPROTO_TCP:
+	if ((ifp->if_capenable_rx & IFCAP_CSUM_TCPv4) == 0) {
+	    return;
+	}
+	m->m_pkthdr.csum_flags |= M_CSUM_TCPv4;
+	break;
+    case IPPROTO_UDP:
+	if ((ifp->if_capenable_rx & IFCAP_CSUM_UDPv4) == 0) {
+	    return;
+	}
+	m->m_pkthdr.csum_flags |= M_CSUM_UDPv4;
+	break;
+    default:
+	return;
+    }
+    if (estatus & RXBD_ESTATUS_PCR) {
+	m->m_pkthdr.csum_flags |= M_CSUM_TCP_UDP_BAD;
+    }
+}
+
+//
+// Charge a pass of mx6q_receive() to the queue when profiling. Cycles
+// are per pass rather than per frame to keep ClockCycles() off the
+// per frame path.
+//
+static inline void
+mx6q_rx_profile (mx6q_dev_t *mx6q, uint8_t queue, uint64_t start,
+		 uint32_t allocs, uint32_t done)
+{
+    mx6q_qstats_t		*qs = &mx6q->rx_qstats[queue];
+
+    mx6q_qstats_begin(qs);
+    qs->cycles += ClockCycles() - start;
+    qs->allocs += allocs;
+    mx6q_qstats_end(qs);
+
+    mx6q_hist_add(mx6q->h_rx_ring[queue], done);
+}
+
+//
+// Cheap first look so only frames that could be PTP event messages pay
+// for mx6q_ptp_is_eventmsg(). Decides on the first buffer alone and
+// passes anything too short to tell.
+//
+static inline int
+mx6q_ptp_maybe_event (struct mbuf *m)
+{
+    uint8_t		*p = mtod(m, uint8_t *);
+    uint16_t		type;
+    int			hlen = ETHER_HDR_LEN;
+
+    if (m->m_len < ETHER_HDR_LEN + ETHER_VLAN_ENCAP_LEN) {
+	return 1;
+    }
+    type = (p[12] << 8) | p[13];
+    if (type == ETHERTYPE_VLAN) {
+	type = (p[16] << 8) | p[17];
+	hlen += ETHER_VLAN_ENCAP_LEN;
+    }
+    if (type == ETHERTYPE_PTP) {
+	return 1;
+    }
+    if (type != ETHERTYPE_IP) {
+	return 0;
+    }
+
+    // UDP to the event port?
+    if (m->m_len < hlen + sizeof(struct ip)) {
+	return 1;
+    }
+    p += hlen;
+    if (p[9] != IPPROTO_UDP) {
+	return 0;
+    }
+    hlen += (p[0] & 0x0f) << 2;
+    if (m->m_len < hlen + 4) {
+	return 1;
+    }
+    p = mtod(m, uint8_t *) + hlen;
+    return (((p[2] << 8) | p[3]) == PTP_UDP_PORT);
+}
+
 int
 mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 {
-    struct mbuf			*new;
+    struct mbuf			*m;
+    mx6q_rxbuf_t		*rb, *new;
     ptpv2hdr_t			*ph;
-    uint32_t			this_idx, offset, len;
+    uint32_t			this_idx, offset, blen, estatus;
     uint16_t			status;
     mpc_bd_t			*rx_bd;
     struct ifnet		*ifp = &mx6q->ecom.ec_if;
@@ -68,15 +211,37 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
     struct ether_vlan_header	*vlan_hdr;
     const struct sigevent	*evp;
     uint8_t			*dptr;
+    uint32_t			done = 0;
+    mx6q_qstats_t		*qs;
+    int				rc = MX6Q_RX_DONE;
+    uint64_t			start = 0;
+    uint32_t			allocs = 0;
 
 
     // probe phy optimization - rx pkt activity
     mx6q->rxd_pkts = 1;
 
+    if (mx6q->profile) {
+	start = ClockCycles();
+	// first pass since the interrupt?
+	if (mx6q->rx_irq_stamp[queue] != 0) {
+	    mx6q_hist_add(mx6q->h_rx_irq[queue],
+			  ((start - mx6q->rx_irq_stamp[queue]) *
+			   mx6q->ns_per_kcycle) / 1000);
+	    mx6q->rx_irq_stamp[queue] = 0;
+	}
+    }
+
     offset = queue * mx6q->num_rx_descriptors;
 
     for(;;) {
 
+	// leave the rest for the next pass so other queues get a look in
+	if (mx6q->rx_budget && (done == mx6q->rx_budget)) {
+	    rc = MX6Q_RX_MORE;
+	    break;
+	}
+
 	if (mx6q->cfg.verbose > 5) {
 	    log(LOG_ERR, "%s(): rx_cidx %d queue %d",
 		__FUNCTION__, mx6q->rx_cidx[queue], queue);
@@ -89,20 +254,19 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 	if (status & RXBD_E) {
 	    break;
 	}
+	/* Grab before the descriptor gets rearmed */
+	estatus		= rx_bd->estatus;
+	done++;
 
 	// update rx descriptor consumer index for next loop iteration
 	mx6q->rx_cidx[queue] = NEXT_RX(this_idx);
-	if (mx6q->rx_cidx[queue] == 0) {
-	    mx6q_update_stats(mx6q);
-	}
 
 	// any problems with this rxd packet?
 	if (status & RXBD_ERR) {
 	    // give old packet back to nic
-	    mx6q_add_pkt(mx6q, mx6q->rx_pkts[offset + this_idx],
-			 offset + this_idx);
+	    mx6q_reuse_pkt(mx6q, offset + this_idx);
 	    log(LOG_ERR, "%s(): status RXBD_ERR 0x%X", __FUNCTION__, status);
-	    ifp->if_ierrors++;
+	    MX6Q_RX_COUNT(ifp->if_ierrors);
 	    if (mx6q->rpkt[queue] != NULL) {
 		/* Half way through a packet, discard it all */
 		m_freem(mx6q->rpkt[queue]);
@@ -112,15 +276,54 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 	    continue;
 	}
 
-	// get an empty mbuf
-	new = m_getcl_wtp(M_DONTWAIT, MT_DATA, M_PKTHDR, wtp);
-	if (new == NULL) {
-	    // give old mbuf back to nic
-	    mx6q_add_pkt(mx6q, mx6q->rx_pkts[offset + this_idx],
-			 offset + this_idx);
+	/*
+	 * The last descriptor has the length of the whole frame, only
+	 * what is past the earlier buffers is in this one.
+	 */
+	blen = rx_bd->length;
+	if (status & RXBD_L) {
+	    blen -= mx6q->length[queue];
+	}
+
+	rb = mx6q->rx_bufs[offset + this_idx];
+	CACHE_INVAL(&mx6q->cachectl, rb->buf, rb->phys, blen);
+
+	/*
+	 * Small single descriptor frames get copied into a plain mbuf
+	 * and the buffer goes straight back to the nic. Anything else
+	 * goes up in the buffer itself, lent from the queue's pool, and
+	 * a free one from the pool takes its place on the descriptor.
+	 */
+	m = NULL;
+	if ((status & RXBD_L) && (mx6q->rpkt[queue] == NULL) &&
+	    (blen <= mx6q->rx_copybreak)) {
+	    m = m_gethdr(M_DONTWAIT, MT_DATA);
+	} else if ((new = mx6q_rxp_get(mx6q->rxp[queue])) != NULL) {
+	    m = mx6q_rxp_lend(rb, blen, (mx6q->rpkt[queue] == NULL), wtp);
+	    if (m != NULL) {
+		// modifies what rx_bd points to!!
+		mx6q_add_pkt(mx6q, new, offset + this_idx);
+		rb = NULL;
+	    } else {
+		mx6q_rxp_put(new);
+	    }
+	} else {
+	    /*
+	     * The stack is sitting on all the spare buffers, copy so
+	     * this one can stay on the ring.
+	     */
+	    m = m_getcl_wtp(M_DONTWAIT, MT_DATA,
+			    (mx6q->rpkt[queue] == NULL) ? M_PKTHDR : 0, wtp);
+	    if (m != NULL) {
+		mx6q->rx_pool_copies[queue]++;
+	    }
+	}
+	if (m == NULL) {
+	    // give old buffer back to nic
+	    mx6q_reuse_pkt(mx6q, offset + this_idx);
 	    log(LOG_ERR, "%s(): mbuf alloc failed!", __FUNCTION__);
-	    mx6q->stats.rx_failed_allocs++;
-	    ifp->if_ierrors++;
+	    MX6Q_RX_COUNT(mx6q->stats.rx_failed_allocs);
+	    MX6Q_RX_COUNT(ifp->if_ierrors);
 	    if (mx6q->rpkt[queue] != NULL) {
 		/* Half way through a packet, discard it all */
 		m_freem(mx6q->rpkt[queue]);
@@ -129,74 +332,90 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 	    }
 	    continue;
 	}
+	allocs++;
+	if (rb != NULL) {
+	    // copied, the buffer stays on the descriptor
+	    memcpy(mtod(m, uint8_t *), rb->buf, blen);
+	    m->m_len = blen;
+	    mx6q_reuse_pkt(mx6q, offset + this_idx);
+	}
 
-	CACHE_INVAL(&mx6q->cachectl, mx6q->rx_pkts[offset + this_idx]->m_data,
-		    rx_bd->buffer,
-		    mx6q->rx_pkts[offset + this_idx]->m_ext.ext_size);
-
-	// pull rxd packet out of corresponding queue
 	if (mx6q->rpkt[queue] == NULL) {
-	    mx6q->rpkt[queue] = mx6q->rx_pkts[offset + this_idx];
-	    mx6q->rpkt_tail[queue] = mx6q->rpkt[queue];
+	    mx6q->rpkt[queue] = mx6q->rpkt_tail[queue] = m;
 	} else {
-	    mx6q->rpkt_tail[queue]->m_next = mx6q->rx_pkts[offset + this_idx];
-	    mx6q->rpkt_tail[queue] = mx6q->rpkt_tail[queue]->m_next;
+	    mx6q->rpkt_tail[queue]->m_next = m;
+	    mx6q->rpkt_tail[queue] = m;
 	}
-	mx6q->rx_pkts[offset + this_idx] = NULL;
-
-	/* If last then this length gets fixed later */
-	mx6q->rpkt_tail[queue]->m_len = rx_bd->length;
 
 	// dump frag if user requested it with verbose=8
 	if (mx6q->cfg.verbose > 7) {
-	    len = mx6q->rpkt_tail[queue]->m_len;
-	    if (status & RXBD_L) {
-		len -= mx6q->length[queue];
-	    }
-
 	    log(LOG_ERR,"Rxd dev_idx %d bytes %d\n",
-		mx6q->cfg.device_index, len);
-	    dump_mbuf(mx6q->rpkt_tail[queue], min(len,80));
+		mx6q->cfg.device_index, blen);
+	    dump_mbuf(m, min(blen,80));
 	}
 
-	// give new mbuf to nic - modifies what rx_bd points to!!
-	mx6q_add_pkt(mx6q, new, offset + this_idx);
-
 	if (status & RXBD_L) {
 	    mx6q->rpkt[queue]->m_pkthdr.rcvif = ifp;
-	    /* Fix the lengths */
-	    mx6q->rpkt[queue]->m_pkthdr.len = mx6q->rpkt_tail[queue]->m_len;
-	    mx6q->rpkt_tail[queue]->m_len -= mx6q->length[queue];
+	    mx6q->rpkt[queue]->m_pkthdr.len = mx6q->length[queue] + blen;
 	    mx6q->rpkt[queue]->m_flags |= M_HASFCS;
 
+	    /* Drop multicast nobody joined that got through the GADDR hash */
+	    dptr = mtod(mx6q->rpkt[queue], uint8_t *);
+	    if (mx6q->mcf_enable && ETHER_IS_MULTICAST(dptr) &&
+		((ifp->if_flags & IFF_PROMISC) == 0) &&
+		!mx6q_mcf_match(mx6q, dptr) &&
+		(memcmp(dptr, etherbroadcastaddr, ETHER_ADDR_LEN) != 0)) {
+		mx6q->mcf_dropped[queue]++;
+		m_freem(mx6q->rpkt[queue]);
+		mx6q->rpkt[queue] = mx6q->rpkt_tail[queue] = NULL;
+		mx6q->length[queue] = 0;
+		continue;
+	    }
+
+	    if (ifp->if_capenable_rx &
+		(IFCAP_CSUM_IPv4 | IFCAP_CSUM_TCPv4 | IFCAP_CSUM_UDPv4)) {
+		mx6q_rx_csum(ifp, mx6q->rpkt[queue], estatus);
+	    }
+
 #if NBPFILTER > 0
 	    /* Pass this up to any BPF listeners. */
 	    if (ifp->if_bpf) {
 	      bpf_mtap(ifp->if_bpf, mx6q->rpkt[queue]);
 	    }
 #endif
-	    if (mx6q_ptp_is_eventmsg(mx6q->rpkt[queue], &ph)) {
-		mx6q_ptp_add_rx_timestamp(mx6q, ph, rx_bd);
+	    if (mx6q->ptp_active &&
+		mx6q_ptp_maybe_event(mx6q->rpkt[queue]) &&
+		mx6q_ptp_is_eventmsg(mx6q->rpkt[queue], &ph)) {
+		mx6q_ptp_add_rx_timestamp(mx6q, ph, rx_bd, queue);
 	    }
 
 	    /* Do the stats, can't use RMON stats as before MAC filter */
-	    ifp->if_ipackets++;
-	    mx6q->stats.octets_rxed_ok += mx6q->rpkt[queue]->m_pkthdr.len;
-	    mx6q->stats.rxed_ok++;
+	    MX6Q_RX_COUNT(ifp->if_ipackets);
+	    qs = &mx6q->rx_qstats[queue];
+	    mx6q_qstats_begin(qs);
+	    qs->bytes += mx6q->rpkt[queue]->m_pkthdr.len;
+	    qs->frames++;
 	    dptr = mtod (mx6q->rpkt[queue], uint8_t *);
 	    if (ETHER_IS_MULTICAST(dptr)) {
 		if (memcmp(dptr, etherbroadcastaddr, ETHER_ADDR_LEN) == 0) {
-		    mx6q->stats.rxed_broadcast++;
+		    qs->broadcast++;
 		} else {
-		    mx6q->stats.rxed_multicast++;
+		    qs->multicast++;
 		}
 	    }
+	    mx6q_qstats_end(qs);
 
 	    vlan_hdr = mtod(mx6q->rpkt[queue], struct ether_vlan_header*);
 	    if ((ntohs(vlan_hdr->evl_encap_proto) == ETHERTYPE_VLAN) &&
 		(ntohs(vlan_hdr->evl_proto) == ETHERTYPE_1722)) {
-		/* 1722 packet, send it straight up for minimum latency */
-		(*ifp->if_input)(ifp, mx6q->rpkt[queue]);
+		if ((mx6q->avtp_ring != NULL) && (queue == mx6q->avtp_queue)) {
+		    /* Into the shared memory ring, io-pkt never sees it */
+		    mx6q_avtp_put(mx6q, mx6q->rpkt[queue], rx_bd);
+		    m_freem(mx6q->rpkt[queue]);
+		} else {
+		    /* 1722 packet, send it straight up for minimum latency */
+		    (*ifp->if_input)(ifp, mx6q->rpkt[queue]);
+		}
 
 		/* Reset for the next packet */
 		mx6q->rpkt[queue] = mx6q->rpkt_tail[queue] = NULL;
@@ -209,8 +428,8 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 		pthread_mutex_lock(&mx6q->rx_mutex);
 		if (IF_QFULL(&mx6q->rx_queue)) {
 		    m_freem(mx6q->rpkt[queue]);
-		    ifp->if_ierrors++;
-		    mx6q->stats.rx_failed_allocs++;
+		    MX6Q_RX_COUNT(ifp->if_ierrors);
+		    MX6Q_RX_COUNT(mx6q->stats.rx_failed_allocs);
 		} else {
 		    IF_ENQUEUE(&mx6q->rx_queue, mx6q->rpkt[queue]);
 		    if (!mx6q->rx_running) {
@@ -234,14 +453,17 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 		     (mx6q->rx_queue.ifq_maxlen - 1))) {
 		    /*
 		     * Flow control is enabled and we are about to overflow
-		     * the queue. Stop receiving and return 0 so the interrupt
-		     * isn't enabled until the queue is drained. This will
-		     * force the RxFIFO to fill and the MAC to send a pause
+		     * the queue. Stop receiving and return MX6Q_RX_STALL so the
+		     * interrupt isn't enabled until the queue is drained. This
+		     * will force the RxFIFO to fill and the MAC to send a pause
 		     * frame.
 		     */
 		    mx6q->rx_full |= 1 << queue;
 		    pthread_mutex_unlock(&mx6q->rx_mutex);
-		    return 0;
+		    if (mx6q->profile) {
+			mx6q_rx_profile(mx6q, queue, start, allocs, done);
+		    }
+		    return MX6Q_RX_STALL;
 		}
 		pthread_mutex_unlock(&mx6q->rx_mutex);
 	    }
@@ -269,8 +491,58 @@ mx6q_receive (mx6q_dev_t *mx6q, struct nw_work_thread *wtp, uint8_t queue)
 	}
     }
     InterruptUnlock(&mx6q->spinlock);
-    return 1;
+    if (mx6q->profile) {
+	mx6q_rx_profile(mx6q, queue, start, allocs, done);
+    }
+    return rc;
+}
+
+#ifdef MX6XSLX
+//
+// Program the Rx class match from rxq_pcp[]. The ENET classifier only
+// looks at the VLAN priority, with up to four priorities per class.
+// Anything unmatched lands on queue 0.
+//
+void
+mx6q_set_rx_class (mx6q_dev_t *mx6q)
+{
+    volatile uint32_t	*base = mx6q->reg;
+    uint32_t		match, num, pcp, queue;
+    uint32_t		cmp[4];
+
+    for (queue = 1; queue < NUM_RX_QUEUES; queue++) {
+	num = 0;
+	for (pcp = 0; pcp < 8; pcp++) {
+	    if (mx6q->rxq_pcp[pcp] != queue) {
+		continue;
+	    }
+	    if (num == 4) {
+		log(LOG_ERR, "%s(): only 4 priorities per queue, %d ignored",
+		    __FUNCTION__, pcp);
+		continue;
+	    }
+	    cmp[num++] = pcp;
+	}
+
+	match = 0;
+	if (num != 0) {
+	    /* Fill unused compares with a duplicate */
+	    while (num < 4) {
+		cmp[num] = cmp[0];
+		num++;
+	    }
+	    match = RCV_CLS_MATCHEN |
+	      (cmp[0] << RCV_CMP0_SHIFT) | (cmp[1] << RCV_CMP1_SHIFT) |
+	      (cmp[2] << RCV_CMP2_SHIFT) | (cmp[3] << RCV_CMP3_SHIFT);
+	}
+	if (queue == 1) {
+	    *(base + MX6Q_R_CLS_MATCH1) = match;
+	} else {
+	    *(base + MX6Q_R_CLS_MATCH2) = match;
+	}
+    }
 }
+#endif
 
 #if defined(__QNXNTO__) && defined(__USESRCVERSION)
 #include <sys/srcversion.h>
@@ -0,0 +1,196 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2014, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+#include "mx6q.h"
+
+static void
+mx6q_rxp_free (mx6q_rxpool_t *pool)
+{
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool, M_DEVBUF);
+}
+
+//
+// Fill a pool with nbufs clusters, each looked up and invalidated once
+// here rather than every time it is put on a descriptor.
+//
+mx6q_rxpool_t *
+mx6q_rxp_create (mx6q_dev_t *mx6q, uint32_t nbufs)
+{
+    mx6q_rxpool_t	*pool;
+    mx6q_rxbuf_t	*rb;
+    struct mbuf		*m;
+    uint32_t		i;
+
+    pool = malloc(sizeof(*pool) + (nbufs * (sizeof(mx6q_rxbuf_t) +
+						sizeof(mx6q_rxbuf_t *))),
+		  M_DEVBUF, M_NOWAIT);
+    if (pool == NULL) {
+	log(LOG_ERR, "%s(): malloc failed", __FUNCTION__);
+	return NULL;
+    }
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pool->cachectl = &mx6q->cachectl;
+    pool->bufs = (mx6q_rxbuf_t *)(pool + 1);
+    pool->free = (mx6q_rxbuf_t **)(pool->bufs + nbufs);
+
+    for (i = 0; i < nbufs; i++) {
+	m = m_getcl(M_NOWAIT, MT_DATA, M_PKTHDR);
+	if (m == NULL) {
+	    log(LOG_ERR, "%s(): mbuf alloc failed", __FUNCTION__);
+	    mx6q_rxp_retire(pool);
+	    return NULL;
+	}
+	rb = &pool->bufs[i];
+	rb->pool = pool;
+	rb->m = m;
+	rb->buf = m->m_ext.ext_buf;
+	rb->phys = pool_phys(rb->buf, m->m_ext.ext_page);
+	rb->len = 0;
+	CACHE_INVAL(&mx6q->cachectl, rb->buf, rb->phys, m->m_ext.ext_size);
+
+	pool->free[pool->nfree++] = rb;
+	pool->nbufs++;
+    }
+
+    return pool;
+}
+
+//
+// Stop using a pool. The free clusters go now, the rest as they come
+// back from the descriptors or the stack, and the pool itself with the
+// last of them.
+//
+void
+mx6q_rxp_retire (mx6q_rxpool_t *pool)
+{
+    uint32_t		i, nfree;
+    int			last;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->dead = 1;
+    nfree = pool->nfree;
+    pool->nfree = 0;
+    pool->nbufs -= nfree;
+    last = (pool->nbufs == 0);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // Nothing goes on the free list once dead, so these are ours
+    for (i = 0; i < nfree; i++) {
+	m_freem(pool->free[i]->m);
+    }
+    if (last) {
+	mx6q_rxp_free(pool);
+    }
+}
+
+//
+// Take a buffer for an rx descriptor. If the stack had it, flush what it
+// could have touched so no dirty line gets written back over the DMA.
+//
+mx6q_rxbuf_t *
+mx6q_rxp_get (mx6q_rxpool_t *pool)
+{
+    mx6q_rxbuf_t	*rb = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->nfree != 0) {
+	rb = pool->free[--pool->nfree];
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if ((rb != NULL) && (rb->len != 0)) {
+	CACHE_FLUSH(pool->cachectl, rb->buf, rb->phys, rb->len);
+	rb->len = 0;
+    }
+    return rb;
+}
+
+void
+mx6q_rxp_put (mx6q_rxbuf_t *rb)
+{
+    mx6q_rxpool_t	*pool = rb->pool;
+    int			last;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (!pool->dead) {
+	pool->free[pool->nfree++] = rb;
+	pthread_mutex_unlock(&pool->mutex);
+	return;
+    }
+    last = (--pool->nbufs == 0);
+    pthread_mutex_unlock(&pool->mutex);
+
+    m_freem(rb->m);
+    if (last) {
+	mx6q_rxp_free(pool);
+    }
+}
+
+//
+// Called by m_free() when the stack is done with a lent buffer. As for
+// any ext_free callback the mbuf header is ours to free.
+//
+static void
+mx6q_rxp_ext_free (struct mbuf *m, caddr_t buf, size_t size, void *arg)
+{
+    mx6q_rxp_put(arg);
+
+    if (m != NULL) {
+	pool_cache_put(&mbpool_cache, m);
+    }
+}
+
+//
+// Lend the len bytes received in rb to the stack as external storage of
+// a new mbuf. The storage is read only to the stack, it is still the
+// pool's cluster.
+//
+struct mbuf *
+mx6q_rxp_lend (mx6q_rxbuf_t *rb, uint32_t len, int pkthdr,
+	       struct nw_work_thread *wtp)
+{
+    struct mbuf		*m;
+
+    if (pkthdr) {
+	m = m_gethdr_wtp(M_DONTWAIT, MT_DATA, wtp);
+    } else {
+	m = m_get(M_DONTWAIT, MT_DATA);
+    }
+    if (m == NULL) {
+	return NULL;
+    }
+
+    MEXTADD(m, rb->buf, rb->m->m_ext.ext_size, M_DEVBUF,
+	    mx6q_rxp_ext_free, rb);
+    // So pool_phys()/mbuf_phys() work on it further down, e.g. bridged Tx
+    m->m_ext.ext_page = rb->m->m_ext.ext_page;
+    m->m_len = len;
+    rb->len = len;
+
+    return m;
+}
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devnp/mx6x/rxpool.c $ $Rev$")
+#endif
@@ -0,0 +1,365 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2014, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+/*
+ * Simulated MAC for the sim_mac option. The ENET is attached and set up
+ * as usual but never enabled, and this thread does the DMA's job instead:
+ * it takes frames off each Tx ring, completes the descriptors and loops
+ * the frames back into the Rx ring of the same queue, then pulses the Rx
+ * thread as the Rx interrupt would. The driver's own Rx and Tx paths run
+ * unchanged, so they can be measured without a link partner or the wire
+ * limiting the frame rate.
+ */
+
+#include "mx6q.h"
+
+//
+// Put a looped back frame in the Rx ring, in as many descriptors as it
+// needs. The FCS is left as zeroes, as M_HASFCS only has it stripped.
+//
+static int
+mx6q_sim_rx (mx6q_dev_t *mx6q, uint8_t queue, struct mbuf *m)
+{
+    mpc_bd_t		*bd;
+    mx6q_rxbuf_t	*rb;
+    uint32_t		offset, idx, total, len, copy, done, ndesc, i;
+    uint16_t		status;
+
+    offset = queue * mx6q->num_rx_descriptors;
+    total = m->m_pkthdr.len + ETHER_CRC_LEN;
+    ndesc = (total + mx6q->rx_buf_size - 1) / mx6q->rx_buf_size;
+
+    // Room for all of it? The real MAC would overrun its FIFO.
+    idx = mx6q->sim_rx_idx[queue];
+    for (i = 0; i < ndesc; i++) {
+	if ((mx6q->rx_bd[offset + idx].status & RXBD_E) == 0) {
+	    mx6q->sim_dropped++;
+	    return 0;
+	}
+	idx = NEXT_RX(idx);
+    }
+    // The Rx thread set rx_bufs[] before handing the descriptor back
+    __sync_synchronize();
+
+    idx = mx6q->sim_rx_idx[queue];
+    for (done = 0, i = 0; i < ndesc; i++) {
+	bd = &mx6q->rx_bd[offset + idx];
+	rb = mx6q->rx_bufs[offset + idx];
+	len = min(total - done, mx6q->rx_buf_size);
+	copy = (done < m->m_pkthdr.len) ? min(len, m->m_pkthdr.len - done) : 0;
+	if (copy != 0) {
+	    m_copydata(m, done, copy, rb->buf);
+	}
+	if (copy < len) {
+	    memset(rb->buf + copy, 0, len - copy);
+	}
+	if (i == 0) {
+	    // As XCNTRL_TX_ADDR_INS would on the way out
+	    memcpy(rb->buf + ETHER_ADDR_LEN, mx6q->cfg.current_address,
+		   ETHER_ADDR_LEN);
+	}
+	// mx6q_receive() invalidates before it looks, so write it back now
+	CACHE_FLUSH(&mx6q->cachectl, rb->buf, rb->phys, len);
+
+	done += len;
+	bd->length = (i == ndesc - 1) ? total : len;
+	bd->estatus = RXBD_ESTATUS_INT;
+	idx = NEXT_RX(idx);
+    }
+    __sync_synchronize();
+
+    // Hand them over last to first, so a partial frame is never seen
+    for (i = ndesc; i-- > 0; ) {
+	idx = (mx6q->sim_rx_idx[queue] + i) % mx6q->num_rx_descriptors;
+	bd = &mx6q->rx_bd[offset + idx];
+	status = bd->status & RXBD_W;
+	if (i == ndesc - 1) {
+	    status |= RXBD_L;
+	}
+	bd->status = status;
+    }
+    mx6q->sim_rx_idx[queue] = (mx6q->sim_rx_idx[queue] + ndesc) %
+      mx6q->num_rx_descriptors;
+
+    return 1;
+}
+
+//
+// Send everything loaded on a Tx queue. The mbuf is only looked at
+// while the descriptors are still ours, mx6q_transmit_complete() frees
+// it once they aren't.
+//
+static int
+mx6q_sim_tx (mx6q_dev_t *mx6q, uint8_t queue)
+{
+    mpc_bd_t		*bd;
+    struct mbuf		*m;
+    uint32_t		offset, idx, first, last;
+    int			frames = 0, looped = 0;
+    const struct sigevent *evp;
+
+    offset = queue * mx6q->num_tx_descriptors;
+    idx = mx6q->sim_tx_idx[queue];
+    for (;;) {
+	first = idx;
+	if ((mx6q->tx_bd[offset + first].status & TXBD_R) == 0) {
+	    break;
+	}
+	// mx6q_tx() stored the mbuf before setting TXBD_R on the first
+	__sync_synchronize();
+
+	last = first;
+	while ((mx6q->tx_bd[offset + last].status & TXBD_L) == 0) {
+	    last = NEXT_TX(last);
+	}
+
+	if ((m = mx6q->tx_pkts[offset + first]) != NULL) {
+	    looped += mx6q_sim_rx(mx6q, queue, m);
+	}
+
+	// Complete them as the uDMA would, last first
+	mx6q->tx_bd[offset + last].bdu = BD_BDU;
+	for (idx = last; ; idx = PREV_TX(idx)) {
+	    bd = &mx6q->tx_bd[offset + idx];
+	    bd->status &= ~TXBD_R;
+	    if (idx == first) {
+		break;
+	    }
+	}
+	idx = NEXT_TX(last);
+	frames++;
+    }
+    mx6q->sim_tx_idx[queue] = idx;
+
+    if (looped) {
+	if (mx6q->profile) {
+	    mx6q->rx_irq_stamp[queue] = ClockCycles();
+	}
+	evp = &mx6q->isr_event[queue];
+	MsgSendPulse(evp->sigev_coid, evp->sigev_priority, evp->sigev_code,
+		     evp->sigev_value.sival_int);
+    }
+
+    return frames;
+}
+
+static void *
+mx6q_sim_thread (void *arg)
+{
+    mx6q_dev_t		*mx6q = arg;
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    struct _pulse	pulse;
+    const struct sigevent *evp;
+    uint8_t		queue;
+    int			frames;
+
+    for (;;) {
+	if (MsgReceivePulse(mx6q->sim_chid, &pulse, sizeof(pulse),
+			    NULL) != EOK) {
+	    log(LOG_ERR, "mx6 Sim: MsgReceivePulse: %s", strerror(errno));
+	    continue;
+	}
+	switch (pulse.code) {
+	case MX6Q_SIM_PULSE:
+	    break;
+	case MX6Q_QUIESCE_PULSE:
+	    quiesce_block(pulse.value.sival_int);
+	    continue;
+	default:
+	    log(LOG_ERR, "mx6 Sim: Unknown pulse %d received", pulse.code);
+	    continue;
+	}
+
+	do {
+	    // Kicks from here on need another pass
+	    mx6q->sim_kicked = 0;
+	    __sync_synchronize();
+
+	    frames = 0;
+	    pthread_mutex_lock(&mx6q->sim_mutex);
+	    if (ifp->if_flags & IFF_RUNNING) {
+		for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+		    frames += mx6q_sim_tx(mx6q, queue);
+		}
+	    }
+	    pthread_mutex_unlock(&mx6q->sim_mutex);
+
+	    // As TFINT does when mx6q_start() ran out of descriptors
+	    if (mx6q->tx_full) {
+		evp = interrupt_queue(mx6q->iopkt, &mx6q->inter);
+		if (evp != NULL) {
+		    MsgSendPulsePtr(evp->sigev_coid, evp->sigev_priority,
+				    evp->sigev_code, evp->sigev_value.sival_ptr);
+		}
+	    }
+	} while (frames != 0);
+    }
+    return NULL;
+}
+
+static void
+mx6q_sim_quiesce (void *arg, int die)
+{
+    mx6q_dev_t		*mx6q = arg;
+
+    MsgSendPulse(mx6q->sim_coid, SIGEV_PULSE_PRIO_INHERIT,
+		 MX6Q_QUIESCE_PULSE, die);
+}
+
+static int
+mx6q_sim_thread_init (void *arg)
+{
+    mx6q_dev_t		*mx6q = arg;
+    struct nw_work_thread *wtp = WTP;
+
+    pthread_setname_np(gettid(), "mx6 Sim");
+    wtp->quiesce_callout = mx6q_sim_quiesce;
+    wtp->quiesce_arg = mx6q;
+    return EOK;
+}
+
+int
+mx6q_sim_init (mx6q_dev_t *mx6q)
+{
+    int			rc;
+
+    if (!mx6q->sim_mac) {
+	return EOK;
+    }
+
+    log(LOG_INFO, "%s(): sim_mac, frames are looped back, not sent",
+	__FUNCTION__);
+
+    if ((mx6q->sim_chid = ChannelCreate(0)) == -1) {
+	rc = errno;
+	goto fail;
+    }
+    if ((mx6q->sim_coid = ConnectAttach(ND_LOCAL_NODE, 0, mx6q->sim_chid,
+					_NTO_SIDE_CHANNEL, 0)) == -1) {
+	rc = errno;
+	ChannelDestroy(mx6q->sim_chid);
+	goto fail;
+    }
+    pthread_mutex_init(&mx6q->sim_mutex, NULL);
+    if ((rc = nw_pthread_create(&mx6q->sim_tid, NULL, mx6q_sim_thread, mx6q,
+				0, mx6q_sim_thread_init, mx6q)) != EOK) {
+	pthread_mutex_destroy(&mx6q->sim_mutex);
+	ConnectDetach(mx6q->sim_coid);
+	ChannelDestroy(mx6q->sim_chid);
+	goto fail;
+    }
+    return EOK;
+
+fail:
+    log(LOG_ERR, "%s(): failed: %s", __FUNCTION__, strerror(rc));
+    mx6q->sim_mac = 0;
+    return rc;
+}
+
+void
+mx6q_sim_fini (mx6q_dev_t *mx6q)
+{
+    if (!mx6q->sim_mac) {
+	return;
+    }
+    nw_pthread_reap(mx6q->sim_tid);
+    pthread_mutex_destroy(&mx6q->sim_mutex);
+    ConnectDetach(mx6q->sim_coid);
+    ChannelDestroy(mx6q->sim_chid);
+}
+
+//
+// Pick up where the rings are, after mx6q_stop() emptied Tx or a resize
+// moved everything to the start. Only called with the thread quiesced or
+// the interface down.
+//
+void
+mx6q_sim_sync (mx6q_dev_t *mx6q)
+{
+    uint32_t		queue, offset, idx, i;
+
+    for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+	offset = queue * mx6q->num_tx_descriptors;
+	idx = mx6q->tx_cidx[queue];
+	// Sent but not reaped yet
+	while ((idx != mx6q->tx_pidx[queue]) &&
+	       ((mx6q->tx_bd[offset + idx].status & TXBD_R) == 0)) {
+	    idx = NEXT_TX(idx);
+	}
+	mx6q->sim_tx_idx[queue] = idx;
+    }
+    for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+	offset = queue * mx6q->num_rx_descriptors;
+	idx = mx6q->rx_cidx[queue];
+	// Received but not processed yet
+	for (i = 0; i < mx6q->num_rx_descriptors; i++) {
+	    if (mx6q->rx_bd[offset + idx].status & RXBD_E) {
+		break;
+	    }
+	    idx = NEXT_RX(idx);
+	}
+	mx6q->sim_rx_idx[queue] = idx;
+    }
+}
+
+//
+// Bring the simulated link up, there is no PHY to wait for.
+//
+void
+mx6q_sim_start (mx6q_dev_t *mx6q)
+{
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+
+    mx6q_sim_sync(mx6q);
+    mx6q->cfg.media_rate = 1000 * 1000;
+    mx6q->cfg.duplex = 1;
+    mx6q->cfg.flags &= ~NIC_FLAG_LINK_DOWN;
+    if_link_state_change(ifp, LINK_STATE_UP);
+}
+
+//
+// mx6q_stop() has cleared IFF_RUNNING, wait out any pass that started
+// before so it can clean the Tx ring.
+//
+void
+mx6q_sim_stop (mx6q_dev_t *mx6q)
+{
+    pthread_mutex_lock(&mx6q->sim_mutex);
+    pthread_mutex_unlock(&mx6q->sim_mutex);
+}
+
+//
+// Stands in for writing X_DES_ACTIVE. Only one pulse is outstanding at
+// a time however often Tx kicks.
+//
+void
+mx6q_sim_kick (mx6q_dev_t *mx6q)
+{
+    if (__sync_lock_test_and_set(&mx6q->sim_kicked, 1) == 0) {
+	MsgSendPulse(mx6q->sim_coid, SIGEV_PULSE_PRIO_INHERIT,
+		     MX6Q_SIM_PULSE, 0);
+    }
+}
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL: http://svn.ott.qnx.com/product/branches/7.0.0/trunk/hardware/devnp/mx6x/sim.c $ $Rev$")
+#endif
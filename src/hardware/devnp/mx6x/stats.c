@@ -42,30 +42,13 @@ do_stat32 (volatile uint32_t *addr, uint32_t *new, uint32_t *old)
     }
 }
 
-static inline void
-do_stat64 (volatile uint32_t *addr, uint64_t *new, uint64_t *old)
-{
-    uint32_t value;
-
-    value = *addr;
-
-    if (value == *old) {
-	// Do nothing
-    }
-    else if (value > *old) {
-	*new += value - *old;
-	*old = value;
-    } else {
-	// 32bit hardware counter has wrapped
-	*new += ((1LL << 32LL) - *old) + value;
-	*old = value;
-    }
-}
-
 //
-// called from devctl or mx6q_process_interrupt() 
+// called from devctl or the stats callout
 //
-// read the nic hardware mib registers into our data struct
+// read the nic hardware mib registers into our data struct. Only the
+// error counters are taken from here, good frame counts come from the
+// per-queue software counters which don't need the 16bit hardware
+// counters to be read before they wrap.
 //
 void    
 mx6q_update_stats (mx6q_dev_t *mx6q)
@@ -74,14 +57,6 @@ mx6q_update_stats (mx6q_dev_t *mx6q)
 	nic_ethernet_stats_t		*estats = &mx6q->stats.un.estats;
 	nic_ethernet_stats_t		*old_estats = &mx6q->old_stats.un.estats;
 
-	do_stat64(base + MX6Q_IEEE_T_OCTETS_OK, &mx6q->stats.octets_txed_ok,
-		  &mx6q->old_stats.octets_txed_ok);
-	do_stat32(base + MX6Q_IEEE_T_FRAME_OK, &mx6q->stats.txed_ok,
-		  &mx6q->old_stats.txed_ok);
-	do_stat32(base + MX6Q_RMON_T_MC_PKT, &mx6q->stats.txed_multicast,
-		  &mx6q->old_stats.txed_multicast);
-	do_stat32(base + MX6Q_RMON_T_BC_PKT, &mx6q->stats.txed_broadcast,
-		  &mx6q->old_stats.txed_broadcast);
 	do_stat32(base + MX6Q_IEEE_T_1COL, &estats->single_collisions,
 		  &old_estats->single_collisions);
 	do_stat32(base + MX6Q_IEEE_T_MCOL, &estats->multi_collisions,
@@ -108,6 +83,75 @@ mx6q_update_stats (mx6q_dev_t *mx6q)
 		  &old_estats->short_packets);
 }
 
+//
+// periodic MIB harvest, runs from the stack so stays off the Rx path
+//
+void
+mx6q_stats_callout (void *arg)
+{
+	mx6q_dev_t			*mx6q = arg;
+
+	mx6q_update_stats(mx6q);
+
+	/* Stop Rx timestamping once PTP clients have gone quiet */
+	if (mx6q->ptp_active) {
+		mx6q->ptp_active--;
+	}
+
+	callout_msec(&mx6q->stats_callout, MX6Q_STATS_INTERVAL,
+		     mx6q_stats_callout, mx6q);
+}
+
+//
+// take a consistent copy of one queue's counters
+//
+void
+mx6q_qstats_snap (mx6q_qstats_t *qs, mx6q_qstats_t *snap)
+{
+	uint32_t			seq;
+
+	do {
+		seq = qs->seq;
+		__sync_synchronize();
+		snap->frames = qs->frames;
+		snap->bytes = qs->bytes;
+		snap->multicast = qs->multicast;
+		snap->broadcast = qs->broadcast;
+		snap->cycles = qs->cycles;
+		snap->allocs = qs->allocs;
+		__sync_synchronize();
+	} while ((seq & 1) || (seq != qs->seq));
+	snap->seq = seq;
+}
+
+//
+// fresh MIB read plus the sum of all the queue counters
+//
+void
+mx6q_snapshot_stats (mx6q_dev_t *mx6q, nic_stats_t *stats)
+{
+	mx6q_qstats_t			snap;
+	int				queue;
+
+	mx6q_update_stats(mx6q);
+	memcpy(stats, &mx6q->stats, sizeof(*stats));
+
+	for (queue = 0; queue < NUM_RX_QUEUES; queue++) {
+		mx6q_qstats_snap(&mx6q->rx_qstats[queue], &snap);
+		stats->rxed_ok += snap.frames;
+		stats->octets_rxed_ok += snap.bytes;
+		stats->rxed_multicast += snap.multicast;
+		stats->rxed_broadcast += snap.broadcast;
+	}
+	for (queue = 0; queue < NUM_TX_QUEUES; queue++) {
+		mx6q_qstats_snap(&mx6q->tx_qstats[queue], &snap);
+		stats->txed_ok += snap.frames;
+		stats->octets_txed_ok += snap.bytes;
+		stats->txed_multicast += snap.multicast;
+		stats->txed_broadcast += snap.broadcast;
+	}
+}
+
 //
 // called from mx6q_init()
 //
@@ -120,6 +164,8 @@ mx6q_clear_stats (mx6q_dev_t *mx6q)
 
     // now clear counters in our data structure
     memset(&mx6q->stats, 0, sizeof(mx6q->stats));
+    memset(mx6q->rx_qstats, 0, sizeof(mx6q->rx_qstats));
+    memset(mx6q->tx_qstats, 0, sizeof(mx6q->tx_qstats));
 
     // reset stats stuff for devctl
     mx6q->stats.revision = NIC_STATS_REVISION;
@@ -30,7 +30,8 @@
 
 //
 // this function is called only if the packet is ridiculously
-// fragmented.  If we are lucky, the entire packet will fit into
+// fragmented, or on the mx6q a misaligned fragment is too big for
+// mx6q_tx_align().  If we are lucky, the entire packet will fit into
 // one cluster so we manually defrag.  However, if this is a jumbo
 // packet, and io-pkt is running without large values for mclbytes
 // and pagesize, we are left with no choice but to dup the packet
@@ -79,45 +80,262 @@ mx6q_defrag(struct mbuf *m)
 
 	m_copydata(m, 0, m->m_pkthdr.len, mtod(m2, caddr_t));
 	m2->m_pkthdr.len = m2->m_len = m->m_pkthdr.len;
+	m2->m_pkthdr.csum_flags = m->m_pkthdr.csum_flags;
+	m2->m_pkthdr.csum_data = m->m_pkthdr.csum_data;
 
 	m_freem(m);
 
 	return m2;
 }
 
-int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
+//
+// Count the non-empty fragments in a chain and, on the mx6q, how many
+// of them break the 8 byte alignment rule.
+//
+static int
+mx6q_tx_count (struct mbuf *m, int *misaligned)
+{
+    int		num_frag = 0;
+
+    *misaligned = 0;
+    for (; m != NULL; m = m->m_next) {
+	if (m->m_len != 0) {
+	    num_frag++;
+#ifndef MX6XSLX
+	    if ((uintptr_t)m->m_data & 7) {
+		(*misaligned)++;
+	    }
+#endif
+	}
+    }
+    return num_frag;
+}
+
+#ifndef MX6XSLX
+//
+// The mx6q has an 8 byte alignment requirement for the tx data. Rather
+// than copying the whole frame, copy only the fragments that are out
+// of line into fresh mbufs. Anything that won't fit in a cluster is left
+// for mx6q_defrag(). Returns NULL with the chain freed on alloc failure.
+//
+static struct mbuf *
+mx6q_tx_align (mx6q_dev_t *mx6q, struct mbuf *m)
 {
+    struct mbuf		*m2, *new, **prev;
+    int			hdr;
+
+    for (prev = &m; (m2 = *prev) != NULL; prev = &(*prev)->m_next) {
+	if ((m2->m_len == 0) || (((uintptr_t)m2->m_data & 7) == 0) ||
+	    (m2->m_len > MCLBYTES)) {
+	    continue;
+	}
+
+	hdr = m2->m_flags & M_PKTHDR;
+	new = NULL;
+	if (m2->m_len <= (hdr ? MHLEN : MLEN)) {
+	    new = hdr ? m_gethdr(M_DONTWAIT, MT_DATA) :
+	      m_get(M_DONTWAIT, MT_DATA);
+	    if ((new != NULL) && (mtod(new, uintptr_t) & 7)) {
+		m_free(new);
+		new = NULL;
+	    }
+	}
+	if (new == NULL) {
+	    // clusters are on a 2k boundary and hence aligned
+	    new = m_getcl(M_DONTWAIT, MT_DATA, hdr);
+	    if (new == NULL) {
+		m_freem(m);
+		return NULL;
+	    }
+	}
+
+	if (hdr) {
+	    M_MOVE_PKTHDR(new, m2);
+	}
+	memcpy(mtod(new, uint8_t *), mtod(m2, uint8_t *), m2->m_len);
+	new->m_len = m2->m_len;
+	new->m_next = m2->m_next;
+	m2->m_next = NULL;
+	m_free(m2);
+	*prev = new;
+	mx6q->tx_frag_copies++;
+    }
+    return m;
+}
+#endif
+
+//
+// The ENET protocol checksum insertion sums the pseudo header itself
+// and adds in whatever is already in the checksum field, but the stack
+// leaves the pseudo header sum there for offload. Clear the field.
+// Returns -1 if it isn't in a writable mbuf and the caller must copy.
+//
+static int
+mx6q_tx_csum_prep (struct mbuf *m)
+{
+    struct ether_header	*eh;
     struct mbuf		*m2;
+    int			off;
+
+    if ((m->m_pkthdr.csum_flags & (M_CSUM_TCPv4 | M_CSUM_UDPv4)) == 0) {
+	return 0;
+    }
+    if (m->m_len < sizeof(struct ether_header)) {
+	return -1;
+    }
+
+    eh = mtod(m, struct ether_header *);
+    off = sizeof(struct ether_header);
+    if (ntohs(eh->ether_type) == ETHERTYPE_VLAN) {
+	off += ETHER_VLAN_ENCAP_LEN;
+    }
+    off += M_CSUM_DATA_IPv4_IPHL(m->m_pkthdr.csum_data);
+    off += M_CSUM_DATA_IPv4_OFFSET(m->m_pkthdr.csum_data);
+
+    for (m2 = m; (m2 != NULL) && (off >= m2->m_len); m2 = m2->m_next) {
+	off -= m2->m_len;
+    }
+    if ((m2 == NULL) || (off + sizeof(uint16_t) > m2->m_len) ||
+	M_READONLY(m2)) {
+	return -1;
+    }
+    memset(mtod(m2, uint8_t *) + off, 0, sizeof(uint16_t));
+    return 0;
+}
+
+uint64_t
+mx6q_tx_now (void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec2nsec(&ts);
+}
+
+//
+// Ring full / not full transitions for the telemetry. The unblocked
+// side is on every frame so only looks at the clock if it was blocked.
+//
+static inline void
+mx6q_tx_blocked (mx6q_dev_t *mx6q, uint8_t queue)
+{
+    mx6q_txq_tel_t	*tel = &mx6q->tx_tel[queue];
+
+    if (tel->blk_start == 0) {
+	tel->blk_start = mx6q_tx_now();
+    }
+}
+
+static inline void
+mx6q_tx_unblocked (mx6q_dev_t *mx6q, uint8_t queue)
+{
+    mx6q_txq_tel_t	*tel = &mx6q->tx_tel[queue];
+
+    if (tel->blk_start != 0) {
+	tel->blocked_ns += mx6q_tx_now() - tel->blk_start;
+	tel->blk_start = 0;
+    }
+}
+
+//
+// Tell the nic there are new descriptors. The descriptors are uncached
+// so this is the only barrier and MMIO write needed for however many
+// frames were loaded since the last kick.
+//
+static void
+mx6q_tx_kick (mx6q_dev_t *mx6q, uint8_t queue)
+{
     volatile uint32_t	*base = mx6q->reg;
+    struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    int			i;
+
+    if (mx6q->sim_mac) {
+	mx6q_sim_kick(mx6q);
+	return;
+    }
+
+    /* Kick the DMA if needed, taking care of ERR007885 on Solo X*/
+    __sync_synchronize();
+    InterruptLock(&mx6q->spinlock);
+    if (ifp->if_flags & IFF_RUNNING) {
+	switch(queue) {
+	case 0:
+	    for (i = 0; i < 4; i++) {
+		if (*(base + MX6Q_X_DES_ACTIVE) == 0) {
+		    *(base + MX6Q_X_DES_ACTIVE) = X_DES_ACTIVE;
+		    break;
+		}
+	    }
+	    break;
+	case 1:
+	    for (i = 0; i < 4; i++) {
+		if (*(base + MX6Q_X_DES_ACTIVE1) == 0) {
+		    *(base + MX6Q_X_DES_ACTIVE1) = X_DES_ACTIVE;
+		    break;
+		}
+	    }
+	    break;
+	case 2:
+	    for (i = 0; i < 4; i++) {
+		if (*(base + MX6Q_X_DES_ACTIVE2) == 0) {
+		    *(base + MX6Q_X_DES_ACTIVE2) = X_DES_ACTIVE;
+		    break;
+		}
+	    }
+	    break;
+	default:
+	    log(LOG_ERR, "Bad queue %d", queue);
+	    break;
+	}
+    }
+    InterruptUnlock(&mx6q->spinlock);
+}
+
+//
+// Load a frame into the tx descriptors. The caller must mx6q_tx_kick()
+// once it has loaded everything it has.
+//
+int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
+{
+    struct mbuf		*m2;
     volatile mpc_bd_t	*tx_bd = 0;
     volatile mpc_bd_t	*tx_bd_first = 0;
     uint32_t		idx, num_frag, offset, ts_needed = 0;
+    uint32_t		csum_estatus;
+    int			misaligned;
     struct ifnet	*ifp = &mx6q->ecom.ec_if;
+    mx6q_qstats_t	*qs;
+    uint8_t		*dptr;
+    uint64_t		start = 0;
+    uint32_t		copies = 0, allocs = 0;
+
+    if (mx6q->profile) {
+	start = ClockCycles();
+	copies = mx6q->tx_frag_copies;
+    }
 
-    /* count up mbuf fragments and fix alignment */
-    num_frag = 0;
-    m2 = m;
-    while (m2 != NULL) {
-	if (m2->m_len != 0) {
+    /*
+     * count up mbuf fragments and fix alignment. The mx6xslx prefers
+     * 64byte aligned for performance, but copying would just burn CPU.
+     */
+    num_frag = mx6q_tx_count(m, &misaligned);
 #ifndef MX6XSLX
-	    /*
-	     * The mx6q has an 8 byte alignment requirement for the data.
-	     * If it is unaligned then forcing a defrag will copy to the
-	     * start of a cluster. Clusters are on a 2k boundary and hence
-	     * aligned. The mx6xslx prefers 64byte aligned for performance,
-	     * but a defrag would just burn CPU anyway.
-	     */
-	    if ((unsigned int)m2->m_data & 7) {
-		num_frag += MX6Q_MAX_FRAGS + 1;
-	    } else
-#endif
-	    num_frag++;
+    if (misaligned) {
+	if ((m = mx6q_tx_align(mx6q, m)) == NULL) {
+	    log(LOG_ERR, "%s(): mx6q_tx_align() failed", __FUNCTION__);
+	    mx6q->stats.tx_failed_allocs++;
+	    ifp->if_oerrors++;
+	    return ENOMEM;
 	}
-	m2 = m2->m_next;
+	num_frag = mx6q_tx_count(m, &misaligned);
     }
+#endif
 
-    // ridiculously fragmented?
-    if (num_frag > MX6Q_MAX_FRAGS) {
+    // ridiculously fragmented or checksum field not writable?
+    if ((num_frag > MX6Q_MAX_FRAGS) || misaligned ||
+	(mx6q_tx_csum_prep(m) != 0)) {
+	mx6q->tx_defrag++;
+	allocs++;
 	if ((m2 = mx6q_defrag(m)) == NULL) {
 	    log(LOG_ERR, "%s(): mx6q_defrag() failed", __FUNCTION__);
 	    mx6q->stats.tx_failed_allocs++;
@@ -128,15 +346,15 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
 	// we have a new best friend
 	m = m2;
 
-	// must count mbuf fragments again
-	num_frag=0;
-	m2 = m;
-	while (m2 != NULL) {
-	    if (m2->m_len != 0) {
-		num_frag++;
-	    }
-	    m2 = m2->m_next;
+	if (mx6q_tx_csum_prep(m) != 0) {
+	    log(LOG_ERR, "%s(): bad checksum offload header", __FUNCTION__);
+	    ifp->if_oerrors++;
+	    m_freem(m);
+	    return EINVAL;
 	}
+
+	// must count mbuf fragments again
+	num_frag = mx6q_tx_count(m, &misaligned);
     }
 
     if (mx6q->cfg.verbose > 6) {
@@ -158,6 +376,15 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
     ts_needed = 0;
     offset = queue * mx6q->num_tx_descriptors;
 
+    // Ask the accelerator to insert any checksums the stack offloaded
+    csum_estatus = 0;
+    if (m->m_pkthdr.csum_flags & M_CSUM_IPv4) {
+	csum_estatus |= TXBD_ESTATUS_IINS;
+    }
+    if (m->m_pkthdr.csum_flags & (M_CSUM_TCPv4 | M_CSUM_UDPv4)) {
+	csum_estatus |= TXBD_ESTATUS_PINS;
+    }
+
 
     // load up descriptors
     m2 = m;
@@ -185,6 +412,7 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
 
 	tx_bd->buffer = mbuf_phys(m2);
 	tx_bd->length = m2->m_len;
+	tx_bd->estatus = (queue << 20) | TXBD_ESTATUS_INT | csum_estatus;
 	CACHE_FLUSH(&mx6q->cachectl, m2->m_data, tx_bd->buffer, tx_bd->length);
 
 	if (tx_bd_first) {
@@ -213,9 +441,6 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
 
 	// we have loaded this descriptor, onto the next
 	idx = NEXT_TX(idx);
-	if (idx == 0) {
-	    mx6q_update_stats(mx6q);
-	}
 	m2 = m2->m_next;
     }
 
@@ -226,13 +451,37 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
     }
 #endif
     ifp->if_opackets++;
+    qs = &mx6q->tx_qstats[queue];
+    mx6q_qstats_begin(qs);
+    qs->frames++;
+    qs->bytes += m->m_pkthdr.len;
+    dptr = mtod(m, uint8_t *);
+    if (ETHER_IS_MULTICAST(dptr)) {
+	if (memcmp(dptr, etherbroadcastaddr, ETHER_ADDR_LEN) == 0) {
+	    qs->broadcast++;
+	} else {
+	    qs->multicast++;
+	}
+    }
+    if (mx6q->profile) {
+	/* Each fragment copied for alignment is one allocation */
+	qs->cycles += ClockCycles() - start;
+	qs->allocs += allocs + (mx6q->tx_frag_copies - copies);
+    }
+    mx6q_qstats_end(qs);
 
     // remember the number of tx descriptors used this time
     mx6q->tx_descr_inuse[queue] += num_frag;
+    if (mx6q->tx_descr_inuse[queue] > mx6q->tx_tel[queue].hwm) {
+	mx6q->tx_tel[queue].hwm = mx6q->tx_descr_inuse[queue];
+    }
 
     // remember mbuf pointer for after tx.  For multiple descriptor
     // transmissions, middle and last descriptors have a zero mbuf ptr
     mx6q->tx_pkts[mx6q->tx_pidx[queue] + offset] = m;
+    if (mx6q->tx_stamp != NULL) {
+	mx6q->tx_stamp[mx6q->tx_pidx[queue] + offset] = start;
+    }
 
     // advance producer index to next unused descriptor,
     // using modulo macro above
@@ -269,41 +518,6 @@ int mx6q_tx (mx6q_dev_t *mx6q, struct mbuf *m, uint8_t queue)
 	}
     }
 
-    /* Kick the DMA if needed, taking care of ERR007885 on Solo X*/
-    __sync_synchronize();
-    InterruptLock(&mx6q->spinlock);
-    if (ifp->if_flags & IFF_RUNNING) {
-	switch(queue) {
-	case 0:
-	    for (idx = 0; idx < 4; idx++) {
-		if (*(base + MX6Q_X_DES_ACTIVE) == 0) {
-		    *(base + MX6Q_X_DES_ACTIVE) = X_DES_ACTIVE;
-		    break;
-		}
-	    }
-	    break;
-	case 1:
-	    for (idx = 0; idx < 4; idx++) {
-		if (*(base + MX6Q_X_DES_ACTIVE1) == 0) {
-		    *(base + MX6Q_X_DES_ACTIVE1) = X_DES_ACTIVE;
-		    break;
-		}
-	    }
-	    break;
-	case 2:
-	    for (idx = 0; idx < 4; idx++) {
-		if (*(base + MX6Q_X_DES_ACTIVE2) == 0) {
-		    *(base + MX6Q_X_DES_ACTIVE2) = X_DES_ACTIVE;
-		    break;
-		}
-	    }
-	    break;
-	default:
-	    log(LOG_ERR, "Bad queue %d", queue);
-	    break;
-	}
-    }
-    InterruptUnlock(&mx6q->spinlock);
     return EOK;
 }
 
@@ -312,7 +526,7 @@ mx6q_start(struct ifnet *ifp)
 {
     mx6q_dev_t		*mx6q = ifp->if_softc;
     struct mbuf		*m;
-    int			desc_avail;
+    int			desc_avail, loaded = 0;
 
     if (((ifp->if_flags_tx & IFF_RUNNING) == 0) || ((mx6q->cfg.flags & NIC_FLAG_LINK_DOWN) != 0)) {
 		/* Get rid of any stale traffic */
@@ -329,6 +543,10 @@ mx6q_start(struct ifnet *ifp)
 	    mx6q_transmit_complete(mx6q, 0);
 	    desc_avail = mx6q->num_tx_descriptors - mx6q->tx_descr_inuse[0];
 	    if (desc_avail <= MX6Q_MAX_FRAGS) {
+		if (loaded) {
+		    mx6q_tx_kick(mx6q, 0);
+		}
+		mx6q_tx_blocked(mx6q, 0);
 		/*
 		 * Leave IFF_OACTIVE so the stack doesn't call us again
 		 * and mark the queue as full so we can try again on a Tx
@@ -336,6 +554,10 @@ mx6q_start(struct ifnet *ifp)
 		 */
 		mx6q->tx_full = TRUE;
 		__sync_synchronize();
+		if (mx6q->sim_mac) {
+		    /* No TFINT to come, make sure the sim thread sees it */
+		    mx6q_sim_kick(mx6q);
+		}
 		NW_SIGUNLOCK_P (&ifp->if_snd_ex, mx6q->iopkt, WTP);
 		return;
 	    }
@@ -347,10 +569,18 @@ mx6q_start(struct ifnet *ifp)
 	if (m == NULL) {
 	    break;
 	}
-	mx6q_tx(mx6q, m, 0);
-
+	mx6q_tx_unblocked(mx6q, 0);
+	if (mx6q_tx(mx6q, m, 0) == EOK) {
+	    if (++loaded == MX6Q_TX_BATCH) {
+		mx6q_tx_kick(mx6q, 0);
+		loaded = 0;
+	    }
+	}
     }
 
+    if (loaded) {
+	mx6q_tx_kick(mx6q, 0);
+    }
     ifp->if_flags_tx &= ~IFF_OACTIVE;
     NW_SIGUNLOCK_P (&ifp->if_snd_ex, mx6q->iopkt, WTP);
 }
@@ -361,12 +591,13 @@ mx6q_start(struct ifnet *ifp)
 void
 mx6q_transmit_complete(mx6q_dev_t *mx6q, uint8_t queue)
 {
-    int			idx;
+    int			idx, reaped = 0;
     mpc_bd_t		*bd;
     uint16_t		status;
     uint32_t		bdu, offset;
     struct mbuf		*m;
     ptpv2hdr_t		*ph = NULL;
+    uint64_t		now = 0;
 
 
     if (mx6q->cfg.verbose > 5) {
@@ -383,8 +614,17 @@ mx6q_transmit_complete(mx6q_dev_t *mx6q, uint8_t queue)
 	mx6q->tx_reaped = 1;
     }
 
-    while (mx6q->tx_pidx[queue] != mx6q->tx_cidx[queue]) {
-	idx = mx6q->tx_cidx[queue];
+    if ((mx6q->tx_stamp != NULL) && mx6q->tx_descr_inuse[queue]) {
+	now = ClockCycles();
+	mx6q_hist_add(mx6q->h_tx_ring[queue], mx6q->tx_descr_inuse[queue]);
+    }
+
+    /*
+     * Walk a local index and only update the ring state once at the end.
+     * estatus is rewritten by mx6q_tx() so it is left alone here.
+     */
+    idx = mx6q->tx_cidx[queue];
+    while (mx6q->tx_pidx[queue] != idx) {
 	bd = &mx6q->tx_bd[idx + offset];
 
         status = bd->status;
@@ -411,20 +651,28 @@ mx6q_transmit_complete(mx6q_dev_t *mx6q, uint8_t queue)
 		mx6q_ptp_add_tx_timestamp(mx6q, ph, bd);
 	    }
 
+	    if (now != 0) {
+		mx6q_hist_add(mx6q->h_tx_done[queue],
+			      ((now - mx6q->tx_stamp[idx + offset]) *
+			       mx6q->ns_per_kcycle) / 1000);
+	    }
+
 	    m_freem(m);
 	    mx6q->tx_pkts[idx + offset] = NULL;
 	}
 
 	// leave only WRAP bit if was already set
 	bd->status = status & TXBD_W;
-	bd->estatus = (queue << 20) | TXBD_ESTATUS_INT;
 	bd->bdu = 0;
 
-	// this tx descriptor is available for use now
-	mx6q->tx_descr_inuse[queue]--;
-        mx6q->tx_cidx[queue] = NEXT_TX(idx);
+	reaped++;
+	idx = NEXT_TX(idx);
     }
 
+    // these tx descriptors are available for use now
+    mx6q->tx_descr_inuse[queue] -= reaped;
+    mx6q->tx_cidx[queue] = idx;
+
     if (mx6q->cfg.verbose > 5) {
         log(LOG_ERR, "%s(): ending: tx_pidx %d tx_cidx %d tx_descr_inuse %d",
 	    __FUNCTION__, mx6q->tx_pidx[queue], mx6q->tx_cidx[queue],
@@ -484,6 +732,8 @@ int mx6q_output (struct ifnet *ifp, struct mbuf *m,
 
 	num_free = mx6q->num_tx_descriptors - mx6q->tx_descr_inuse[queue];
 	if (num_free <= MX6Q_MAX_FRAGS) {
+	    mx6q_tx_blocked(mx6q, queue);
+	    mx6q->tx_tel[queue].drops++;
 	    m_freem(m);
 	    NW_SIGUNLOCK_P(&mx6q->ecom.ec_if.if_snd_ex, mx6q->iopkt, WTP);
 	    return ENOBUFS;
@@ -499,7 +749,11 @@ int mx6q_output (struct ifnet *ifp, struct mbuf *m,
     m->m_len += sizeof(struct ether_header);
     m->m_pkthdr.len += sizeof(struct ether_header);
 
+    mx6q_tx_unblocked(mx6q, queue);
     error = mx6q_tx(mx6q, m, queue);
+    if (error == EOK) {
+	mx6q_tx_kick(mx6q, queue);
+    }
     NW_SIGUNLOCK_P(&mx6q->ecom.ec_if.if_snd_ex, mx6q->iopkt, WTP);
     return error;
 }
@@ -531,6 +785,40 @@ static uint32_t valid_idleslope (uint32_t value)
     return value;
 }
 
+uint32_t mx6q_get_idleslope (mx6q_dev_t *mx6q, int queue)
+{
+    volatile uint32_t	*base = mx6q->reg;
+    uint32_t		cfg;
+
+    cfg = *(base + ((queue == 1) ? MX6Q_DMACFG1 : MX6Q_DMACFG2));
+    if ((cfg & DMACFG_DMA_CLASSEN) == 0) {
+	return 0;
+    }
+    return cfg & DMACFG_IDLE_SLOPE_MASK;
+}
+
+/*
+ * Change both shapers together while traffic flows. Whichever queue is
+ * losing bandwidth is written first so the pair never briefly adds up
+ * to more than the old or new reservation, and the spinlock keeps us
+ * from being preempted between the two writes.
+ */
+static void mx6q_set_idleslope (mx6q_dev_t *mx6q, uint32_t q1_idle,
+				uint32_t q2_idle)
+{
+    volatile uint32_t	*base = mx6q->reg;
+
+    InterruptLock(&mx6q->spinlock);
+    if (q1_idle < mx6q_get_idleslope(mx6q, 1)) {
+	*(base + MX6Q_DMACFG1) = DMACFG_DMA_CLASSEN | q1_idle;
+	*(base + MX6Q_DMACFG2) = DMACFG_DMA_CLASSEN | q2_idle;
+    } else {
+	*(base + MX6Q_DMACFG2) = DMACFG_DMA_CLASSEN | q2_idle;
+	*(base + MX6Q_DMACFG1) = DMACFG_DMA_CLASSEN | q1_idle;
+    }
+    InterruptUnlock(&mx6q->spinlock);
+}
+
 int mx6q_set_tx_bw (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 {
     volatile uint32_t	*base = mx6q->reg;
@@ -551,13 +839,8 @@ int mx6q_set_tx_bw (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	*(base + MX6Q_R_CNTRL) &= ~RCNTRL_FCE;
 	*(base + MX6Q_R_SECTION_EMPTY_ADDR) = 0;
 
-	/* Enable priority 2,3 to class 2, 4-7 to class 1 */
-	*(base + MX6Q_R_CLS_MATCH2) = RCV_CLS_MATCHEN |
-	  (2 << RCV_CMP0_SHIFT) | (3 << RCV_CMP1_SHIFT) |
-	  (2 << RCV_CMP2_SHIFT) | (2 << RCV_CMP3_SHIFT);
-	*(base + MX6Q_R_CLS_MATCH1) = RCV_CLS_MATCHEN |
-	  (4 << RCV_CMP0_SHIFT) | (5 << RCV_CMP1_SHIFT) |
-	  (6 << RCV_CMP2_SHIFT) | (7 << RCV_CMP3_SHIFT);
+	/* By default priority 2,3 to class 2, 4-7 to class 1 */
+	mx6q_set_rx_class(mx6q);
 
 	/* Instruct MAC to process recieved frames on class 1 and 2 */
 	InterruptLock(&mx6q->spinlock);
@@ -599,8 +882,7 @@ int mx6q_set_tx_bw (mx6q_dev_t *mx6q, struct ifdrv *ifd)
 	    "Total AVB bandwidth %dMbps exceeds 0.75 of port speed %dMbps",
 	    q1_bw + q2_bw, port_bw);
 	/* Invalid config so set shapers wide open */
-	*(base + MX6Q_DMACFG1) = DMACFG_DMA_CLASSEN | 1536;
-	*(base + MX6Q_DMACFG2) = DMACFG_DMA_CLASSEN | 1536;
+	mx6q_set_idleslope(mx6q, 1536, 1536);
 	return EINVAL;
     }
 
@@ -619,8 +901,7 @@ int mx6q_set_tx_bw (mx6q_dev_t *mx6q, struct ifdrv *ifd)
     }
 
     /* Write out to the hardware */
-    *(base + MX6Q_DMACFG1) = DMACFG_DMA_CLASSEN | q1_idle;
-    *(base + MX6Q_DMACFG2) = DMACFG_DMA_CLASSEN | q2_idle;
+    mx6q_set_idleslope(mx6q, q1_idle, q2_idle);
 
     return EOK;
 }
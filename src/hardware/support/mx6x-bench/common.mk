@@ -0,0 +1,25 @@
+ifndef QCONFIG
+QCONFIG=qconfig.mk
+endif
+include $(QCONFIG)
+include $(MKFILES_ROOT)/qmacros.mk
+
+NAME =mx6x-bench
+EXTRA_SILENT_VARIANTS+=$(SECTION)
+USEFILE=$(PROJECT_ROOT)/$(NAME).use
+
+EXTRA_INCVPATH += $(PROJECT_ROOT)/../../devnp/mx6x/public
+
+LIBS += socket
+
+include $(PROJECT_ROOT)/pinfo.mk
+
+
+#####AUTO-GENERATED by packaging script... do not checkin#####
+   INSTALL_ROOT_nto = $(PROJECT_ROOT)/../../../../install
+   USE_INSTALL_ROOT=1
+##############################################################
+
+include $(MKFILES_ROOT)/qtargets.mk
+
+-include $(PROJECT_ROOT)/roots.mk
@@ -0,0 +1,354 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2026, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+// Module Description:	Rx/Tx throughput and per frame cost benchmark for devnp-mx6x
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <inttypes.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/sockio.h>
+#include <sys/neutrino.h>
+#include <sys/syspage.h>
+#include <net/if.h>
+#include <net/bpf.h>
+#include <hw/imx6x_devnp_ioctl.h>
+
+#define BENCH_FRAME_MIN			60			// no FCS, the MAC pads and appends it
+#define BENCH_FRAME_MAX			1514
+#define BENCH_ETHERTYPE			0x88b5		// IEEE 802 local experimental
+#define BENCH_SETTLE_MS			100			// let the last Tx frames be reaped
+
+#define BENCH_MODE_TX			0
+#define BENCH_MODE_RX			1
+#define BENCH_MODE_LOOP			2			// devnp-mx6x sim_mac, tx looped back to rx
+
+typedef struct _bench {
+	int					mode;
+	const char			*ifname;
+	uint32_t			size;
+	uint32_t			rate;			// frames/s, 0 for as fast as possible
+	int					seconds;
+	uint8_t				dst[6];
+	uint16_t			type;
+	uint64_t			cps;			// ClockCycles() per second
+	uint64_t			sent;
+	uint64_t			nobufs;			// writes refused with the send queue full
+} bench_t;
+
+static uint64_t bench_ns( bench_t *bench, uint64_t cycles )
+{
+	return( ( cycles / bench->cps ) * 1000000000ULL + ( ( cycles % bench->cps ) * 1000000000ULL ) / bench->cps );
+}
+
+static int bench_qstats( int sock, const char *ifname, mx6q_queue_stats_t *qs )
+{
+	struct ifdrv	ifd;
+
+	memset( &ifd, 0, sizeof( ifd ) );
+	memset( qs, 0, sizeof( *qs ) );
+	strlcpy( ifd.ifd_name, ifname, sizeof( ifd.ifd_name ) );
+	ifd.ifd_cmd		= GET_QUEUE_STATS;
+	ifd.ifd_len		= sizeof( *qs );
+	ifd.ifd_data	= qs;
+
+	return( ioctl( sock, SIOCGDRVSPEC, &ifd ) == -1 ? errno : EOK );
+}
+
+static int bench_drvstats( int sock, const char *ifname, mx6q_drv_stats_t *ds )
+{
+	struct ifdrv	ifd;
+
+	memset( &ifd, 0, sizeof( ifd ) );
+	memset( ds, 0, sizeof( *ds ) );
+	strlcpy( ifd.ifd_name, ifname, sizeof( ifd.ifd_name ) );
+	ifd.ifd_cmd		= GET_DRV_STATS;
+	ifd.ifd_len		= sizeof( *ds );
+	ifd.ifd_data	= ds;
+
+	return( ioctl( sock, SIOCGDRVSPEC, &ifd ) == -1 ? errno : EOK );
+}
+
+static int bench_parse_mac( const char *str, uint8_t *mac )
+{
+	unsigned	b[6];
+	int			idx;
+
+	if( sscanf( str, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5] ) != 6 ) {
+		return( EINVAL );
+	}
+	for( idx = 0; idx < 6; idx++ ) {
+		if( b[idx] > 0xff ) {
+			return( EINVAL );
+		}
+		mac[idx] = b[idx];
+	}
+
+	return( EOK );
+}
+
+static int bench_tx( bench_t *bench )
+{
+	struct ifreq	ifr;
+	uint8_t			frame[BENCH_FRAME_MAX];
+	uint64_t		start;
+	uint64_t		end;
+	uint64_t		now;
+	uint64_t		due;
+	uint32_t		seq;
+	uint32_t		idx;
+	int				fd;
+
+	if( ( fd = open( "/dev/bpf", O_RDWR ) ) == -1 ) {
+		return( errno );
+	}
+
+	memset( &ifr, 0, sizeof( ifr ) );
+	strlcpy( ifr.ifr_name, bench->ifname, sizeof( ifr.ifr_name ) );
+	if( ioctl( fd, BIOCSETIF, &ifr ) == -1 ) {
+		close( fd );
+		return( errno );
+	}
+
+	// source address is left for bpf to fill in
+	memset( frame, 0, sizeof( frame ) );
+	memcpy( frame, bench->dst, 6 );
+	frame[12] = bench->type >> 8;
+	frame[13] = bench->type & 0xff;
+	for( idx = 14; idx < bench->size; idx++ ) {
+		frame[idx] = idx;
+	}
+
+	start	= ClockCycles( );
+	end		= start + bench->seconds * bench->cps;
+	for( seq = 0, due = start; ( now = ClockCycles( ) ) < end; ) {
+		if( bench->rate ) {
+			if( now < due ) {
+				continue;
+			}
+			due += bench->cps / bench->rate;
+		}
+
+		memcpy( &frame[14], &seq, sizeof( seq ) );
+		if( write( fd, frame, bench->size ) == bench->size ) {
+			bench->sent++;
+			seq++;
+		}
+		else if( errno == ENOBUFS ) {
+			bench->nobufs++;
+			sched_yield( );
+		}
+		else {
+			close( fd );
+			return( errno );
+		}
+	}
+
+	close( fd );
+
+	return( EOK );
+}
+
+static void bench_report( bench_t *bench, const char *dir, uint32_t nqueues,
+		mx6q_queue_counters_t *before, mx6q_queue_counters_t *after, uint64_t ns )
+{
+	uint64_t	frames;
+	uint64_t	bytes;
+	uint64_t	cycles;
+	uint64_t	allocs;
+	uint32_t	queue;
+	int			profiled;
+
+	for( profiled = 0, queue = 0; queue < nqueues && queue < MX6Q_MAX_QUEUES; queue++ ) {
+		frames	= after[queue].frames - before[queue].frames;
+		bytes	= after[queue].bytes - before[queue].bytes;
+		cycles	= after[queue].cycles - before[queue].cycles;
+		allocs	= after[queue].allocs - before[queue].allocs;
+		if( !frames ) {
+			continue;
+		}
+
+		printf( "  %s queue %u: %" PRIu64 " frames, %" PRIu64 " frames/s, %" PRIu64 " Mbit/s",
+			dir, queue, frames, frames * 1000000000ULL / ns, bytes * 8000ULL / ns );
+		if( cycles ) {
+			printf( ", %" PRIu64 " cycles/frame (%" PRIu64 "ns), %" PRIu64 ".%02" PRIu64 " allocs/frame",
+				cycles / frames, bench_ns( bench, cycles / frames ),
+				allocs / frames, ( allocs * 100 / frames ) % 100 );
+			profiled = 1;
+		}
+		printf( "\n" );
+	}
+
+	if( !profiled ) {
+		printf( "  %s: no cycles charged, start the driver with the profile option\n", dir );
+	}
+}
+
+static void bench_usage( const char *name )
+{
+	fprintf( stderr, "usage: %s [-m tx|rx|loop] [-s bytes] [-r frames/s] [-t seconds] [-d mac] [-e ethertype] interface\n", name );
+	exit( EXIT_FAILURE );
+}
+
+int main( int argc, char *argv[] )
+{
+	bench_t				bench;
+	mx6q_queue_stats_t	before;
+	mx6q_queue_stats_t	after;
+	mx6q_drv_stats_t	ds_before;
+	mx6q_drv_stats_t	ds_after;
+	uint64_t			start;
+	uint64_t			ns;
+	int					sock;
+	int					opt;
+	int					status;
+
+	memset( &bench, 0, sizeof( bench ) );
+	bench.mode		= BENCH_MODE_TX;
+	bench.size		= BENCH_FRAME_MIN;
+	bench.seconds	= 10;
+	bench.type		= BENCH_ETHERTYPE;
+	bench.cps		= SYSPAGE_ENTRY( qtime )->cycles_per_sec;
+	bench.dst[0]	= 0x02;			// locally administered unicast, nobody should claim it
+	bench.dst[5]	= 0x01;
+
+	while( ( opt = getopt( argc, argv, "m:s:r:t:d:e:" ) ) != -1 ) {
+		switch( opt ) {
+			case 'm':
+				if( !strcmp( optarg, "tx" ) ) {
+					bench.mode = BENCH_MODE_TX;
+				}
+				else if( !strcmp( optarg, "rx" ) ) {
+					bench.mode = BENCH_MODE_RX;
+				}
+				else if( !strcmp( optarg, "loop" ) ) {
+					bench.mode = BENCH_MODE_LOOP;
+				}
+				else {
+					bench_usage( argv[0] );
+				}
+				break;
+
+			case 's':
+				bench.size = strtoul( optarg, NULL, 0 );
+				break;
+
+			case 'r':
+				bench.rate = strtoul( optarg, NULL, 0 );
+				break;
+
+			case 't':
+				bench.seconds = strtol( optarg, NULL, 0 );
+				break;
+
+			case 'd':
+				if( bench_parse_mac( optarg, bench.dst ) != EOK ) {
+					bench_usage( argv[0] );
+				}
+				break;
+
+			case 'e':
+				bench.type = strtoul( optarg, NULL, 0 );
+				break;
+
+			default:
+				bench_usage( argv[0] );
+				break;
+		}
+	}
+
+	if( optind != argc - 1 || bench.size < BENCH_FRAME_MIN || bench.size > BENCH_FRAME_MAX || bench.seconds < 1 ) {
+		bench_usage( argv[0] );
+	}
+	bench.ifname = argv[optind];
+
+	if( ( sock = socket( AF_INET, SOCK_DGRAM, 0 ) ) == -1 ) {
+		fprintf( stderr, "%s: socket: %s\n", argv[0], strerror( errno ) );
+		return( EXIT_FAILURE );
+	}
+
+	if( ( status = bench_qstats( sock, bench.ifname, &before ) ) != EOK ) {
+		fprintf( stderr, "%s: %s: GET_QUEUE_STATS: %s\n", argv[0], bench.ifname, strerror( status ) );
+		return( EXIT_FAILURE );
+	}
+	if( bench.mode == BENCH_MODE_LOOP && ( status = bench_drvstats( sock, bench.ifname, &ds_before ) ) != EOK ) {
+		fprintf( stderr, "%s: %s: GET_DRV_STATS: %s\n", argv[0], bench.ifname, strerror( status ) );
+		return( EXIT_FAILURE );
+	}
+
+	start = ClockCycles( );
+	if( bench.mode != BENCH_MODE_RX ) {
+		if( ( status = bench_tx( &bench ) ) != EOK ) {
+			fprintf( stderr, "%s: %s: bpf: %s\n", argv[0], bench.ifname, strerror( status ) );
+			return( EXIT_FAILURE );
+		}
+		ns = bench_ns( &bench, ClockCycles( ) - start );
+		delay( BENCH_SETTLE_MS );
+	}
+	else {
+		sleep( bench.seconds );
+		ns = bench_ns( &bench, ClockCycles( ) - start );
+	}
+
+	if( ( status = bench_qstats( sock, bench.ifname, &after ) ) != EOK ) {
+		fprintf( stderr, "%s: %s: GET_QUEUE_STATS: %s\n", argv[0], bench.ifname, strerror( status ) );
+		return( EXIT_FAILURE );
+	}
+	if( bench.mode == BENCH_MODE_LOOP && ( status = bench_drvstats( sock, bench.ifname, &ds_after ) ) != EOK ) {
+		fprintf( stderr, "%s: %s: GET_DRV_STATS: %s\n", argv[0], bench.ifname, strerror( status ) );
+		return( EXIT_FAILURE );
+	}
+	close( sock );
+
+	if( bench.mode == BENCH_MODE_TX ) {
+		printf( "%s tx, %u byte frames, %" PRIu64 "ms\n", bench.ifname, bench.size, ns / 1000000 );
+		printf( "  sent %" PRIu64 ", send queue full %" PRIu64 "\n", bench.sent, bench.nobufs );
+		bench_report( &bench, "tx", after.num_tx_queues, before.tx, after.tx, ns );
+	}
+	else if( bench.mode == BENCH_MODE_LOOP ) {
+		// both ends are this driver, so both paths are charged to the one run
+		printf( "%s loop, %u byte frames, %" PRIu64 "ms\n", bench.ifname, bench.size, ns / 1000000 );
+		printf( "  sent %" PRIu64 ", send queue full %" PRIu64 ", rx ring full %u\n",
+			bench.sent, bench.nobufs, ds_after.sim_dropped - ds_before.sim_dropped );
+		bench_report( &bench, "tx", after.num_tx_queues, before.tx, after.tx, ns );
+		bench_report( &bench, "rx", after.num_rx_queues, before.rx, after.rx, ns );
+		if( after.rx[0].frames == before.rx[0].frames ) {
+			printf( "  nothing looped back, start the driver with the sim_mac option\n" );
+		}
+	}
+	else {
+		printf( "%s rx, %" PRIu64 "ms\n", bench.ifname, ns / 1000000 );
+		bench_report( &bench, "rx", after.num_rx_queues, before.rx, after.rx, ns );
+	}
+
+	return( EXIT_SUCCESS );
+}
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL$ $Rev$")
+#endif
@@ -0,0 +1,3 @@
+define PINFO
+PINFO DESCRIPTION=Rx/Tx throughput and per frame cost benchmark for devnp-mx6x
+endef
@@ -0,0 +1,403 @@
+/*
+ * $QNXLicenseC:
+ * Copyright 2026, QNX Software Systems.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You
+ * may not reproduce, modify or distribute this software except in
+ * compliance with the License. You may obtain a copy of the License
+ * at: http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OF ANY KIND, either express or implied.
+ *
+ * This file may contain contributions from others, either as
+ * contributors under the License or as licensors under other terms.
+ * Please review this entire file for other proprietary rights or license
+ * notices, as well as the QNX Development Suite License Guide at
+ * http://licensing.qnx.com/license-guide/ for other information.
+ * $
+ */
+
+// Module Description:	block device IOPS/latency benchmark for devb-sdmmc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <devctl.h>
+#include <atomic.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <sys/neutrino.h>
+#include <sys/syspage.h>
+#include <hw/dcmd_sim_sdmmc.h>
+
+#define BENCH_SECTOR_SIZE		512
+#define BENCH_THREADS_MAX		64
+
+#define BENCH_MODE_SEQ			0x01
+#define BENCH_MODE_WRITE		0x02
+
+struct _bench;
+
+typedef struct _bench_thread {
+	struct _bench	*bench;
+	pthread_t		tid;
+	unsigned		seed;
+	uint64_t		cnt;
+	uint64_t		errs;
+	uint64_t		total_ns;
+	uint64_t		min_ns;
+	uint64_t		max_ns;
+	uint32_t		bucket[SDMMC_IOS_BUCKETS];		// same buckets as DCMD_SDMMC_IO_STATS
+} bench_thread_t;
+
+typedef struct _bench {
+	int				fd;
+	int				mode;
+	uint32_t		bsize;
+	uint64_t		offset;
+	uint64_t		nblks;			// bsize blocks in the region tested
+	volatile unsigned	next;		// next sequential block
+	volatile int	stop;
+	uint64_t		cps;			// ClockCycles() per second
+} bench_t;
+
+static uint64_t bench_ns( bench_t *bench, uint64_t cycles )
+{
+	return( ( cycles / bench->cps ) * 1000000000ULL + ( ( cycles % bench->cps ) * 1000000000ULL ) / bench->cps );
+}
+
+static int bench_bucket( uint64_t ns )
+{
+	uint64_t	us;
+	int			bkt;
+
+	for( us = ( ns / 1000 ) >> 6, bkt = 0; us && bkt < SDMMC_IOS_BUCKETS - 1; us >>= 1, bkt++ ) {
+		;
+	}
+
+	return( bkt );
+}
+
+// upper bound (us) of the bucket holding the pct percentile
+static uint64_t bench_pct( uint32_t *bucket, uint64_t cnt, int pct )
+{
+	uint64_t	sum;
+	uint64_t	want;
+	int			bkt;
+
+	want = ( cnt * pct + 99 ) / 100;
+	for( sum = 0, bkt = 0; bkt < SDMMC_IOS_BUCKETS - 1; bkt++ ) {
+		if( ( sum += bucket[bkt] ) >= want ) {
+			break;
+		}
+	}
+
+	return( 64ULL << bkt );
+}
+
+static void *bench_thread( void *arg )
+{
+	bench_thread_t	*bt;
+	bench_t			*bench;
+	void			*buf;
+	uint64_t		blk;
+	uint64_t		ns;
+	uint64_t		start;
+	ssize_t			nbytes;
+
+	bt		= arg;
+	bench	= bt->bench;
+
+	if( posix_memalign( &buf, 4096, bench->bsize ) ) {
+		bt->errs++;
+		return( NULL );
+	}
+	memset( buf, 0xa5, bench->bsize );
+
+	while( !bench->stop ) {
+		if( ( bench->mode & BENCH_MODE_SEQ ) ) {
+			blk = atomic_add_value( (volatile unsigned *)&bench->next, 1 ) % bench->nblks;
+		}
+		else {
+			blk = ( ( (uint64_t)rand_r( &bt->seed ) << 31 ) | rand_r( &bt->seed ) ) % bench->nblks;
+		}
+
+		start = ClockCycles( );
+		if( ( bench->mode & BENCH_MODE_WRITE ) ) {
+			nbytes = pwrite64( bench->fd, buf, bench->bsize, bench->offset + blk * bench->bsize );
+		}
+		else {
+			nbytes = pread64( bench->fd, buf, bench->bsize, bench->offset + blk * bench->bsize );
+		}
+		ns = bench_ns( bench, ClockCycles( ) - start );
+
+		if( nbytes != bench->bsize ) {
+			bt->errs++;
+			continue;
+		}
+
+		bt->cnt++;
+		bt->total_ns += ns;
+		bt->bucket[bench_bucket( ns )]++;
+		if( ns > bt->max_ns ) {
+			bt->max_ns = ns;
+		}
+		if( bt->min_ns == 0 || ns < bt->min_ns ) {
+			bt->min_ns = ns;
+		}
+	}
+
+	free( buf );
+
+	return( NULL );
+}
+
+static void bench_print_hist( const char *name, SDMMC_IO_HIST *ioh )
+{
+	if( ioh->cnt ) {
+		printf( "  %-12s %10" PRIu64 " avg %8" PRIu64 "us max %8" PRIu64 "us p50 <%" PRIu64 "us p99 <%" PRIu64 "us\n",
+			name, ioh->cnt, ioh->total_ns / ioh->cnt / 1000, ioh->max_ns / 1000,
+			bench_pct( ioh->bucket, ioh->cnt, 50 ), bench_pct( ioh->bucket, ioh->cnt, 99 ) );
+	}
+}
+
+static void bench_print_time( const char *name, SDMMC_IO_TIME *iot )
+{
+	printf( "  %-12s %10" PRIu64 " total %8" PRIu64 "us max %8" PRIu64 "us\n",
+		name, iot->cnt, iot->total_ns / 1000, iot->max_ns / 1000 );
+}
+
+static void bench_print_stats( SDMMC_IO_STATS *ios )
+{
+	static const char	*sizes[SDMMC_IOS_SIZES] = { "<=4K", "<=16K", "<=64K", "<=256K", ">256K" };
+	char				name[16];
+	int					sc;
+
+	printf( "devb-sdmmc, partition type %d, %" PRIu64 "ms\n", ios->ptype, ios->elapsed_ns / 1000000 );
+	bench_print_hist( "queue wait", &ios->qwait );
+	if( ios->qwait.cnt ) {
+		printf( "  %-12s avg %" PRIu64 ".%02" PRIu64 " max %u\n", "queue depth",
+			ios->qdepth_sum / ios->qwait.cnt, ( ios->qdepth_sum * 100 / ios->qwait.cnt ) % 100, ios->qdepth_max );
+	}
+	for( sc = 0; sc < SDMMC_IOS_SIZES; sc++ ) {
+		snprintf( name, sizeof( name ), "read %s", sizes[sc] );
+		bench_print_hist( name, &ios->rd[sc] );
+	}
+	for( sc = 0; sc < SDMMC_IOS_SIZES; sc++ ) {
+		snprintf( name, sizeof( name ), "write %s", sizes[sc] );
+		bench_print_hist( name, &ios->wr[sc] );
+	}
+	bench_print_time( "bkops", &ios->bkops );
+	bench_print_time( "flush", &ios->flush );
+	bench_print_time( "tune", &ios->tune );
+	bench_print_time( "reset", &ios->reset );
+}
+
+static void bench_usage( const char *name )
+{
+	fprintf( stderr, "usage: %s [-m seqrd|seqwr|rndrd|rndwr] [-b bytes] [-q threads] [-t seconds] [-o offset] [-l length] [-w] [-s] device\n", name );
+	exit( EXIT_FAILURE );
+}
+
+int main( int argc, char *argv[] )
+{
+	bench_t			bench;
+	bench_thread_t	*threads;
+	bench_thread_t	sum;
+	SDMMC_IO_STATS	ios;
+	uint64_t		length;
+	uint64_t		size;
+	uint64_t		start;
+	uint64_t		elapsed;
+	int				nthreads;
+	int				seconds;
+	int				wok;
+	int				stats;
+	int				opt;
+	int				idx;
+	int				bkt;
+	int				status;
+
+	memset( &bench, 0, sizeof( bench ) );
+	bench.mode	= BENCH_MODE_SEQ;
+	bench.bsize	= 4096;
+	bench.cps	= SYSPAGE_ENTRY( qtime )->cycles_per_sec;
+	length		= 0;
+	nthreads	= 1;
+	seconds		= 10;
+	wok			= 0;
+	stats		= 0;
+
+	while( ( opt = getopt( argc, argv, "m:b:q:t:o:l:ws" ) ) != -1 ) {
+		switch( opt ) {
+			case 'm':
+				if( !strcmp( optarg, "seqrd" ) ) {
+					bench.mode = BENCH_MODE_SEQ;
+				}
+				else if( !strcmp( optarg, "seqwr" ) ) {
+					bench.mode = BENCH_MODE_SEQ | BENCH_MODE_WRITE;
+				}
+				else if( !strcmp( optarg, "rndrd" ) ) {
+					bench.mode = 0;
+				}
+				else if( !strcmp( optarg, "rndwr" ) ) {
+					bench.mode = BENCH_MODE_WRITE;
+				}
+				else {
+					bench_usage( argv[0] );
+				}
+				break;
+
+			case 'b':
+				bench.bsize = strtoul( optarg, NULL, 0 );
+				break;
+
+			case 'q':
+				nthreads = strtol( optarg, NULL, 0 );
+				break;
+
+			case 't':
+				seconds = strtol( optarg, NULL, 0 );
+				break;
+
+			case 'o':
+				bench.offset = strtoull( optarg, NULL, 0 );
+				break;
+
+			case 'l':
+				length = strtoull( optarg, NULL, 0 );
+				break;
+
+			case 'w':
+				wok = 1;
+				break;
+
+			case 's':
+				stats = 1;
+				break;
+
+			default:
+				bench_usage( argv[0] );
+				break;
+		}
+	}
+
+	if( optind != argc - 1 || !bench.bsize || ( bench.bsize % BENCH_SECTOR_SIZE ) ||
+			( bench.offset % BENCH_SECTOR_SIZE ) || nthreads < 1 || nthreads > BENCH_THREADS_MAX || seconds < 1 ) {
+		bench_usage( argv[0] );
+	}
+
+	if( ( bench.mode & BENCH_MODE_WRITE ) && !wok ) {
+		fprintf( stderr, "%s: write modes overwrite %s, use -w to allow them\n", argv[0], argv[optind] );
+		return( EXIT_FAILURE );
+	}
+
+	if( ( bench.fd = open( argv[optind], ( bench.mode & BENCH_MODE_WRITE ) ? O_RDWR : O_RDONLY ) ) == -1 ) {
+		fprintf( stderr, "%s: open %s: %s\n", argv[0], argv[optind], strerror( errno ) );
+		return( EXIT_FAILURE );
+	}
+
+	if( ( size = lseek64( bench.fd, 0, SEEK_END ) ) == (uint64_t)-1 || bench.offset >= size ) {
+		fprintf( stderr, "%s: %s: offset beyond the end of the device\n", argv[0], argv[optind] );
+		return( EXIT_FAILURE );
+	}
+
+	if( !length || length > size - bench.offset ) {
+		length = size - bench.offset;
+	}
+
+	if( ( bench.nblks = length / bench.bsize ) == 0 ) {
+		fprintf( stderr, "%s: %s: region is smaller than one request\n", argv[0], argv[optind] );
+		return( EXIT_FAILURE );
+	}
+
+	if( stats ) {
+		memset( &ios, 0, sizeof( ios ) );
+		ios.action = SDMMC_IOS_ACTION_CLR;
+		if( ( status = devctl( bench.fd, DCMD_SDMMC_IO_STATS, &ios, sizeof( ios ), NULL ) ) != EOK ) {
+			fprintf( stderr, "%s: DCMD_SDMMC_IO_STATS: %s\n", argv[0], strerror( status ) );
+			stats = 0;
+		}
+	}
+
+	if( ( threads = calloc( nthreads, sizeof( *threads ) ) ) == NULL ) {
+		fprintf( stderr, "%s: %s\n", argv[0], strerror( errno ) );
+		return( EXIT_FAILURE );
+	}
+
+	start = ClockCycles( );
+	for( idx = 0; idx < nthreads; idx++ ) {
+		threads[idx].bench	= &bench;
+		threads[idx].seed	= (unsigned)start + idx;
+		if( ( status = pthread_create( &threads[idx].tid, NULL, bench_thread, &threads[idx] ) ) != EOK ) {
+			fprintf( stderr, "%s: pthread_create: %s\n", argv[0], strerror( status ) );
+			bench.stop	= 1;
+			nthreads	= idx;
+			break;
+		}
+	}
+
+	if( !bench.stop ) {
+		sleep( seconds );
+		bench.stop = 1;
+	}
+
+	memset( &sum, 0, sizeof( sum ) );
+	for( idx = 0; idx < nthreads; idx++ ) {
+		pthread_join( threads[idx].tid, NULL );
+		sum.cnt			+= threads[idx].cnt;
+		sum.errs		+= threads[idx].errs;
+		sum.total_ns	+= threads[idx].total_ns;
+		if( threads[idx].max_ns > sum.max_ns ) {
+			sum.max_ns = threads[idx].max_ns;
+		}
+		if( threads[idx].min_ns && ( sum.min_ns == 0 || threads[idx].min_ns < sum.min_ns ) ) {
+			sum.min_ns = threads[idx].min_ns;
+		}
+		for( bkt = 0; bkt < SDMMC_IOS_BUCKETS; bkt++ ) {
+			sum.bucket[bkt] += threads[idx].bucket[bkt];
+		}
+	}
+	elapsed = bench_ns( &bench, ClockCycles( ) - start );
+
+	printf( "%s %s%s, %u bytes, %d in flight, %" PRIu64 "MB region, %" PRIu64 "ms\n", argv[optind],
+		( bench.mode & BENCH_MODE_SEQ ) ? "seq" : "rnd", ( bench.mode & BENCH_MODE_WRITE ) ? "wr" : "rd",
+		bench.bsize, nthreads, length >> 20, elapsed / 1000000 );
+
+	if( sum.cnt ) {
+		printf( "  %" PRIu64 " requests, %" PRIu64 " errors, %" PRIu64 " IOPS, %" PRIu64 " KB/s\n",
+			sum.cnt, sum.errs, sum.cnt * 1000000000ULL / elapsed, sum.cnt * bench.bsize * 1000000ULL / elapsed );
+		printf( "  latency avg %" PRIu64 "us min %" PRIu64 "us max %" PRIu64 "us p50 <%" PRIu64 "us p99 <%" PRIu64 "us\n",
+			sum.total_ns / sum.cnt / 1000, sum.min_ns / 1000, sum.max_ns / 1000,
+			bench_pct( sum.bucket, sum.cnt, 50 ), bench_pct( sum.bucket, sum.cnt, 99 ) );
+	}
+	else {
+		printf( "  no requests completed, %" PRIu64 " errors\n", sum.errs );
+	}
+
+	if( stats ) {
+		memset( &ios, 0, sizeof( ios ) );
+		ios.action = SDMMC_IOS_ACTION_GET;
+		if( ( status = devctl( bench.fd, DCMD_SDMMC_IO_STATS, &ios, sizeof( ios ), NULL ) ) == EOK ) {
+			bench_print_stats( &ios );
+		}
+		else {
+			fprintf( stderr, "%s: DCMD_SDMMC_IO_STATS: %s\n", argv[0], strerror( status ) );
+		}
+	}
+
+	free( threads );
+	close( bench.fd );
+
+	return( sum.errs ? EXIT_FAILURE : EXIT_SUCCESS );
+}
+
+#if defined(__QNXNTO__) && defined(__USESRCVERSION)
+#include <sys/srcversion.h>
+__SRCVERSION("$URL$ $Rev$")
+#endif
@@ -0,0 +1,3 @@
+define PINFO
+PINFO DESCRIPTION=Block device IOPS/latency benchmark for devb-sdmmc
+endef